@@ -0,0 +1,386 @@
+/**
+ * @file async_record_fetcher.cpp
+ * @brief Implementation of the AsyncRecordFetcher class.
+ *
+ * The io_uring path talks to the kernel directly through the io_uring_setup
+ * and io_uring_enter system calls, so no extra library is needed. It is only
+ * compiled when the kernel headers provide <linux/io_uring.h>.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "async_record_fetcher.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define ZIPCODE_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef ZIPCODE_HAVE_IO_URING
+
+/**
+ * @struct AsyncRecordFetcher::Ring
+ * @brief The mapped submission and completion queues of one io_uring.
+ */
+struct AsyncRecordFetcher::Ring {
+    int fd = -1;
+    unsigned sqEntries = 0;
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    std::vector<iovec> iovecs;  /**< One per request of the current batch. */
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) {
+            ::munmap(sqes, sqesSize);
+        }
+        if (cqRing != MAP_FAILED && cqRing != sqRing) {
+            ::munmap(cqRing, cqRingSize);
+        }
+        if (sqRing != MAP_FAILED) {
+            ::munmap(sqRing, sqRingSize);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    /**
+     * @brief Creates the ring and maps its queues.
+     * @return false if io_uring is not available (old kernel, seccomp, ...).
+     */
+    bool setup(unsigned depth) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+        if (fd < 0) {
+            return false;
+        }
+
+        sqEntries = params.sq_entries;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return false;
+        }
+        cqRing = singleMap ? sqRing
+                           : ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            return false;
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+};
+
+#else
+
+struct AsyncRecordFetcher::Ring {
+    bool setup(unsigned) { return false; }
+};
+
+#endif // ZIPCODE_HAVE_IO_URING
+
+/**
+ * @brief Creates a fetcher over a backend.
+ *
+ * io_uring is used when it is compiled in, the backend exposes a file
+ * descriptor without alignment requirements, and the ZIPCODE_IO_URING
+ * environment variable is not set to 0.
+ *
+ * @param source The backend to read from.
+ * @param queueDepth Maximum number of reads in flight through io_uring.
+ * @param threads Worker threads used when io_uring is not available.
+ */
+AsyncRecordFetcher::AsyncRecordFetcher(IoBackend& source, unsigned queueDepth, unsigned threads)
+    : backend(source), threadCount(std::max(1u, threads)), batch(nullptr), batchSize(0),
+      nextRequest(0), completedRequests(0), generation(0), stopping(false) {
+    const char* setting = std::getenv("ZIPCODE_IO_URING");
+    bool allowed = !(setting && std::strcmp(setting, "0") == 0);
+
+    if (allowed && backend.nativeHandle() >= 0 && backend.alignment() == 1) {
+        std::unique_ptr<Ring> candidate(new Ring());
+        if (candidate->setup(std::max(1u, queueDepth))) {
+            ring = std::move(candidate);
+        }
+    }
+}
+
+AsyncRecordFetcher::~AsyncRecordFetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Reads every request in the batch and waits for all of them.
+ *
+ * Batches from different threads are serialised; the reads within one
+ * batch run concurrently.
+ *
+ * @param requests The batch of reads.
+ * @param count Number of requests.
+ * @return true if every read returned at least one byte.
+ */
+bool AsyncRecordFetcher::fetch(RecordFetch* requests, size_t count) {
+    if (count == 0) {
+        return true;
+    }
+    std::lock_guard<std::mutex> serialise(fetchMutex);
+    return ring ? fetchWithRing(requests, count) : fetchWithThreads(requests, count);
+}
+
+#ifdef ZIPCODE_HAVE_IO_URING
+
+/**
+ * @brief Submits the batch through io_uring, keeping the queue full.
+ *
+ * New reads are queued as soon as completions free up submission slots,
+ * so the device sees up to queueDepth outstanding requests at all times.
+ *
+ * If io_uring_enter fails for good, the reads the kernel has not taken yet
+ * are withdrawn from the submission queue and every read it has taken is
+ * waited for, since those still point into this batch's buffers. The ring
+ * is then closed and the reads that did not complete are done by the
+ * thread pool, as are all later batches.
+ */
+bool AsyncRecordFetcher::fetchWithRing(RecordFetch* requests, size_t count) {
+    Ring& r = *ring;
+    r.iovecs.resize(count);
+
+    std::vector<char> done(count, 0);
+    size_t submitted = 0;
+    size_t completed = 0;
+    unsigned inFlight = 0;
+    unsigned unsubmitted = 0;  // Queued in the ring but not yet taken by the kernel
+    bool allRead = true;
+    bool failed = false;
+
+    auto reapCompletions = [&]() {
+        unsigned cqHead = *r.cqHead;
+        unsigned cqTail = __atomic_load_n(r.cqTail, __ATOMIC_ACQUIRE);
+        while (cqHead != cqTail) {
+            const io_uring_cqe& cqe = r.cqes[cqHead & *r.cqMask];
+            RecordFetch& request = requests[cqe.user_data];
+            request.result = cqe.res >= 0 ? cqe.res : -1;
+            allRead = allRead && cqe.res > 0;
+            done[cqe.user_data] = 1;
+            ++cqHead;
+            ++completed;
+            --inFlight;
+        }
+        __atomic_store_n(r.cqHead, cqHead, __ATOMIC_RELEASE);
+    };
+
+    while (completed < count) {
+        unsigned tail = *r.sqTail;
+        unsigned head = __atomic_load_n(r.sqHead, __ATOMIC_ACQUIRE);
+        while (submitted < count && inFlight < r.sqEntries && tail - head < r.sqEntries) {
+            RecordFetch& request = requests[submitted];
+            r.iovecs[submitted].iov_base = request.buffer;
+            r.iovecs[submitted].iov_len = request.capacity;
+
+            unsigned index = tail & *r.sqMask;
+            io_uring_sqe* sqe = &r.sqes[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = backend.nativeHandle();
+            sqe->off = request.offset;
+            sqe->addr = reinterpret_cast<uint64_t>(&r.iovecs[submitted]);
+            sqe->len = 1;
+            sqe->user_data = submitted;
+            r.sqArray[index] = index;
+
+            ++tail;
+            ++submitted;
+            ++inFlight;
+            ++unsubmitted;
+        }
+        __atomic_store_n(r.sqTail, tail, __ATOMIC_RELEASE);
+
+        int entered = static_cast<int>(::syscall(__NR_io_uring_enter, r.fd, unsubmitted, 1,
+                                                 IORING_ENTER_GETEVENTS, nullptr, 0));
+        if (entered < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+            std::cerr << "io_uring_enter failed: " << std::strerror(errno) << std::endl;
+            failed = true;
+            break;
+        }
+        unsubmitted -= static_cast<unsigned>(entered);
+        reapCompletions();
+    }
+
+    if (failed) {
+        // Withdraw the entries the kernel has not consumed; without SQPOLL it
+        // only reads them during io_uring_enter, so resetting the tail is safe
+        unsigned head = __atomic_load_n(r.sqHead, __ATOMIC_ACQUIRE);
+        inFlight -= *r.sqTail - head;
+        __atomic_store_n(r.sqTail, head, __ATOMIC_RELEASE);
+
+        // Wait for every read the kernel has taken. Completions are posted to
+        // the ring even if io_uring_enter keeps failing, so poll as a last resort.
+        while (inFlight > 0) {
+            reapCompletions();
+            if (inFlight > 0 &&
+                ::syscall(__NR_io_uring_enter, r.fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0) {
+                std::this_thread::yield();
+            }
+        }
+        ring.reset();
+
+        std::vector<RecordFetch> remaining;
+        std::vector<size_t> positions;
+        for (size_t i = 0; i < count; ++i) {
+            if (!done[i]) {
+                remaining.push_back(requests[i]);
+                positions.push_back(i);
+            }
+        }
+        if (!remaining.empty()) {
+            allRead = fetchWithThreads(remaining.data(), remaining.size()) && allRead;
+            for (size_t i = 0; i < remaining.size(); ++i) {
+                requests[positions[i]].result = remaining[i].result;
+            }
+        }
+    }
+    return allRead;
+}
+
+#else
+
+bool AsyncRecordFetcher::fetchWithRing(RecordFetch* requests, size_t count) {
+    return fetchWithThreads(requests, count);
+}
+
+#endif // ZIPCODE_HAVE_IO_URING
+
+/**
+ * @brief Spreads the batch over the worker pool, which is started on first use.
+ *
+ * The calling thread works on the batch as well.
+ */
+bool AsyncRecordFetcher::fetchWithThreads(RecordFetch* requests, size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (workers.empty()) {
+            for (unsigned i = 1; i < threadCount; ++i) {
+                workers.push_back(std::thread(&AsyncRecordFetcher::workerLoop, this));
+            }
+        }
+        batch = requests;
+        batchSize = count;
+        nextRequest = 0;
+        completedRequests = 0;
+        ++generation;
+    }
+    workReady.notify_all();
+
+    runRequests();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return completedRequests == batchSize; });
+
+    bool allRead = true;
+    for (size_t i = 0; i < count; ++i) {
+        allRead = allRead && requests[i].result > 0;
+    }
+    batch = nullptr;
+    return allRead;
+}
+
+/**
+ * @brief Body of a worker thread: waits for batches and helps complete them.
+ */
+void AsyncRecordFetcher::workerLoop() {
+    unsigned long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workReady.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        runRequests();
+    }
+}
+
+/**
+ * @brief Claims and performs requests of the current batch until none are left.
+ */
+void AsyncRecordFetcher::runRequests() {
+    for (;;) {
+        RecordFetch* request;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!batch || nextRequest >= batchSize) {
+                return;
+            }
+            request = &batch[nextRequest++];
+        }
+
+        request->result = backend.readAt(request->buffer, request->capacity, request->offset);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (++completedRequests == batchSize) {
+            workDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ * @file async_record_fetcher.h
+ * @brief Header file for the AsyncRecordFetcher class.
+ *
+ * The AsyncRecordFetcher reads many records from the data file at once.
+ * On Linux it submits the whole batch through io_uring so the device sees
+ * a deep queue; elsewhere, or when io_uring is unavailable, a small pool of
+ * worker threads issues the reads in parallel.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef ASYNC_RECORD_FETCHER_H
+#define ASYNC_RECORD_FETCHER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "io_backend.h"
+
+/**
+ * @struct RecordFetch
+ * @brief One read in a batch submitted to AsyncRecordFetcher::fetch().
+ *
+ * The caller owns the buffer. For record reads the capacity should cover
+ * the length prefix and the record body (DataFileReader::kRecordReadSize
+ * is enough for every record in the national data set).
+ */
+struct RecordFetch {
+    uint64_t offset;    /**< File offset to read from. */
+    char* buffer;       /**< Destination buffer provided by the caller. */
+    size_t capacity;    /**< Number of bytes to read into buffer. */
+    long long result;   /**< Bytes read (may be short at end of file), or -1 on error. */
+};
+
+/**
+ * @class AsyncRecordFetcher
+ * @brief Issues batches of positional reads concurrently.
+ *
+ * fetch() blocks until every request in the batch has completed, but the
+ * reads themselves are in flight together: up to the queue depth with
+ * io_uring, or one per worker with the thread-pool fallback.
+ *
+ * The io_uring path needs a backend with a file descriptor and no
+ * alignment requirement (pread or mmap); other backends always use the
+ * thread pool.
+ */
+class AsyncRecordFetcher {
+public:
+    /**
+     * @param backend The backend to read from. It must outlive the fetcher.
+     * @param queueDepth Maximum number of reads in flight through io_uring.
+     * @param threadCount Worker threads used when io_uring is not available.
+     */
+    explicit AsyncRecordFetcher(IoBackend& backend, unsigned queueDepth = 128, unsigned threadCount = 4);
+    ~AsyncRecordFetcher();
+
+    AsyncRecordFetcher(const AsyncRecordFetcher&) = delete;
+    AsyncRecordFetcher& operator=(const AsyncRecordFetcher&) = delete;
+
+    /**
+     * @brief Reads every request in the batch and waits for all of them.
+     *
+     * Each request's result field is set. Requests may complete in any order.
+     *
+     * @param requests The batch of reads.
+     * @param count Number of requests.
+     * @return true if every read returned at least one byte.
+     */
+    bool fetch(RecordFetch* requests, size_t count);
+
+    /**
+     * @brief Returns true if batches are submitted through io_uring.
+     */
+    bool usingIoUring() const { return ring != nullptr; }
+
+private:
+    struct Ring;
+
+    bool fetchWithRing(RecordFetch* requests, size_t count);
+    bool fetchWithThreads(RecordFetch* requests, size_t count);
+    void workerLoop();
+    void runRequests();
+
+    IoBackend& backend;                  /**< Source of the data. */
+    std::unique_ptr<Ring> ring;          /**< io_uring instance, or nullptr. */
+    unsigned threadCount;                /**< Size of the fallback pool. */
+
+    std::mutex fetchMutex;               /**< Serialises calls to fetch(). */
+    std::vector<std::thread> workers;    /**< Fallback pool, started on first use. */
+    std::mutex mutex;                    /**< Guards the batch state below. */
+    std::condition_variable workReady;   /**< Signals a new batch or shutdown. */
+    std::condition_variable workDone;    /**< Signals that a batch has finished. */
+    RecordFetch* batch;                  /**< Requests of the current batch. */
+    size_t batchSize;                    /**< Number of requests in the batch. */
+    size_t nextRequest;                  /**< Next request to hand out. */
+    size_t completedRequests;            /**< Requests finished so far. */
+    unsigned long long generation;       /**< Incremented for every batch. */
+    bool stopping;                       /**< Set by the destructor. */
+};
+
+#endif // ASYNC_RECORD_FETCHER_H
@@ -0,0 +1,66 @@
+/**
+ * @file batch_read_planner.cpp
+ * @brief Implementation of the BatchReadPlanner class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "batch_read_planner.h"
+#include <algorithm>
+
+BatchReadPlanner::BatchReadPlanner(size_t span, size_t gap, size_t readSize)
+    : recordSpan(span), maxGap(gap), maxReadSize(std::max(readSize, span)), totalBytes(0) {}
+
+/**
+ * @brief Plans the reads for a batch of offsets.
+ *
+ * The request indices are sorted by offset and then walked once. A read
+ * is extended to cover the next record when that record starts no more
+ * than maxGap bytes after the current read ends and the result fits in
+ * maxReadSize; otherwise a new read is started. Duplicate offsets simply
+ * share a read.
+ *
+ * @param offsets The requested record offsets, in request order.
+ * @param count Number of offsets.
+ * @param fileSize Size of the file; reads never extend past it.
+ */
+void BatchReadPlanner::plan(const uint64_t* offsets, size_t count, uint64_t fileSize) {
+    reads.clear();
+    order.resize(count);
+    totalBytes = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [offsets](size_t a, size_t b) {
+        return offsets[a] < offsets[b];
+    });
+
+    for (size_t k = 0; k < count; ++k) {
+        uint64_t start = offsets[order[k]];
+        uint64_t end = std::min<uint64_t>(start + recordSpan, fileSize);
+
+        if (!reads.empty()) {
+            PlannedRead& current = reads.back();
+            uint64_t currentEnd = current.offset + current.length;
+            if (start <= currentEnd + maxGap && end - current.offset <= maxReadSize) {
+                if (end > currentEnd) {
+                    totalBytes += end - currentEnd;
+                    current.length = static_cast<size_t>(end - current.offset);
+                }
+                ++current.entryCount;
+                continue;
+            }
+        }
+
+        PlannedRead read;
+        read.offset = start;
+        read.length = static_cast<size_t>(end > start ? end - start : 0);
+        read.firstEntry = k;
+        read.entryCount = 1;
+        reads.push_back(read);
+        totalBytes += read.length;
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * @file batch_read_planner.h
+ * @brief Header file for the BatchReadPlanner class.
+ *
+ * The BatchReadPlanner turns a batch of record offsets in arbitrary order
+ * into a short list of large reads in file order. Records that lie close
+ * together are fetched with one read, so a big batch against a cold data
+ * file behaves like a sequential scan of the parts it touches.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef BATCH_READ_PLANNER_H
+#define BATCH_READ_PLANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct PlannedRead
+ * @brief One coalesced read produced by BatchReadPlanner.
+ */
+struct PlannedRead {
+    uint64_t offset;     /**< File offset of the first byte to read. */
+    size_t length;       /**< Number of bytes to read. */
+    size_t firstEntry;   /**< Index into getOrder() of the first record covered by this read. */
+    size_t entryCount;   /**< Number of records covered by this read. */
+};
+
+/**
+ * @class BatchReadPlanner
+ * @brief Sorts, de-duplicates and coalesces record offsets into file-ordered reads.
+ *
+ * Each record is assumed to need recordSpan bytes from its offset. Two
+ * neighbouring records are read together when the gap between the end of
+ * one span and the start of the next is at most maxGap bytes, as long as
+ * the combined read stays within maxReadSize. getOrder() lists the request
+ * indices sorted by offset, so results can be scattered back into request
+ * order after the reads complete.
+ */
+class BatchReadPlanner {
+public:
+    /**
+     * @param recordSpan Bytes assumed to be needed from each record offset.
+     * @param maxGap Largest run of unrequested bytes read to join two records.
+     * @param maxReadSize Upper bound on the length of a single read.
+     */
+    explicit BatchReadPlanner(size_t recordSpan = 512, size_t maxGap = 4096, size_t maxReadSize = 1 << 20);
+
+    /**
+     * @brief Plans the reads for a batch of offsets.
+     *
+     * @param offsets The requested record offsets, in request order.
+     * @param count Number of offsets.
+     * @param fileSize Size of the file; reads never extend past it.
+     */
+    void plan(const uint64_t* offsets, size_t count, uint64_t fileSize);
+
+    /**
+     * @brief Returns the planned reads, in ascending file order.
+     */
+    const std::vector<PlannedRead>& getReads() const { return reads; }
+
+    /**
+     * @brief Returns request indices sorted by offset.
+     *
+     * Entries [read.firstEntry, read.firstEntry + read.entryCount) of this
+     * list are the requests served by a read.
+     */
+    const std::vector<size_t>& getOrder() const { return order; }
+
+    /**
+     * @brief Returns the sum of the lengths of all planned reads.
+     */
+    uint64_t getTotalBytes() const { return totalBytes; }
+
+private:
+    size_t recordSpan;            /**< Bytes assumed per record. */
+    size_t maxGap;                /**< Largest gap bridged by a read. */
+    size_t maxReadSize;           /**< Largest single read. */
+    std::vector<PlannedRead> reads; /**< Result of the last plan() call. */
+    std::vector<size_t> order;    /**< Request indices sorted by offset. */
+    uint64_t totalBytes;          /**< Sum of read lengths. */
+};
+
+#endif // BATCH_READ_PLANNER_H
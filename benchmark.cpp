@@ -0,0 +1,336 @@
+/**
+ * @file benchmark.cpp
+ * @brief Implementation of the in-memory lookup benchmark.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "benchmark.h"
+#include "compressed_index.h"
+#include "data_file_reader.h"
+#include "eytzinger_index.h"
+#include "learned_index.h"
+#include "primary_key_index.h"
+#include "zip_hash_index.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const size_t kBatchedLookups = 1000000;   // Random keys for the batched lookup comparison
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * @struct BenchmarkResult
+ * @brief Timings and memory of one structure on one key set.
+ */
+struct BenchmarkResult {
+    std::string name;
+    double buildMs;       /**< Time to build the structure from the sorted keys. */
+    double lookupNs;      /**< Average time per lookup. */
+    size_t extraBytes;    /**< Memory beyond the sorted key array (for elias-fano, its whole size). */
+    bool correct;         /**< Every lookup returned the expected position. */
+};
+
+/**
+ * @brief Reads the zip code keys of a data file, sorted and without duplicates.
+ */
+bool loadZipKeys(const std::string& dataFilename, std::vector<uint32_t>& keys) {
+    DataFileReader reader;
+    if (!reader.open(dataFilename, IoWorkload::Scan)) {
+        return false;
+    }
+    keys.reserve(reader.getRecordCount());
+    reader.forEachRecord([&keys](uint64_t, const char* data, uint32_t length) {
+        uint32_t key;
+        if (parseRecordZipKey(data, length, key)) {
+            keys.push_back(key);
+        }
+        return true;
+    });
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return true;
+}
+
+/**
+ * @brief Generates sorted synthetic keys with a density that changes in runs.
+ *
+ * Keys advance by random gaps whose upper bound is redrawn every 100,000
+ * keys, so the set is locally smooth like the zip codes but has dense and
+ * sparse regions a single straight line cannot follow.
+ */
+std::vector<uint32_t> makeSyntheticKeys(size_t count) {
+    std::mt19937_64 random(20261016);
+    std::vector<uint32_t> keys(count);
+    uint64_t key = 0;
+    uint64_t maxGap = 1;
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 100000 == 0) {
+            maxGap = 2 + random() % 800;
+        }
+        key += 1 + random() % maxGap;
+        keys[i] = static_cast<uint32_t>(std::min<uint64_t>(key, 0xFFFFFFFEu - (count - i)));
+    }
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+/**
+ * @brief Times one structure over the query list.
+ *
+ * The callables are template parameters so the timed loop calls them
+ * directly rather than through std::function.
+ *
+ * @param name Label printed in the table.
+ * @param build Builds the structure; returns its extra memory in bytes.
+ * @param lookup Maps a key to its position.
+ * @param queries Keys to look up.
+ * @param expected Position of each query key.
+ */
+template <typename Build, typename Lookup>
+BenchmarkResult measure(const std::string& name, Build build, Lookup lookup,
+                        const std::vector<uint32_t>& queries, const std::vector<size_t>& expected) {
+    BenchmarkResult result;
+    result.name = name;
+    Clock::time_point start = Clock::now();
+    result.extraBytes = build();
+    result.buildMs = millisecondsSince(start);
+
+    size_t mismatches = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < queries.size(); ++i) {
+        mismatches += lookup(queries[i]) != expected[i];
+    }
+    result.lookupNs = millisecondsSince(start) * 1e6 / std::max<size_t>(1, queries.size());
+    result.correct = mismatches == 0;
+    return result;
+}
+
+/**
+ * @brief Times single and batched searches of one structure and prints a table row.
+ *
+ * @param name Label printed in the table.
+ * @param single Maps a key to its position, one key at a time.
+ * @param batch Maps a span of keys to their positions.
+ * @param queries Keys to look up.
+ * @param expected Position of each query key.
+ */
+template <typename Single, typename Batch>
+void measureBatched(const std::string& name, Single single, Batch batch,
+                    const std::vector<uint32_t>& queries, const std::vector<size_t>& expected) {
+    size_t mismatches = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < queries.size(); ++i) {
+        mismatches += single(queries[i]) != expected[i];
+    }
+    double singleMs = millisecondsSince(start);
+
+    std::vector<size_t> positions(queries.size());
+    start = Clock::now();
+    batch(queries.data(), queries.size(), positions.data());
+    double batchMs = millisecondsSince(start);
+    mismatches += !std::equal(positions.begin(), positions.end(), expected.begin());
+
+    double lookups = static_cast<double>(queries.size());
+    std::printf("  %-20s %14.1f %14.1f %10.2fx%s\n", name.c_str(), lookups / singleMs / 1e3, lookups / batchMs / 1e3,
+                singleMs / std::max(batchMs, 1e-9), mismatches == 0 ? "" : "  WRONG RESULTS");
+}
+
+/**
+ * @brief Compares one-at-a-time searches with interleaved batches of searches.
+ *
+ * @param keys The sorted key set.
+ * @param eytzinger The key set in Eytzinger order.
+ * @param sortedPositions Position in keys of each Eytzinger layout position.
+ * @param lookups Number of random lookups.
+ */
+void benchmarkBatchedLookups(const std::vector<uint32_t>& keys, const EytzingerLayout& eytzinger,
+                             const std::vector<uint32_t>& sortedPositions, size_t lookups) {
+    std::mt19937_64 random(11);
+    std::vector<uint32_t> queries(lookups);
+    std::vector<size_t> expected(lookups);
+    for (size_t i = 0; i < lookups; ++i) {
+        expected[i] = static_cast<size_t>(random() % keys.size());
+        queries[i] = keys[expected[i]];
+    }
+
+    std::cout << "  Batched lookups: " << lookups << " random keys, " << kBatchSearchWidth
+              << " searches in flight" << std::endl;
+    std::printf("  %-20s %14s %14s %11s\n", "structure", "single Mkeys/s", "batch Mkeys/s", "speedup");
+    measureBatched("binary search",
+        [&keys](uint32_t key) { return static_cast<size_t>(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin()); },
+        [&keys](const uint32_t* batch, size_t count, size_t* positions) {
+            batchLowerBound(reinterpret_cast<const char*>(keys.data()), sizeof(uint32_t), keys.size(),
+                            batch, count, positions);
+        },
+        queries, expected);
+    measureBatched("eytzinger",
+        [&](uint32_t key) { return static_cast<size_t>(sortedPositions[eytzinger.lowerBound(key)]); },
+        [&](const uint32_t* batch, size_t count, size_t* positions) {
+            eytzinger.lowerBoundMany(batch, count, positions);
+            for (size_t i = 0; i < count; ++i) {
+                positions[i] = sortedPositions[positions[i]];
+            }
+        },
+        queries, expected);
+}
+
+/**
+ * @brief Benchmarks every structure on one key set and prints the results.
+ */
+void benchmarkKeySet(const std::string& title, const std::vector<uint32_t>& keys, size_t lookups) {
+    std::mt19937_64 random(7);
+    std::vector<uint32_t> queries(lookups);
+    std::vector<size_t> expected(lookups);
+    for (size_t i = 0; i < lookups; ++i) {
+        expected[i] = static_cast<size_t>(random() % keys.size());
+        queries[i] = keys[expected[i]];
+    }
+
+    std::vector<BenchmarkResult> results;
+    results.push_back(measure("binary search", [] { return size_t(0); },
+        [&keys](uint32_t key) { return static_cast<size_t>(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin()); },
+        queries, expected));
+
+    EytzingerLayout eytzinger;
+    std::vector<uint32_t> sortedPositions;
+    results.push_back(measure("eytzinger", [&] {
+            eytzinger.build(keys.data(), keys.size(), &sortedPositions);
+            return (keys.size() + 1) * sizeof(uint32_t);  // A copy of the keys in layout order
+        },
+        [&](uint32_t key) { return static_cast<size_t>(sortedPositions[eytzinger.lowerBound(key)]); },
+        queries, expected));
+
+    EliasFanoSequence eliasFano;
+    results.push_back(measure("elias-fano", [&] {
+            eliasFano.build(keys.data(), keys.size());
+            return eliasFano.memoryUsage();  // Replaces the key array rather than adding to it
+        },
+        [&eliasFano](uint32_t key) { return static_cast<size_t>(eliasFano.find(key)); },
+        queries, expected));
+
+    ZipHashIndex hash;
+    results.push_back(measure("hash table", [&] {
+            hash.reserve(keys.size());
+            for (size_t i = 0; i < keys.size(); ++i) {
+                hash.insert(keys[i], static_cast<uint32_t>(i));
+            }
+            return hash.memoryUsage();
+        },
+        [&hash](uint32_t key) {
+            uint32_t slot = 0;
+            hash.find(key, slot);
+            return static_cast<size_t>(slot);
+        },
+        queries, expected));
+
+    const uint32_t epsilons[] = { 8, 32, 128 };
+    for (uint32_t epsilon : epsilons) {
+        PiecewiseLinearModel model;
+        results.push_back(measure("learned (eps " + std::to_string(epsilon) + ")", [&] {
+                model.build(keys.data(), keys.size(), epsilon);
+                return model.getSegmentCount() * sizeof(LinearSegment);
+            },
+            [&](uint32_t key) { return model.lowerBound(keys.data(), keys.size(), key); },
+            queries, expected));
+    }
+
+    std::cout << title << ": " << keys.size() << " keys, " << lookups << " random lookups" << std::endl;
+    std::printf("  %-20s %10s %12s %14s\n", "structure", "build ms", "ns/lookup", "extra bytes");
+    for (const auto& result : results) {
+        std::printf("  %-20s %10.1f %12.1f %14zu%s\n", result.name.c_str(), result.buildMs, result.lookupNs,
+                    result.extraBytes, result.correct ? "" : "  WRONG RESULTS");
+    }
+    benchmarkBatchedLookups(keys, eytzinger, sortedPositions, kBatchedLookups);
+}
+
+} // namespace
+
+/**
+ * @brief Runs the lookup benchmark and prints one table per key set.
+ */
+bool runIndexBenchmark(const std::string& dataFilename, size_t syntheticKeys, size_t lookups) {
+    std::vector<uint32_t> keys;
+    if (!loadZipKeys(dataFilename, keys) || keys.empty()) {
+        std::cerr << "Unable to read zip codes from " << dataFilename << std::endl;
+        return false;
+    }
+    benchmarkKeySet("Zip codes (" + dataFilename + ")", keys, lookups);
+
+    if (syntheticKeys > 0) {
+        std::vector<uint32_t> synthetic = makeSyntheticKeys(syntheticKeys);
+        benchmarkKeySet("Synthetic", synthetic, lookups);
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the perfect hash index over many key set sizes and checks every key.
+ */
+bool runPerfectHashCheck(const std::string& scratchFilename) {
+    std::vector<uint32_t> sizes;
+    for (uint32_t n = 1; n <= 300; ++n) {
+        sizes.push_back(n);
+    }
+    const uint32_t ranges[][2] = { { 370, 380 }, { 495, 505 }, { 995, 1010 }, { 2000, 2010 }, { 4090, 4100 } };
+    for (const auto& range : ranges) {
+        for (uint32_t n = range[0]; n <= range[1]; ++n) {
+            sizes.push_back(n);
+        }
+    }
+
+    const int kSetsPerSize = 5;
+    std::mt19937_64 random(35);
+    size_t failures = 0;
+    for (uint32_t n : sizes) {
+        for (int set = 0; set < kSetsPerSize; ++set) {
+            std::vector<uint32_t> keys;
+            keys.reserve(n);
+            while (keys.size() < n) {
+                keys.push_back(static_cast<uint32_t>(random() % 100000));
+                if (keys.size() == n) {
+                    std::sort(keys.begin(), keys.end());
+                    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+                }
+            }
+            std::vector<IndexEntry> entries(n);
+            for (uint32_t i = 0; i < n; ++i) {
+                entries[i].key = keys[i];
+                entries[i].offset = 57 + static_cast<uint64_t>(i) * 48;
+            }
+
+            bool correct = writePrimaryKeyIndex(scratchFilename, entries, PrimaryIndexType::PerfectHash, std::string());
+            std::unique_ptr<PrimaryKeyIndex> index;
+            if (correct) {
+                index = openPrimaryKeyIndex(scratchFilename);
+                correct = index && index->size() == n;
+            }
+            for (uint32_t i = 0; i < n && correct; ++i) {
+                correct = index->find(keys[i]) == static_cast<int64_t>(57 + static_cast<uint64_t>(i) * 48);
+            }
+            if (!correct) {
+                std::cout << "Perfect hash check failed for " << n << " keys (set " << set << ")" << std::endl;
+                ++failures;
+            }
+        }
+    }
+    std::remove(scratchFilename.c_str());
+
+    std::cout << "Perfect hash check: " << sizes.size() * kSetsPerSize << " key sets, "
+              << failures << " failed" << std::endl;
+    return failures == 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file benchmark.h
+ * @brief In-memory lookup benchmark for the primary key search structures.
+ *
+ * The benchmark times the search structures behind the primary key index
+ * formats on the zip codes of the data file and on a larger synthetic key
+ * set, with everything in memory so only the search itself is measured.
+ * It is run with the -bench command line option. The -mphcheck option
+ * builds the perfect hash index over many key set sizes and checks it.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Runs the lookup benchmark and prints one table per key set.
+ *
+ * Every structure maps a key to its position in the sorted key list; the
+ * results are checked against std::lower_bound so a faster but wrong
+ * structure is reported as such.
+ *
+ * @param dataFilename The length-indicated data file whose zip codes form the real key set.
+ * @param syntheticKeys Number of keys in the synthetic set (0 skips it).
+ * @param lookups Number of timed lookups per structure.
+ * @return false if the data file cannot be read.
+ */
+bool runIndexBenchmark(const std::string& dataFilename, size_t syntheticKeys = 10000000, size_t lookups = 2000000);
+
+/**
+ * @brief Builds the perfect hash index over random zip code sets of many sizes and checks every key.
+ *
+ * Sizes 1 to 300 and ranges around 1,000, 2,000 and 4,096 are each tried
+ * with several random sets of 5-digit keys, so sizes whose table has a
+ * large power-of-two factor are covered. Each index is written to the
+ * scratch file, opened again and every key must find its own offset.
+ *
+ * @param scratchFilename File the indexes are written to; removed afterwards.
+ * @return true if every build succeeded and every key was found.
+ */
+bool runPerfectHashCheck(const std::string& scratchFilename);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,343 @@
+/**
+ * @file block_cache.cpp
+ * @brief Implementation of the BlockCache class and the caching backend.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "block_cache.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+const size_t BlockCache::kBlockSize;
+
+BlockCache::BlockCache(size_t budgetBytes) {
+    resetLocked(budgetBytes);
+}
+
+/**
+ * @brief Changes the memory budget, dropping every cached block.
+ * @param budgetBytes New budget. 0 disables the cache.
+ */
+void BlockCache::resize(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    resetLocked(budgetBytes);
+}
+
+bool BlockCache::isEnabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !slots.empty();
+}
+
+/**
+ * @brief Rebuilds all queues for a new budget. The caller holds the lock.
+ *
+ * A1in is sized at a quarter of the frames and A1out remembers half as
+ * many keys as there are frames, the values suggested for 2Q.
+ */
+void BlockCache::resetLocked(size_t budgetBytes) {
+    size_t capacity = budgetBytes / kBlockSize;
+    budget = budgetBytes;
+    inLimit = std::max<size_t>(1, capacity / 4);
+    ghostLimit = std::max<size_t>(1, capacity / 2);
+
+    std::vector<char>(capacity * kBlockSize).swap(memory);
+    slots.assign(capacity, Slot());
+    lookup.clear();
+    ghosts.clear();
+    ghostLookup.clear();
+
+    freeList = SlotList{ -1, -1, 0 };
+    inList = SlotList{ -1, -1, 0 };
+    mainList = SlotList{ -1, -1, 0 };
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].prev = slots[i].next = -1;
+        pushFront(Queue::Free, static_cast<int>(i));
+    }
+
+    std::memset(&stats, 0, sizeof(stats));
+    stats.budgetBytes = budgetBytes;
+}
+
+uint32_t BlockCache::fileId(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = fileIds.find(filename);
+    if (it != fileIds.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(fileIds.size());
+    fileIds[filename] = id;
+    generations.push_back(0);
+    return id;
+}
+
+/**
+ * @brief Drops every cached block (and ghost entry) of a file.
+ *
+ * The file's generation is bumped so that misses already reading the old
+ * contents do not insert them afterwards.
+ */
+void BlockCache::invalidate(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = fileIds.find(filename);
+    if (it == fileIds.end()) {
+        return;
+    }
+    uint64_t file = it->second;
+    ++generations[it->second];
+
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].queue != Queue::Free && (slots[i].key >> 48) == file) {
+            lookup.erase(slots[i].key);
+            unlink(static_cast<int>(i));
+            pushFront(Queue::Free, static_cast<int>(i));
+        }
+    }
+    for (auto ghost = ghosts.begin(); ghost != ghosts.end();) {
+        if ((*ghost >> 48) == file) {
+            ghostLookup.erase(*ghost);
+            ghost = ghosts.erase(ghost);
+        } else {
+            ++ghost;
+        }
+    }
+}
+
+/**
+ * @brief Copies bytes of one block into dest, loading the block on a miss.
+ *
+ * Hits in Am move the block to the front of the LRU; hits in A1in leave
+ * it where it is, as 2Q prescribes. On a miss the block is read without
+ * holding the lock and then inserted, unless another thread got there
+ * first or the file was invalidated while it was being read.
+ */
+long long BlockCache::read(uint32_t file, IoBackend& source, uint64_t block, size_t offsetInBlock, void* dest, size_t count) {
+    uint64_t key = makeKey(file, block);
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = lookup.find(key);
+        if (it != lookup.end()) {
+            Slot& slot = slots[it->second];
+            if (slot.queue == Queue::Main) {
+                unlink(it->second);
+                pushFront(Queue::Main, it->second);
+            }
+            ++stats.hits;
+            size_t n = offsetInBlock < slot.length ? std::min(count, slot.length - offsetInBlock) : 0;
+            std::memcpy(dest, &memory[it->second * kBlockSize + offsetInBlock], n);
+            return static_cast<long long>(n);
+        }
+        ++stats.misses;
+        generation = generations[file];
+    }
+
+    thread_local std::vector<char> loaded(kBlockSize);
+    long long length = source.readAt(loaded.data(), kBlockSize, block * kBlockSize);
+    if (length < 0) {
+        return -1;
+    }
+    size_t n = offsetInBlock < static_cast<size_t>(length) ? std::min(count, static_cast<size_t>(length) - offsetInBlock) : 0;
+    std::memcpy(dest, loaded.data() + offsetInBlock, n);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (slots.empty() || lookup.count(key) || generations[file] != generation) {
+        return static_cast<long long>(n);
+    }
+
+    int slot = allocateSlot();
+    auto ghost = ghostLookup.find(key);
+    if (ghost != ghostLookup.end()) {
+        // Re-referenced soon after leaving probation: promote straight to Am
+        ++stats.ghostHits;
+        ghosts.erase(ghost->second);
+        ghostLookup.erase(ghost);
+        pushFront(Queue::Main, slot);
+    } else {
+        pushFront(Queue::In, slot);
+    }
+    slots[slot].key = key;
+    slots[slot].length = static_cast<uint32_t>(length);
+    std::memcpy(&memory[slot * kBlockSize], loaded.data(), static_cast<size_t>(length));
+    lookup[key] = slot;
+    return static_cast<long long>(n);
+}
+
+BlockCacheStats BlockCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    BlockCacheStats snapshot = stats;
+    snapshot.residentBlocks = lookup.size();
+    return snapshot;
+}
+
+BlockCache::SlotList& BlockCache::listFor(Queue queue) {
+    switch (queue) {
+        case Queue::In:   return inList;
+        case Queue::Main: return mainList;
+        case Queue::Free: break;
+    }
+    return freeList;
+}
+
+void BlockCache::unlink(int slot) {
+    Slot& s = slots[slot];
+    SlotList& list = listFor(s.queue);
+    if (s.prev >= 0) {
+        slots[s.prev].next = s.next;
+    } else {
+        list.head = s.next;
+    }
+    if (s.next >= 0) {
+        slots[s.next].prev = s.prev;
+    } else {
+        list.tail = s.prev;
+    }
+    s.prev = s.next = -1;
+    --list.size;
+}
+
+void BlockCache::pushFront(Queue queue, int slot) {
+    SlotList& list = listFor(queue);
+    Slot& s = slots[slot];
+    s.queue = queue;
+    s.prev = -1;
+    s.next = list.head;
+    if (list.head >= 0) {
+        slots[list.head].prev = slot;
+    } else {
+        list.tail = slot;
+    }
+    list.head = slot;
+    ++list.size;
+}
+
+/**
+ * @brief Takes a free slot, evicting a block if none is free.
+ *
+ * The victim comes from the tail of A1in while it is over its target size
+ * (its key is remembered in A1out), otherwise from the tail of Am.
+ */
+int BlockCache::allocateSlot() {
+    int slot = freeList.head;
+    if (slot >= 0) {
+        unlink(slot);
+        return slot;
+    }
+
+    if (inList.size > inLimit || mainList.size == 0) {
+        slot = inList.tail;
+        rememberGhost(slots[slot].key);
+    } else {
+        slot = mainList.tail;
+    }
+    lookup.erase(slots[slot].key);
+    unlink(slot);
+    ++stats.evictions;
+    return slot;
+}
+
+void BlockCache::rememberGhost(uint64_t key) {
+    ghosts.push_front(key);
+    ghostLookup[key] = ghosts.begin();
+    if (ghosts.size() > ghostLimit) {
+        ghostLookup.erase(ghosts.back());
+        ghosts.pop_back();
+    }
+}
+
+bool parseCacheMegabytes(const std::string& text, size_t& bytes) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long megabytes = std::strtoull(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE || megabytes > (std::numeric_limits<size_t>::max() >> 20)) {
+        return false;
+    }
+    bytes = static_cast<size_t>(megabytes) << 20;
+    return true;
+}
+
+BlockCache& sharedBlockCache() {
+    static BlockCache cache([] {
+        const char* megabytes = std::getenv("ZIPCODE_CACHE_MB");
+        size_t bytes = 0;
+        if (megabytes && !parseCacheMegabytes(megabytes, bytes)) {
+            std::cerr << "Invalid ZIPCODE_CACHE_MB value: " << megabytes << "; block cache disabled" << std::endl;
+        }
+        return bytes;
+    }());
+    return cache;
+}
+
+namespace {
+
+/**
+ * @class CachedBackend
+ * @brief IoBackend decorator that serves reads block by block from a BlockCache.
+ */
+class CachedBackend : public IoBackend {
+public:
+    CachedBackend(std::unique_ptr<IoBackend> innerBackend, const std::string& name, BlockCache& blockCache)
+        : inner(std::move(innerBackend)), filename(name), cache(blockCache), file(blockCache.fileId(name)) {}
+
+    long long readAt(void* dest, size_t count, uint64_t offset) override {
+        char* out = static_cast<char*>(dest);
+        size_t total = 0;
+        while (total < count) {
+            uint64_t position = offset + total;
+            uint64_t block = position / BlockCache::kBlockSize;
+            size_t offsetInBlock = static_cast<size_t>(position % BlockCache::kBlockSize);
+            size_t wanted = std::min(count - total, BlockCache::kBlockSize - offsetInBlock);
+            long long n = cache.read(file, *inner, block, offsetInBlock, out + total, wanted);
+            if (n < 0) {
+                return total > 0 ? static_cast<long long>(total) : -1;
+            }
+            total += static_cast<size_t>(n);
+            if (static_cast<size_t>(n) < wanted) {
+                break;  // End of file
+            }
+        }
+        return static_cast<long long>(total);
+    }
+
+    long long writeAt(const void* src, size_t count, uint64_t offset) override {
+        long long n = inner->writeAt(src, count, offset);
+        cache.invalidate(filename);
+        return n;
+    }
+
+    bool truncate(uint64_t length) override {
+        bool result = inner->truncate(length);
+        cache.invalidate(filename);
+        return result;
+    }
+
+    uint64_t size() const override { return inner->size(); }
+
+    void advise(AccessPattern pattern, uint64_t offset, uint64_t length) override {
+        inner->advise(pattern, offset, length);
+    }
+
+    IoBackendType type() const override { return inner->type(); }
+
+private:
+    std::unique_ptr<IoBackend> inner;
+    std::string filename;
+    BlockCache& cache;
+    uint32_t file;
+};
+
+} // namespace
+
+std::unique_ptr<IoBackend> makeCachedBackend(std::unique_ptr<IoBackend> inner, const std::string& filename, BlockCache& cache) {
+    return std::unique_ptr<IoBackend>(new CachedBackend(std::move(inner), filename, cache));
+}
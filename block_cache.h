@@ -0,0 +1,186 @@
+/**
+ * @file block_cache.h
+ * @brief Header file for the BlockCache class.
+ *
+ * The BlockCache keeps recently used 4 KiB blocks of the data and index
+ * files in a fixed amount of memory, shared by every reader in the
+ * process. Replacement follows the 2Q policy, so a one-off scan cannot
+ * flush the hot blocks that repeated lookups depend on.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "io_backend.h"
+
+/**
+ * @struct BlockCacheStats
+ * @brief Counters reported by BlockCache::getStats().
+ */
+struct BlockCacheStats {
+    uint64_t hits;           /**< Block requests served from memory. */
+    uint64_t misses;         /**< Block requests that had to read the file. */
+    uint64_t ghostHits;      /**< Misses on blocks recently evicted from the probation queue. */
+    uint64_t evictions;      /**< Blocks dropped to make room. */
+    size_t budgetBytes;      /**< Configured memory budget. */
+    size_t residentBlocks;   /**< Blocks currently cached. */
+};
+
+/**
+ * @class BlockCache
+ * @brief Fixed-memory, page-granular cache with 2Q replacement.
+ *
+ * Blocks enter a FIFO probation queue (A1in) on their first miss. A block
+ * evicted from probation leaves only its key behind in a ghost queue
+ * (A1out); if it is requested again while remembered there, it is loaded
+ * straight into the main LRU queue (Am). Blocks read once by a scan
+ * therefore never displace the blocks in Am.
+ *
+ * All block memory is allocated up front from the budget. The cache is
+ * safe to use from several threads; file reads on a miss happen outside
+ * the lock, and each file has a generation, bumped by invalidate(), so a
+ * block read before the file was rewritten is never inserted after it.
+ */
+class BlockCache {
+public:
+    static const size_t kBlockSize = 4096;  /**< Bytes per cached block. */
+
+    /**
+     * @param budgetBytes Memory available for cached blocks. 0 disables the cache.
+     */
+    explicit BlockCache(size_t budgetBytes = 0);
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    /**
+     * @brief Changes the memory budget, dropping every cached block.
+     * @param budgetBytes New budget. 0 disables the cache.
+     */
+    void resize(size_t budgetBytes);
+
+    /**
+     * @brief Returns true if the budget holds at least one block.
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Returns the identifier used to key the blocks of a file.
+     *
+     * The same filename always maps to the same identifier, which is how
+     * separate readers of one file share its cached blocks.
+     */
+    uint32_t fileId(const std::string& filename);
+
+    /**
+     * @brief Drops every cached block of a file, e.g. after it was rewritten.
+     */
+    void invalidate(const std::string& filename);
+
+    /**
+     * @brief Copies bytes of one block into dest, loading the block on a miss.
+     *
+     * @param file Identifier returned by fileId().
+     * @param source Backend used to load the block on a miss.
+     * @param block Index of the block in the file.
+     * @param offsetInBlock First byte of the block to copy.
+     * @param dest Destination buffer.
+     * @param count Maximum number of bytes to copy.
+     * @return The number of bytes copied (short at end of file), or -1 on a read error.
+     */
+    long long read(uint32_t file, IoBackend& source, uint64_t block, size_t offsetInBlock, void* dest, size_t count);
+
+    /**
+     * @brief Returns a snapshot of the counters.
+     */
+    BlockCacheStats getStats() const;
+
+private:
+    enum class Queue { Free, In, Main };
+
+    /** @brief Book-keeping for one block frame. */
+    struct Slot {
+        uint64_t key;      /**< File identifier and block number. */
+        uint32_t length;   /**< Valid bytes (short for the last block of a file). */
+        int prev;          /**< Previous slot in its queue, or -1. */
+        int next;          /**< Next slot in its queue, or -1. */
+        Queue queue;       /**< Queue the slot is on. */
+    };
+
+    /** @brief Head, tail and length of an intrusive queue of slots. */
+    struct SlotList {
+        int head;
+        int tail;
+        size_t size;
+    };
+
+    static uint64_t makeKey(uint32_t file, uint64_t block) { return (static_cast<uint64_t>(file) << 48) | block; }
+
+    void resetLocked(size_t budgetBytes);
+    SlotList& listFor(Queue queue);
+    void unlink(int slot);
+    void pushFront(Queue queue, int slot);
+    int allocateSlot();
+    void rememberGhost(uint64_t key);
+
+    mutable std::mutex mutex;                    /**< Guards everything below. */
+    size_t budget;                               /**< Configured budget in bytes. */
+    size_t inLimit;                              /**< Target size of A1in, in blocks. */
+    size_t ghostLimit;                           /**< Maximum keys remembered in A1out. */
+    std::vector<char> memory;                    /**< Block frames, one per slot. */
+    std::vector<Slot> slots;                     /**< Slot book-keeping. */
+    SlotList freeList;                           /**< Unused slots. */
+    SlotList inList;                             /**< A1in probation FIFO. */
+    SlotList mainList;                           /**< Am LRU, most recent at the head. */
+    std::unordered_map<uint64_t, int> lookup;    /**< Resident block key to slot. */
+    std::list<uint64_t> ghosts;                  /**< A1out keys, most recent at the front. */
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> ghostLookup; /**< A1out index. */
+    std::map<std::string, uint32_t> fileIds;     /**< Filename to identifier. */
+    std::vector<uint64_t> generations;           /**< Invalidation count per file identifier. */
+    BlockCacheStats stats;                       /**< Counters. */
+};
+
+/**
+ * @brief Parses a cache budget given in MiB.
+ *
+ * @param text Decimal number of MiB; 0 disables the cache.
+ * @param bytes Receives the budget in bytes.
+ * @return false if the text is empty, not a whole number or too large.
+ */
+bool parseCacheMegabytes(const std::string& text, size_t& bytes);
+
+/**
+ * @brief Returns the process-wide cache shared by all readers.
+ *
+ * Its initial budget is read from the ZIPCODE_CACHE_MB environment
+ * variable (in MiB, default 0 = disabled); an invalid value is reported
+ * and leaves the cache disabled.
+ */
+BlockCache& sharedBlockCache();
+
+/**
+ * @brief Wraps a backend so that its reads go through a block cache.
+ *
+ * Writes are passed through and drop the file's cached blocks.
+ *
+ * @param inner The backend that owns the file.
+ * @param filename Name of the file, used to share blocks with other readers.
+ * @param cache The cache to use.
+ * @return The caching backend.
+ */
+std::unique_ptr<IoBackend> makeCachedBackend(std::unique_ptr<IoBackend> inner, const std::string& filename, BlockCache& cache);
+
+#endif // BLOCK_CACHE_H
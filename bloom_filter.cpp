@@ -0,0 +1,222 @@
+/**
+ * @file bloom_filter.cpp
+ * @brief Implementation of the BlockedBloomFilter class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "bloom_filter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+const char BlockedBloomFilter::kFileType[] = "ZipCodeBloomFilter";
+const size_t BlockedBloomFilter::kBlockBytes;
+const uint32_t BlockedBloomFilter::kDefaultBitsPerKey;
+const uint32_t BlockedBloomFilter::kDefaultProbes;
+
+namespace {
+
+const size_t kWordsPerBlock = BlockedBloomFilter::kBlockBytes / sizeof(uint64_t);
+const uint32_t kMaxProbes = 7;   // 7 bit positions of 9 bits fit in one 64-bit hash
+
+const uint16_t kVersion = 2;   // Version 2 adds the source stamp
+
+// Block count, probe count, index file size and source stamp
+const size_t kParametersSize = 2 * sizeof(uint32_t) + sizeof(uint64_t) + SourceStamp::kEncodedSize;
+
+uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+uint64_t indexFileSize(const std::string& indexFilename) {
+    std::unique_ptr<IoBackend> index = openIoBackend(indexFilename, IoMode::Read, IoBackendType::Pread);
+    return index ? index->size() : 0;
+}
+
+unsigned popcount(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcountll(word));
+#else
+    unsigned bits = 0;
+    for (; word; word &= word - 1) {
+        ++bits;
+    }
+    return bits;
+#endif
+}
+
+} // namespace
+
+BlockedBloomFilter::BlockedBloomFilter()
+    : blocks(nullptr), writableBlocks(nullptr), blockCount(0), probes(0), keyCount(0) {}
+
+void BlockedBloomFilter::reset(size_t keys, uint32_t bitsPerKey, uint32_t probeCount) {
+    blockCount = std::max<size_t>(1, (keys * bitsPerKey + kBlockBytes * 8 - 1) / (kBlockBytes * 8));
+    probes = std::min(std::max<uint32_t>(probeCount, 1), kMaxProbes);
+    keyCount = 0;
+    std::vector<char>(blockCount * kBlockBytes + kBlockBytes, 0).swap(owned);
+    useOwned();
+}
+
+void BlockedBloomFilter::useOwned() {
+    uintptr_t address = reinterpret_cast<uintptr_t>(owned.data());
+    writableBlocks = reinterpret_cast<uint64_t*>((address + kBlockBytes - 1) & ~static_cast<uintptr_t>(kBlockBytes - 1));
+    blocks = writableBlocks;
+}
+
+void BlockedBloomFilter::insert(uint32_t key) {
+    if (!writableBlocks) {
+        return;
+    }
+    uint64_t hash = mix(key);
+    uint64_t* block = writableBlocks + ((hash >> 32) * blockCount >> 32) * kWordsPerBlock;
+    uint64_t bits = mix(hash);
+    for (uint32_t i = 0; i < probes; ++i, bits >>= 9) {
+        uint32_t bit = static_cast<uint32_t>(bits & 511);
+        block[bit >> 6] |= uint64_t(1) << (bit & 63);
+    }
+    ++keyCount;
+}
+
+bool BlockedBloomFilter::mayContain(uint32_t key) const {
+    if (!blocks) {
+        return true;
+    }
+    uint64_t hash = mix(key);
+    const uint64_t* block = blocks + ((hash >> 32) * blockCount >> 32) * kWordsPerBlock;
+    uint64_t bits = mix(hash);
+    for (uint32_t i = 0; i < probes; ++i, bits >>= 9) {
+        uint32_t bit = static_cast<uint32_t>(bits & 511);
+        if (!(block[bit >> 6] & (uint64_t(1) << (bit & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double BlockedBloomFilter::falsePositiveRate() const {
+    if (!blocks) {
+        return 1.0;
+    }
+    double total = 0.0;
+    for (size_t b = 0; b < blockCount; ++b) {
+        unsigned set = 0;
+        for (size_t w = 0; w < kWordsPerBlock; ++w) {
+            set += popcount(blocks[b * kWordsPerBlock + w]);
+        }
+        total += std::pow(set / static_cast<double>(kBlockBytes * 8), static_cast<double>(probes));
+    }
+    return total / blockCount;
+}
+
+bool BlockedBloomFilter::save(const std::string& filename, uint64_t indexSize, const SourceStamp& generatedFrom) const {
+    TemporaryFile temporary(filename);
+    std::unique_ptr<IoBackend> out = openIoBackend(temporary.getFilename(), IoWorkload::Write);
+    if (!out || !blocks) {
+        std::cerr << "Unable to write Bloom filter: " << filename << std::endl;
+        return false;
+    }
+    SequentialWriter writer(*out);
+    uint32_t headerSize = writeIndexHeader(writer, kFileType, kVersion, static_cast<uint32_t>(keyCount));
+    uint32_t parameters[2] = { static_cast<uint32_t>(blockCount), probes };
+    writer.write(parameters, sizeof(parameters));
+    writer.write(&indexSize, sizeof(indexSize));
+    char stamp[SourceStamp::kEncodedSize];
+    generatedFrom.encode(stamp);
+    writer.write(stamp, sizeof(stamp));
+    size_t used = headerSize + kParametersSize;
+    const char padding[kBlockBytes] = {};
+    writer.write(padding, (kBlockBytes - used % kBlockBytes) % kBlockBytes);
+    writer.write(blocks, blockCount * kBlockBytes);
+    if (!writer.finish()) {
+        std::cerr << "Error writing Bloom filter: " << filename << std::endl;
+        return false;
+    }
+    out.reset();
+    return temporary.commit();
+}
+
+/**
+ * @brief Maps a filter file.
+ *
+ * The blocks start on a 64-byte boundary of the mapping and are used in place.
+ */
+bool BlockedBloomFilter::open(const std::string& filename, uint64_t indexSize) {
+    blocks = writableBlocks = nullptr;
+    blockCount = 0;
+    keyCount = 0;
+    source = SourceStamp();
+
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != kVersion ||
+        file.size() < header.headerSize + kParametersSize) {
+        return false;
+    }
+    uint32_t parameters[2];
+    uint64_t builtFor;
+    std::memcpy(parameters, file.data() + header.headerSize, sizeof(parameters));
+    std::memcpy(&builtFor, file.data() + header.headerSize + sizeof(parameters), sizeof(builtFor));
+    size_t used = header.headerSize + kParametersSize;
+    size_t blocksAt = used + (kBlockBytes - used % kBlockBytes) % kBlockBytes;
+    if (builtFor != indexSize || parameters[0] == 0 || parameters[1] == 0 || parameters[1] > kMaxProbes ||
+        file.size() < blocksAt + static_cast<uint64_t>(parameters[0]) * kBlockBytes) {
+        return false;
+    }
+    blockCount = parameters[0];
+    probes = parameters[1];
+    keyCount = header.entryCount;
+    source.decode(file.data() + header.headerSize + sizeof(parameters) + sizeof(builtFor));
+    blocks = reinterpret_cast<const uint64_t*>(file.data() + blocksAt);
+    return true;
+}
+
+void BlockedBloomFilter::close() {
+    blocks = writableBlocks = nullptr;
+    blockCount = 0;
+    keyCount = 0;
+    source = SourceStamp();
+    std::vector<char>().swap(owned);
+    file.close();
+}
+
+std::string bloomFilterFilename(const std::string& indexFilename) {
+    return indexFilename + ".bloom";
+}
+
+bool writeIndexBloomFilter(const std::string& indexFilename, const std::vector<IndexEntry>& entries,
+                           const SourceStamp& source) {
+    uint64_t indexSize = indexFileSize(indexFilename);
+    if (indexSize == 0) {
+        std::cerr << "Unable to open index file: " << indexFilename << std::endl;
+        return false;
+    }
+    BlockedBloomFilter filter;
+    filter.reset(entries.size());
+    for (const IndexEntry& entry : entries) {
+        filter.insert(entry.key);
+    }
+    return filter.save(bloomFilterFilename(indexFilename), indexSize, source);
+}
+
+bool removeIndexBloomFilter(const std::string& indexFilename) {
+    std::string filename = bloomFilterFilename(indexFilename);
+    if (std::remove(filename.c_str()) != 0 && openIoBackend(filename, IoMode::Read, IoBackendType::Pread)) {
+        std::cerr << "Unable to remove stale Bloom filter: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool openIndexBloomFilter(const std::string& indexFilename, BlockedBloomFilter& filter) {
+    uint64_t indexSize = indexFileSize(indexFilename);
+    return indexSize != 0 && filter.open(bloomFilterFilename(indexFilename), indexSize);
+}
@@ -0,0 +1,179 @@
+/**
+ * @file bloom_filter.h
+ * @brief Header file for the BlockedBloomFilter class.
+ *
+ * Many searches are for zip codes that do not exist. The blocked Bloom
+ * filter is written next to the primary key index and answers "definitely
+ * not present" for almost all of them from a single cache line, before the
+ * index or the data file is touched. Keys that pass the filter are looked
+ * up in the index as usual, so a false positive only costs that lookup.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+#include "primary_key_index.h"
+#include "source_stamp.h"
+
+/**
+ * @class BlockedBloomFilter
+ * @brief Bloom filter whose probes for a key all fall in one 64-byte block.
+ *
+ * One half of the key hash picks a 512-bit block; the other hash supplies
+ * the bit positions inside it. Confining the probes to one cache line
+ * costs a slightly higher false-positive rate than a classic Bloom filter
+ * of the same size, in exchange for one memory access per query.
+ *
+ * The file holds the "ZipCodeBloomFilter" header (its entry count is the
+ * number of keys added), the block count, the probe count, the size of
+ * the index file the filter was built for and the stamp of the CSV the
+ * index was generated from, then the blocks at a 64-byte aligned offset.
+ * A filter whose recorded index size does not match the index on disk is
+ * stale and is not used. Since two indexes over different keys can have
+ * the same size, the old filter is also removed before a new index is
+ * committed (see removeIndexBloomFilter).
+ */
+class BlockedBloomFilter {
+public:
+    static const char kFileType[];              /**< File type stored in the header. */
+    static const size_t kBlockBytes = 64;       /**< Bytes per block (one cache line). */
+    static const uint32_t kDefaultBitsPerKey = 10;  /**< About 1% false positives. */
+    static const uint32_t kDefaultProbes = 7;       /**< Bits set per key. */
+
+    BlockedBloomFilter();
+
+    /**
+     * @brief Sizes an empty filter for a number of keys.
+     * @param keyCount Number of keys that will be added.
+     * @param bitsPerKey Filter bits per key.
+     * @param probes Bits set per key.
+     */
+    void reset(size_t keyCount, uint32_t bitsPerKey = kDefaultBitsPerKey, uint32_t probes = kDefaultProbes);
+
+    /**
+     * @brief Adds a key.
+     */
+    void insert(uint32_t key);
+
+    /**
+     * @brief Tests a key.
+     * @return false if the key was definitely never added; true if it may have been.
+     *         An empty (never reset or opened) filter returns true for every key.
+     */
+    bool mayContain(uint32_t key) const;
+
+    /**
+     * @brief Writes the filter.
+     * @param filename The filter file to create.
+     * @param indexSize Size of the index file the filter belongs to.
+     * @param generatedFrom Stamp of the CSV the index was generated from.
+     * @return true if the file was written.
+     */
+    bool save(const std::string& filename, uint64_t indexSize, const SourceStamp& generatedFrom) const;
+
+    /**
+     * @brief Maps a filter file.
+     * @param filename The filter file.
+     * @param indexSize Size of the index file on disk; the filter is rejected if it was built for another.
+     * @return false if the file is missing, corrupt or stale. The filter is then empty.
+     */
+    bool open(const std::string& filename, uint64_t indexSize);
+
+    /**
+     * @brief Releases the filter's storage and unmaps its file. The filter is then empty.
+     */
+    void close();
+
+    /**
+     * @brief Returns true if the filter holds any blocks.
+     */
+    bool isLoaded() const { return blocks != nullptr; }
+
+    /**
+     * @brief Returns the number of keys added.
+     */
+    size_t size() const { return keyCount; }
+
+    /**
+     * @brief Returns the bytes used by the blocks.
+     */
+    size_t memoryUsage() const { return blockCount * kBlockBytes; }
+
+    /**
+     * @brief Returns the number of bits set per key.
+     */
+    uint32_t getProbes() const { return probes; }
+
+    /**
+     * @brief Returns the chance that a key never added passes the filter.
+     *
+     * Computed from the actual fill of each block: a random key picks a
+     * block uniformly and passes if all of its probes hit set bits.
+     */
+    double falsePositiveRate() const;
+
+    /**
+     * @brief Returns the stamp of the CSV the index was generated from, as stored in the file.
+     */
+    const SourceStamp& getSourceStamp() const { return source; }
+
+private:
+    void useOwned();
+
+    std::vector<char> owned;      /**< Storage after reset(), over-allocated for alignment. */
+    MappedFile file;              /**< Storage after open(). */
+    const uint64_t* blocks;       /**< Aligned blocks, eight 64-bit words each. */
+    uint64_t* writableBlocks;     /**< Same as blocks when the filter is owned. */
+    size_t blockCount;
+    uint32_t probes;
+    size_t keyCount;
+    SourceStamp source;           /**< Stamp read by open(). */
+};
+
+/**
+ * @brief Returns the name of the Bloom filter file kept next to an index file.
+ */
+std::string bloomFilterFilename(const std::string& indexFilename);
+
+/**
+ * @brief Builds and writes the Bloom filter for a primary key index file.
+ *
+ * Call after the index itself is written, since the filter records the
+ * index file's size.
+ *
+ * @param indexFilename The index file the filter belongs to.
+ * @param entries The index entries.
+ * @param source Stamp of the CSV the index was generated from.
+ * @return true if the filter file was written.
+ */
+bool writeIndexBloomFilter(const std::string& indexFilename, const std::vector<IndexEntry>& entries,
+                           const SourceStamp& source);
+
+/**
+ * @brief Removes the Bloom filter kept next to a primary key index file.
+ *
+ * Call before the index is replaced, so that a filter built for the old
+ * keys can never be matched to the new index. The filter must not be
+ * open (on Windows an open mapping prevents the removal).
+ *
+ * @param indexFilename The index file the filter belongs to.
+ * @return true if there is no filter file left.
+ */
+bool removeIndexBloomFilter(const std::string& indexFilename);
+
+/**
+ * @brief Opens the Bloom filter kept next to a primary key index file.
+ * @return false if there is no usable filter for the index as it is on disk.
+ */
+bool openIndexBloomFilter(const std::string& indexFilename, BlockedBloomFilter& filter);
+
+#endif // BLOOM_FILTER_H
@@ -0,0 +1,370 @@
+/**
+ * @file bplus_tree_index.cpp
+ * @brief Implementation of the BPlusTreeIndex class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "bplus_tree_index.h"
+#include <algorithm>
+#include <cstring>
+
+const char BPlusTreeIndex::kFileType[] = "ZipCodeBPlusTree";
+const size_t BPlusTreeIndex::kPageSize;
+const size_t BPlusTreeIndex::kLeafCapacity;
+const size_t BPlusTreeIndex::kInternalCapacity;
+
+namespace {
+
+// Page layout: u16 kind, u16 count, u32 next, 8 reserved bytes, then the
+// keys and either the leaf offsets or the internal child page numbers.
+const uint16_t kLeafPage = 1;
+const uint16_t kInternalPage = 2;
+const size_t kPageHeaderSize = 16;
+const size_t kLeafOffsetsAt = kPageHeaderSize + BPlusTreeIndex::kLeafCapacity * sizeof(uint32_t);
+const size_t kChildrenAt = kPageHeaderSize + BPlusTreeIndex::kInternalCapacity * sizeof(uint32_t);
+
+template <typename T>
+T load(const char* page, size_t at) {
+    T value;
+    std::memcpy(&value, page + at, sizeof(value));
+    return value;
+}
+
+template <typename T>
+void store(char* page, size_t at, T value) {
+    std::memcpy(page + at, &value, sizeof(value));
+}
+
+uint32_t pageKind(const char* page) { return load<uint16_t>(page, 0); }
+uint32_t pageKeys(const char* page) { return load<uint16_t>(page, 2); }
+uint32_t pageNext(const char* page) { return load<uint32_t>(page, 4); }
+uint32_t keyAt(const char* page, size_t i) { return load<uint32_t>(page, kPageHeaderSize + i * sizeof(uint32_t)); }
+
+// Index of the first key >= key
+uint32_t lowerBound(const char* page, uint32_t count, uint32_t key) {
+    uint32_t low = 0;
+    uint32_t high = count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (keyAt(page, middle) < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Index of the child of an internal page that covers key
+uint32_t childFor(const char* page, uint32_t count, uint32_t key) {
+    uint32_t low = 0;
+    uint32_t high = count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (keyAt(page, middle) <= key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Number of pages needed for n items at perPage items each (at least one)
+size_t pagesFor(size_t n, size_t perPage) {
+    return std::max<size_t>(1, (n + perPage - 1) / perPage);
+}
+
+} // namespace
+
+BPlusTreeIndex::BPlusTreeIndex()
+    : entryCount(0), root(0), height(0), pageCount(0) {}
+
+/**
+ * @brief Opens an existing B+ tree index file.
+ *
+ * The index uses the lookup backend, so hot upper-level pages are served
+ * from the shared block cache when it is enabled.
+ */
+bool BPlusTreeIndex::open(const std::string& name) {
+    filename = name;
+    file = openIoBackend(name, IoWorkload::Lookup);
+    if (!file) {
+        return false;
+    }
+
+    std::vector<char> meta(kPageSize);
+    long long n = file->readAt(meta.data(), kPageSize, 0);
+    IndexFileHeader header;
+    if (n != static_cast<long long>(kPageSize) || !readIndexHeader(meta.data(), kPageSize, header) ||
+        header.fileType != kFileType || header.version != 1 ||
+        header.headerSize + 5 * sizeof(uint32_t) > kPageSize) {
+        return false;
+    }
+    entryCount = header.entryCount;
+    root = load<uint32_t>(meta.data(), header.headerSize);
+    height = load<uint32_t>(meta.data(), header.headerSize + 4);
+    pageCount = load<uint32_t>(meta.data(), header.headerSize + 8);
+    uint32_t pageSize = load<uint32_t>(meta.data(), header.headerSize + 16);
+
+    return pageSize == kPageSize && root < pageCount &&
+           static_cast<uint64_t>(pageCount) * kPageSize <= file->size();
+}
+
+/**
+ * @brief Looks up a zip code with one page read per level.
+ *
+ * Pages are searched in place; nothing is decoded beyond the keys probed.
+ */
+int64_t BPlusTreeIndex::find(uint32_t key) const {
+    if (root == 0) {
+        return -1;
+    }
+    char buffer[kPageSize];
+    uint32_t page = root;
+    for (uint32_t level = 1; level <= height; ++level) {
+        if (!readPage(page, buffer)) {
+            return -1;
+        }
+        uint32_t count = pageKeys(buffer);
+        if (level < height) {
+            if (pageKind(buffer) != kInternalPage || count > kInternalCapacity) {
+                return -1;
+            }
+            page = load<uint32_t>(buffer, kChildrenAt + childFor(buffer, count, key) * sizeof(uint32_t));
+        } else {
+            if (pageKind(buffer) != kLeafPage || count > kLeafCapacity) {
+                return -1;
+            }
+            uint32_t i = lowerBound(buffer, count, key);
+            if (i < count && keyAt(buffer, i) == key) {
+                return static_cast<int64_t>(load<uint64_t>(buffer, kLeafOffsetsAt + i * sizeof(uint64_t)));
+            }
+        }
+    }
+    return -1;
+}
+
+size_t BPlusTreeIndex::size() const {
+    return entryCount;
+}
+
+PrimaryIndexType BPlusTreeIndex::type() const {
+    return PrimaryIndexType::BPlusTree;
+}
+
+/**
+ * @class BPlusTreeIndex::RangeCursor
+ * @brief Walks the leaf chain from the leaf holding low until a key exceeds high.
+ */
+class BPlusTreeIndex::RangeCursor : public IndexCursor {
+public:
+    RangeCursor(const BPlusTreeIndex& owner, uint32_t low, uint32_t high)
+        : tree(owner), buffer(kPageSize), page(0), position(0), count(0), high(high), visited(0) {
+        if (tree.root != 0 && low <= high && loadLeaf(tree.findLeaf(low))) {
+            position = lowerBound(buffer.data(), count, low);
+        }
+    }
+
+    bool next(IndexEntry& entry) override {
+        while (page != 0 && position >= count) {
+            // Bound the walk by the page count so a corrupt chain cannot loop forever
+            if (++visited >= tree.pageCount || !loadLeaf(pageNext(buffer.data()))) {
+                page = 0;
+            }
+        }
+        if (page == 0) {
+            return false;
+        }
+        entry.key = keyAt(buffer.data(), position);
+        if (entry.key > high) {
+            page = 0;
+            return false;
+        }
+        entry.offset = load<uint64_t>(buffer.data(), kLeafOffsetsAt + position * sizeof(uint64_t));
+        ++position;
+        return true;
+    }
+
+private:
+    bool loadLeaf(uint32_t leaf) {
+        page = 0;
+        if (leaf == 0 || !tree.readPage(leaf, buffer.data()) || pageKind(buffer.data()) != kLeafPage) {
+            return false;
+        }
+        page = leaf;
+        position = 0;
+        count = std::min<uint32_t>(pageKeys(buffer.data()), kLeafCapacity);
+        return true;
+    }
+
+    const BPlusTreeIndex& tree;
+    std::vector<char> buffer;   /**< The current leaf page. */
+    uint32_t page;              /**< The current leaf, 0 once the range is exhausted. */
+    uint32_t position;
+    uint32_t count;
+    uint32_t high;
+    uint32_t visited;
+};
+
+/**
+ * @brief Collects the entries with keys in [low, high], in key order.
+ *
+ * Descends once to the leaf that would hold low and then follows the leaf
+ * chain until a key above high is seen.
+ */
+size_t BPlusTreeIndex::range(uint32_t low, uint32_t high, std::vector<IndexEntry>& results) const {
+    size_t before = results.size();
+    RangeCursor cursor(*this, low, high);
+    IndexEntry entry;
+    while (cursor.next(entry)) {
+        results.push_back(entry);
+    }
+    return results.size() - before;
+}
+
+std::unique_ptr<IndexCursor> BPlusTreeIndex::openRange(uint32_t low, uint32_t high) const {
+    return std::unique_ptr<IndexCursor>(new RangeCursor(*this, low, high));
+}
+
+/**
+ * @brief Writes a bulk-loaded B+ tree index.
+ *
+ * The number of pages on every level follows from the entry count alone,
+ * so the metadata page is written first and the rest of the file is laid
+ * out leaves first, then each internal level, ending with the root.
+ * Entries are spread evenly over the pages of a level so the last page is
+ * never left nearly empty.
+ */
+bool BPlusTreeIndex::write(SequentialWriter& writer, std::vector<IndexEntry>& entries) {
+    sortIndexEntries(entries);
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return a.key == b.key;
+    }), entries.end());
+
+    const size_t perLeaf = kLeafCapacity * 7 / 8;
+    const size_t perInternal = (kInternalCapacity + 1) * 7 / 8;
+
+    // Page counts per level, leaves first
+    std::vector<size_t> levelPages;
+    if (!entries.empty()) {
+        levelPages.push_back(pagesFor(entries.size(), perLeaf));
+        while (levelPages.back() > 1) {
+            levelPages.push_back(pagesFor(levelPages.back(), perInternal));
+        }
+    }
+    uint32_t totalPages = 1;
+    for (size_t pages : levelPages) {
+        totalPages += static_cast<uint32_t>(pages);
+    }
+    uint32_t treeHeight = static_cast<uint32_t>(levelPages.size());
+    uint32_t rootPage = entries.empty() ? 0 : totalPages - 1;
+
+    std::string meta = encodeMeta(static_cast<uint32_t>(entries.size()), rootPage, treeHeight, totalPages);
+    if (!writer.write(meta.data(), meta.size())) {
+        return false;
+    }
+
+    std::unique_ptr<Node> node(new Node());
+    std::vector<char> page(kPageSize);
+    std::vector<uint32_t> firstKeys;      // Smallest key under each page of the level just written
+    std::vector<uint32_t> nextFirstKeys;
+    uint32_t nextPage = 1;
+
+    for (size_t level = 0; level < levelPages.size(); ++level) {
+        size_t items = level == 0 ? entries.size() : firstKeys.size();
+        size_t pages = levelPages[level];
+        uint32_t firstChild = nextPage - static_cast<uint32_t>(firstKeys.size());
+        nextFirstKeys.clear();
+
+        size_t item = 0;
+        for (size_t p = 0; p < pages; ++p) {
+            size_t take = items / pages + (p < items % pages ? 1 : 0);
+            node->leaf = level == 0;
+            node->next = 0;
+            if (node->leaf) {
+                node->count = static_cast<uint32_t>(take);
+                for (size_t i = 0; i < take; ++i) {
+                    node->keys[i] = entries[item + i].key;
+                    node->offsets[i] = entries[item + i].offset;
+                }
+                if (p + 1 < pages) {
+                    node->next = nextPage + 1;
+                }
+                nextFirstKeys.push_back(entries[item].key);
+            } else {
+                node->count = static_cast<uint32_t>(take - 1);
+                for (size_t i = 0; i < take; ++i) {
+                    node->children[i] = firstChild + static_cast<uint32_t>(item + i);
+                    if (i > 0) {
+                        node->keys[i - 1] = firstKeys[item + i];
+                    }
+                }
+                nextFirstKeys.push_back(firstKeys[item]);
+            }
+            encodeNode(*node, page.data());
+            if (!writer.write(page.data(), kPageSize)) {
+                return false;
+            }
+            item += take;
+            ++nextPage;
+        }
+        firstKeys.swap(nextFirstKeys);
+    }
+    return true;
+}
+
+void BPlusTreeIndex::encodeNode(const Node& node, char* page) {
+    std::memset(page, 0, kPageSize);
+    store<uint16_t>(page, 0, node.leaf ? kLeafPage : kInternalPage);
+    store<uint16_t>(page, 2, static_cast<uint16_t>(node.count));
+    store<uint32_t>(page, 4, node.next);
+    std::memcpy(page + kPageHeaderSize, node.keys, node.count * sizeof(uint32_t));
+    if (node.leaf) {
+        std::memcpy(page + kLeafOffsetsAt, node.offsets, node.count * sizeof(uint64_t));
+    } else {
+        std::memcpy(page + kChildrenAt, node.children, (node.count + 1) * sizeof(uint32_t));
+    }
+}
+
+/**
+ * @brief Builds page 0: the index header followed by the tree metadata.
+ *
+ * The fourth field is reserved (always 0) so the layout is unchanged.
+ */
+std::string BPlusTreeIndex::encodeMeta(uint32_t count, uint32_t rootPage, uint32_t treeHeight, uint32_t pages) {
+    std::string meta = encodeIndexHeader(kFileType, 1, count);
+    const uint32_t fields[] = { rootPage, treeHeight, pages, 0, static_cast<uint32_t>(kPageSize) };
+    meta.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+    meta.resize(kPageSize, '\0');
+    return meta;
+}
+
+bool BPlusTreeIndex::readPage(uint32_t page, char* buffer) const {
+    return page > 0 && page < pageCount &&
+           file->readAt(buffer, kPageSize, static_cast<uint64_t>(page) * kPageSize) == static_cast<long long>(kPageSize);
+}
+
+/**
+ * @brief Descends from the root to the leaf that covers a key.
+ * @param key The key to locate.
+ * @return The leaf page, or 0 if the tree is empty or a page cannot be read.
+ */
+uint32_t BPlusTreeIndex::findLeaf(uint32_t key) const {
+    if (root == 0) {
+        return 0;
+    }
+    char buffer[kPageSize];
+    uint32_t page = root;
+    for (uint32_t level = 1; level < height; ++level) {
+        if (!readPage(page, buffer) || pageKind(buffer) != kInternalPage) {
+            return 0;
+        }
+        uint32_t count = std::min<uint32_t>(pageKeys(buffer), kInternalCapacity);
+        page = load<uint32_t>(buffer, kChildrenAt + childFor(buffer, count, key) * sizeof(uint32_t));
+    }
+    return page;
+}
@@ -15,6 +15,12 @@
 #include <iomanip>  // For controlling output format
 #include <cstdint>  // For fixed-width integer types (e.g., uint32_t)
 #include <fstream>
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include "io_backend.h"
 
 /**
  * @brief Loads zip code records from a CSV file.
@@ -65,7 +71,7 @@ bool Buffer::loadFromCSV(const std::string& filename) {
             continue;
         }
 
-        records.push_back(record);
+        addRecord(record);
     }
 
     file.close();
@@ -89,16 +95,50 @@ void Buffer::printRecord(const ZipCodeRecord& record) const {
               << ", Long: " << record.longitude << std::endl;
 }
 
+/**
+ * @brief Appends a record and adds its zip code to the in-memory indexes.
+ *
+ * Five-digit zip codes go in the direct-address table; longer keys go in
+ * the hash index. When a zip code appears more than once the first record
+ * keeps the key, matching the first-match behaviour of a scan. Records
+ * whose zip code is not numeric are stored but not indexed.
+ *
+ * @param record The record to store.
+ */
+void Buffer::addRecord(const ZipCodeRecord& record) {
+    uint32_t key;
+    if (parseZipKey(record.zipCode, key)) {
+        uint32_t slot = static_cast<uint32_t>(records.size());
+        if (key < DirectAddressTable::kSlots) {
+            zipTable.insert(key, slot);
+        } else {
+            zipIndex.insert(key, slot);
+        }
+    }
+    records.push_back(record);
+}
+
 /**
  * @brief Retrieves a record by zip code.
  *
- * Searches for a zip code record by its zip code value and returns
- * a pointer to the matching record if found.
+ * A five-digit zip code is a single access to the direct-address table;
+ * longer keys are looked up in the hash index. Either way a lookup costs
+ * one or two cache lines instead of a scan of every record. Zip codes that
+ * are not numeric cannot be in the indexes and are matched by comparing strings.
  *
  * @param zipCode The zip code to search for.
  * @return ZipCodeRecord* Pointer to the record if found, nullptr otherwise.
  */
 ZipCodeRecord* Buffer::getRecordByZip(const std::string& zipCode) {
+    uint32_t key;
+    if (parseZipKey(zipCode, key)) {
+        uint32_t slot;
+        if (key < DirectAddressTable::kSlots) {
+            slot = zipTable.get(key);
+            return slot != DirectAddressTable::kMissing ? &records[slot] : nullptr;
+        }
+        return zipIndex.find(key, slot) ? &records[slot] : nullptr;
+    }
     for (auto& record : records) {
         if (record.zipCode == zipCode) {
             return &record;
@@ -107,50 +147,307 @@ ZipCodeRecord* Buffer::getRecordByZip(const std::string& zipCode) {
     return nullptr;
 }
 
+/**
+ * @brief Returns the loaded records in the order they are written to the data file.
+ *
+ * Clustered files are ordered by numeric zip code, equal zip codes in CSV
+ * order, with any record whose zip code is not a number at the end.
+ *
+ * @return Pointers into records, valid until the next load.
+ */
+std::vector<const ZipCodeRecord*> Buffer::recordsInFileOrder() const {
+    std::vector<const ZipCodeRecord*> ordered;
+    ordered.reserve(records.size());
+    for (const auto& record : records) {
+        ordered.push_back(&record);
+    }
+    if (clusterByZip) {
+        std::vector<std::pair<uint64_t, const ZipCodeRecord*>> keyed;
+        keyed.reserve(ordered.size());
+        for (const ZipCodeRecord* record : ordered) {
+            uint32_t key;
+            keyed.push_back(std::make_pair(parseZipKey(record->zipCode, key) ? key : UINT64_MAX, record));
+        }
+        std::stable_sort(keyed.begin(), keyed.end(), [](const std::pair<uint64_t, const ZipCodeRecord*>& a,
+                                                        const std::pair<uint64_t, const ZipCodeRecord*>& b) {
+            return a.first < b.first;
+        });
+        for (size_t i = 0; i < keyed.size(); ++i) {
+            ordered[i] = keyed[i].second;
+        }
+    }
+    return ordered;
+}
+
 /**
  * @brief Converts CSV records to a length-indicated file format.
  *
  * This method converts the loaded CSV records into a length-indicated
  * file format. The resulting file contains the header and each record's
- * length followed by the record itself in binary form.
+ * length followed by the record itself in binary form. The header ends with
+ * the stamp of the CSV file so later runs can tell whether it changed.
  *
- * @param inputFilename The original CSV filename.
+ * The records are encoded one at a time and streamed to the file, noting
+ * where each one starts. When an index filename is given, those offsets
+ * are the primary key index entries, so the index and its Bloom filter are
+ * written without reading the data file back. With concurrent index
+ * writing enabled the encoded records are kept in memory instead, since
+ * the index needs every offset before its thread can start, and the index
+ * is sorted and written on a second thread while this one writes them. With clustering enabled the records
+ * are written in zip code order rather than in CSV order. Every file is
+ * written under a temporary name and renamed once complete, and the data
+ * file only replaces the old one after the primary key index has. The place name,
+ * state/zip, covering, secondary and inverted indexes are collected in the
+ * same loop and written once the data file is; all but the place name
+ * entries come from each encoded record parsed back, so they hold exactly
+ * what a reader of the data file sees.
+ *
+ * @param inputFilename The original CSV filename, stamped into the header.
  * @param outputFilename The name of the length-indicated file.
- * @return true if the file is successfully written, false otherwise.
+ * @param indexFilename The primary key index to write as well, or empty for none.
+ * @param placeIndexFilename The place name index to write as well, or empty for none.
+ * @param stateZipFilename The state/zip index to write as well, or empty for none.
+ * @param coveringFilename The covering index to write as well, or empty for none.
+ * @param secondaryFields Numeric fields (see numericFields()) to write a secondary index on,
+ *                        each to secondaryIndexFilename(field).
+ * @param invertedFields Text fields (see textFields()) to write inverted lists for,
+ *                       each to invertedIndexFilename(field).
+ * @return true if every file is successfully written, false otherwise.
  */
-bool Buffer::convertToLengthIndicatedFile(const std::string& inputFilename, const std::string& outputFilename) {
-    std::ofstream outputFile(outputFilename, std::ios::binary);
-    if (!outputFile.is_open()) {
+bool Buffer::convertToLengthIndicatedFile(const std::string& inputFilename, const std::string& outputFilename,
+                                          const std::string& indexFilename, const std::string& placeIndexFilename,
+                                          const std::string& stateZipFilename, const std::string& coveringFilename,
+                                          const std::vector<std::string>& secondaryFields,
+                                          const std::vector<std::string>& invertedFields) {
+    std::vector<const NumericField*> numericIndexed;
+    for (const auto& name : secondaryFields) {
+        const NumericField* field = findNumericField(name);
+        if (!field) {
+            std::cerr << "No numeric field named " << name << std::endl;
+            return false;
+        }
+        numericIndexed.push_back(field);
+    }
+    std::vector<const TextField*> textIndexed;
+    for (const auto& name : invertedFields) {
+        const TextField* field = findTextField(name);
+        if (!field) {
+            std::cerr << "No text field named " << name << std::endl;
+            return false;
+        }
+        textIndexed.push_back(field);
+    }
+
+    TemporaryFile temporary(outputFilename);
+    std::unique_ptr<IoBackend> outputFile = openIoBackend(temporary.getFilename(), IoWorkload::Write);
+    if (!outputFile) {
         std::cerr << "Unable to open output file: " << outputFilename << std::endl;
         return false;
     }
+    SequentialWriter writer(*outputFile);
+
+    // Step 1: Write the header, ending with the stamp of the CSV the records came from
+    SourceStamp source;
+    if (!stampSourceFile(inputFilename, source)) {
+        std::cerr << "Unable to stamp source file: " << inputFilename << std::endl;
+    }
+    char stamp[SourceStamp::kEncodedSize];
+    source.encode(stamp);
 
-    // Step 1: Write the header
     std::string fileType = "ZipCodeLengthIndicated";
-    uint16_t version = 1;  // Version 1.0
-    uint32_t headerSize = fileType.size() + 1 + sizeof(version) + sizeof(headerSize) + sizeof(uint32_t);
+    uint16_t version = 2;  // Version 2.0 adds the source stamp
+    uint32_t headerSize = fileType.size() + 1 + sizeof(version) + sizeof(headerSize) + sizeof(uint32_t) + sizeof(stamp);
     uint32_t recordCount = records.size();
 
-    outputFile.write(fileType.c_str(), fileType.size() + 1);  // Include null-terminator
-    outputFile.write(reinterpret_cast<const char*>(&version), sizeof(version));
-    outputFile.write(reinterpret_cast<const char*>(&headerSize), sizeof(headerSize));
-    outputFile.write(reinterpret_cast<const char*>(&recordCount), sizeof(recordCount));
-
-    // Step 2: Write each record length followed by the record in binary
-    for (const auto& record : records) {
+    writer.write(fileType.c_str(), fileType.size() + 1);  // Include null-terminator
+    writer.write(&version, sizeof(version));
+    writer.write(&headerSize, sizeof(headerSize));
+    writer.write(&recordCount, sizeof(recordCount));
+    writer.write(stamp, sizeof(stamp));
+
+    // Step 2: Encode each record length followed by the record in binary,
+    // keeping the zip code and file offset of each for the index
+    std::string body;  // Only used when the index is written concurrently
+    uint64_t position = headerSize;
+    std::vector<IndexEntry> entries;
+    entries.reserve(indexFilename.empty() ? 0 : records.size());
+    std::vector<std::pair<std::string, uint32_t>> placeNames;
+    placeNames.reserve(placeIndexFilename.empty() ? 0 : records.size());
+    std::vector<StateZipEntry> stateZips;
+    stateZips.reserve(stateZipFilename.empty() ? 0 : records.size());
+    std::vector<CoveredFields> covered;
+    covered.reserve(coveringFilename.empty() ? 0 : records.size());
+    std::vector<std::vector<SecondaryEntry>> numericEntries(numericIndexed.size());
+    for (auto& fieldEntries : numericEntries) {
+        fieldEntries.reserve(records.size());
+    }
+    std::vector<std::vector<std::pair<std::string, uint64_t>>> textEntries(textIndexed.size());
+    for (auto& fieldEntries : textEntries) {
+        fieldEntries.reserve(records.size());
+    }
+    bool parseWritten = !stateZipFilename.empty() || !coveringFilename.empty() || !numericIndexed.empty() ||
+                        !textIndexed.empty();
+    for (const ZipCodeRecord* recordInOrder : recordsInFileOrder()) {
+        const ZipCodeRecord& record = *recordInOrder;
         // Convert the record to a string format similar to CSV
         std::ostringstream oss;
         oss << record.zipCode << "," << record.placeName << "," << record.state
             << "," << record.county << "," << record.latitude << "," << record.longitude;
         std::string recordString = oss.str();
 
+        IndexEntry entry;
+        if (!indexFilename.empty() && parseRecordZipKey(recordString.data(), recordString.size(), entry.key)) {
+            entry.offset = position;
+            entries.push_back(entry);
+        }
+        uint32_t zipKey;
+        if (!placeIndexFilename.empty() && parseZipKey(record.zipCode, zipKey)) {
+            placeNames.push_back(std::make_pair(record.placeName, zipKey));
+        }
+        ZipCodeRecord written;
+        bool parsed = parseWritten && DataFileReader::parseRecord(recordString.data(), recordString.size(), written);
+        for (size_t i = 0; parsed && i < numericIndexed.size(); ++i) {
+            SecondaryEntry numericEntry;
+            numericEntry.value = numericIndexed[i]->value(written);
+            numericEntry.offset = position;
+            numericEntries[i].push_back(numericEntry);
+        }
+        for (size_t i = 0; parsed && i < textIndexed.size(); ++i) {
+            textEntries[i].push_back(std::make_pair(textIndexed[i]->value(written), position));
+        }
+        uint32_t writtenKey;
+        if (parsed && parseZipKey(written.zipCode, writtenKey)) {
+            if (!stateZipFilename.empty()) {
+                StateZipEntry stateZip;
+                stateZip.key = writtenKey;
+                stateZip.state = written.state;
+                stateZip.offset = position;
+                stateZips.push_back(stateZip);
+            }
+            if (!coveringFilename.empty()) {
+                CoveredFields fields;
+                fields.key = writtenKey;
+                fields.state = written.state;
+                fields.latitude = written.latitude;
+                fields.longitude = written.longitude;
+                covered.push_back(fields);
+            }
+        }
         uint32_t recordLength = recordString.size();  // Length of the record (in bytes)
-        outputFile.write(reinterpret_cast<const char*>(&recordLength), sizeof(recordLength));  // Write the length
-        outputFile.write(recordString.c_str(), recordString.size());  // Write the record
+        if (concurrentIndexWrite && !indexFilename.empty()) {
+            body.append(reinterpret_cast<const char*>(&recordLength), sizeof(recordLength));  // The length
+            body.append(recordString);  // The record
+        } else {
+            writer.write(&recordLength, sizeof(recordLength));
+            writer.write(recordString.data(), recordString.size());
+        }
+        position += sizeof(recordLength) + recordLength;
+    }
+
+    // Step 3: Write the index, side by side with the buffered records if enabled
+    bool indexWritten = true;
+    std::thread indexThread;
+    if (!indexFilename.empty()) {
+        // Drop any open handle on the old index and its filter before replacing them
+        if (primaryIndexFilename == indexFilename) {
+            primaryIndex.reset();
+            primaryFilter.close();
+        }
+        if (concurrentIndexWrite) {
+            indexThread = std::thread([&]() {
+                indexWritten = writeIndexFiles(indexFilename, entries, indexType, source, outputFilename);
+            });
+        }
+    }
+    writer.write(body.data(), body.size());
+    bool dataWritten = writer.finish();
+    outputFile.reset();
+    if (indexThread.joinable()) {
+        indexThread.join();
+    } else if (!indexFilename.empty()) {
+        indexWritten = writeIndexFiles(indexFilename, entries, indexType, source, outputFilename);
     }
 
-    outputFile.close();
+    if (!dataWritten) {
+        std::cerr << "Error writing output file: " << outputFilename << std::endl;
+        return false;
+    }
+    if (!indexWritten) {
+        return false;
+    }
+    // Replace the data file only once its primary key index is in place, so a
+    // failed index write leaves the old data file and index together
+    if (dataReader.isOpen() && dataReader.getFilename() == outputFilename) {
+        dataReader.close();
+    }
+    if (!temporary.commit()) {
+        return false;
+    }
+    if (!placeIndexFilename.empty()) {
+        // Drop any open handle on the old index before replacing it
+        if (placeNameIndexFilename == placeIndexFilename) {
+            placeNameIndex.reset();
+        }
+        if (!PlaceNameIndex::write(placeIndexFilename, placeNames, source)) {
+            return false;
+        }
+    }
+    if (!stateZipFilename.empty()) {
+        // Drop any open handle on the old index before replacing it
+        if (stateZipIndexFilename == stateZipFilename) {
+            stateZipIndex.reset();
+        }
+        if (!StateZipIndex::write(stateZipFilename, stateZips, source)) {
+            return false;
+        }
+    }
+    if (!coveringFilename.empty()) {
+        // Drop any open handle on the old index before replacing it
+        if (coveringIndexFilename == coveringFilename) {
+            coveringIndex.reset();
+        }
+        if (!CoveringIndex::write(coveringFilename, covered, source)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < numericIndexed.size(); ++i) {
+        // Drop any open handle on the old index before replacing it
+        secondaryIndexes.erase(numericIndexed[i]->name);
+        if (!SecondaryIndex::write(secondaryIndexFilename(numericIndexed[i]->name), numericIndexed[i]->name,
+                                   numericEntries[i], source)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < textIndexed.size(); ++i) {
+        // Drop any open handle on the old index before replacing it
+        invertedIndexes.erase(textIndexed[i]->name);
+        if (!InvertedIndex::write(invertedIndexFilename(textIndexed[i]->name), textIndexed[i]->name,
+                                  textEntries[i], source)) {
+            return false;
+        }
+    }
+
+    // Step 4: Report the files only once every one of them is written
     std::cout << "Length-indicated file written successfully: " << outputFilename << std::endl;
+    if (!indexFilename.empty()) {
+        std::cout << "Primary key index file created successfully: " << indexFilename
+                  << " (" << primaryIndexTypeName(indexType) << ")" << std::endl;
+    }
+    if (!placeIndexFilename.empty()) {
+        std::cout << "Place name index file created successfully: " << placeIndexFilename << std::endl;
+    }
+    if (!stateZipFilename.empty()) {
+        std::cout << "State/zip index file created successfully: " << stateZipFilename << std::endl;
+    }
+    if (!coveringFilename.empty()) {
+        std::cout << "Covering index file created successfully: " << coveringFilename << std::endl;
+    }
+    for (const NumericField* field : numericIndexed) {
+        std::cout << "Secondary index file created successfully: " << secondaryIndexFilename(field->name) << std::endl;
+    }
+    for (const TextField* field : textIndexed) {
+        std::cout << "Inverted index file created successfully: " << invertedIndexFilename(field->name) << std::endl;
+    }
     return true;
 }
 
@@ -166,64 +463,29 @@ bool Buffer::convertToLengthIndicatedFile(const std::string& inputFilename, cons
  * @return true if the file is successfully loaded, false otherwise.
  */
 bool Buffer::loadFromLengthIndicatedFile(const std::string& filename) {
-    std::ifstream inputFile(filename, std::ios::binary);
-    if (!inputFile.is_open()) {
+    // Step 1: Open the file and validate its header
+    DataFileReader inputFile;
+    if (!inputFile.open(filename, IoWorkload::Scan)) {
         std::cerr << "Unable to open file: " << filename << std::endl;
         return false;
     }
 
-    // Step 1: Read the header fields
-    std::string fileType;
-    uint16_t version;
-    uint32_t headerSize;
-    uint32_t recordCount;
-
-    std::getline(inputFile, fileType, '\0');  // Read the null-terminated string
-    inputFile.read(reinterpret_cast<char*>(&version), sizeof(version));
-    inputFile.read(reinterpret_cast<char*>(&headerSize), sizeof(headerSize));
-    inputFile.read(reinterpret_cast<char*>(&recordCount), sizeof(recordCount));
-
     // Display the header information (for debugging purposes)
     std::cout << "Loading file: " << filename << std::endl;
-    std::cout << "File Type: " << fileType << std::endl;
-    std::cout << "Version: " << version << std::endl;
-    std::cout << "Header Size: " << headerSize << " bytes" << std::endl;
-    std::cout << "Record Count: " << recordCount << std::endl;
+    std::cout << "File Type: ZipCodeLengthIndicated" << std::endl;
+    std::cout << "Version: " << inputFile.getVersion() << std::endl;
+    std::cout << "Header Size: " << inputFile.getHeaderSize() << " bytes" << std::endl;
+    std::cout << "Record Count: " << inputFile.getRecordCount() << std::endl;
 
     // Step 2: Read each record based on its length
-    for (uint32_t i = 0; i < recordCount; ++i) {
-        uint32_t recordLength;
-        inputFile.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength));
-
-        std::vector<char> buffer(recordLength);
-        inputFile.read(buffer.data(), recordLength);
-
-        std::string recordString(buffer.begin(), buffer.end());
-        std::stringstream ss(recordString);
-
+    records.reserve(records.size() + inputFile.getRecordCount());
+    return inputFile.forEachRecord([this](uint64_t, const char* data, uint32_t length) {
         ZipCodeRecord record;
-        std::string lat, lng;
-
-        std::getline(ss, record.zipCode, ',');
-        std::getline(ss, record.placeName, ',');
-        std::getline(ss, record.state, ',');
-        std::getline(ss, record.county, ',');
-        std::getline(ss, lat, ',');
-        std::getline(ss, lng, ',');
-
-        try {
-            record.latitude = std::stod(lat);
-            record.longitude = std::stod(lng);
-        } catch (const std::invalid_argument& e) {
-            std::cerr << "Invalid lat/long value: " << e.what() << std::endl;
-            continue;
+        if (DataFileReader::parseRecord(data, length, record)) {
+            addRecord(record);
         }
-
-        records.push_back(record);
-    }
-
-    inputFile.close();
-    return true;
+        return true;
+    });
 }
 
 /**
@@ -231,140 +493,454 @@ bool Buffer::loadFromLengthIndicatedFile(const std::string& filename) {
  *
  * The primary key index is stored in a separate file and maps zip codes to file offsets.
  * This function searches for the zip code in the index and returns the file offset.
+ * The index is opened (and its format detected) on the first call and kept open;
+ * with the sorted binary format a lookup is a binary search over the mapped file,
+ * and with the B+ tree format it reads one page per tree level.
+ *
+ * When the index has an up-to-date Bloom filter next to it, the filter is
+ * consulted first: a zip code it rejects is certainly absent, so -1 is
+ * returned without searching the index. A missing or stale filter is
+ * simply not used.
  *
  * @param indexFilename The name of the index file.
+ * @param dataFilename The data file the index describes.
  * @param zipCode The zip code to search for.
  * @return The file offset if the zip code is found, -1 otherwise.
  */
-std::streampos Buffer::searchPrimaryKey(const std::string& indexFilename, const std::string& zipCode) {
-    std::ifstream indexFile(indexFilename);
-    if (!indexFile.is_open()) {
-        std::cerr << "Unable to open index file: " << indexFilename << std::endl;
+std::streampos Buffer::searchPrimaryKey(const std::string& indexFilename, const std::string& dataFilename,
+                                        const std::string& zipCode) {
+    if (!usePrimaryIndex(indexFilename, dataFilename)) {
         return -1;
     }
 
-    std::string currentZipCode;
-    std::streamoff fileOffset;  // Change to streamoff
+    uint32_t key;
+    if (!parseZipKey(zipCode, key)) {
+        return -1;  // Not a valid zip code, so it cannot be in the index
+    }
+    if (!primaryFilter.mayContain(key)) {
+        return -1;
+    }
+    int64_t fileOffset = primaryIndex->find(key);
+    return fileOffset < 0 ? std::streampos(-1) : std::streampos(static_cast<std::streamoff>(fileOffset));
+}
 
-    while (indexFile >> currentZipCode >> fileOffset) {
-        if (currentZipCode == zipCode) {
-            return std::streampos(fileOffset);  // Cast streamoff back to streampos
+/**
+ * @brief Searches for a batch of zip codes in the primary key index.
+ *
+ * Zip codes that do not parse or that the Bloom filter rejects are answered
+ * at once; the others go to the index in a single findMany call.
+ *
+ * @param indexFilename The name of the index file.
+ * @param dataFilename The data file the index describes.
+ * @param zipCodes The zip codes to search for.
+ * @return For each zip code, its file offset, or -1 if it is not found.
+ */
+std::vector<std::streampos> Buffer::searchPrimaryKeys(const std::string& indexFilename, const std::string& dataFilename,
+                                                      const std::vector<std::string>& zipCodes) {
+    std::vector<std::streampos> fileOffsets(zipCodes.size(), std::streampos(-1));
+    if (!usePrimaryIndex(indexFilename, dataFilename)) {
+        return fileOffsets;
+    }
+
+    std::vector<uint32_t> keys;
+    std::vector<size_t> positions;  // Position in zipCodes of each key
+    for (size_t i = 0; i < zipCodes.size(); ++i) {
+        uint32_t key;
+        if (parseZipKey(zipCodes[i], key) && primaryFilter.mayContain(key)) {
+            keys.push_back(key);
+            positions.push_back(i);
+        }
+    }
+    std::vector<int64_t> found(keys.size());
+    primaryIndex->findMany(keys.data(), keys.size(), found.data());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (found[i] >= 0) {
+            fileOffsets[positions[i]] = std::streampos(static_cast<std::streamoff>(found[i]));
         }
     }
+    return fileOffsets;
+}
 
-    return -1;  // Return -1 if the zip code is not found
+/**
+ * @brief Opens a cursor over the primary key index entries with zip codes in [low, high].
+ *
+ * The range is answered from the index alone: the ordered formats seek to
+ * low and read forward in key order, so only the entries in the range are
+ * visited. The Bloom filter is not consulted, since it can only rule out
+ * single keys.
+ *
+ * @param indexFilename The name of the index file.
+ * @param dataFilename The data file the index describes.
+ * @param low The smallest zip code of the range.
+ * @param high The largest zip code of the range.
+ * @return The cursor, or nullptr if the index cannot be opened or its format has no key order.
+ */
+std::unique_ptr<IndexCursor> Buffer::openPrimaryKeyRange(const std::string& indexFilename, const std::string& dataFilename,
+                                                         uint32_t low, uint32_t high) {
+    if (!usePrimaryIndex(indexFilename, dataFilename)) {
+        return nullptr;
+    }
+    std::unique_ptr<IndexCursor> cursor = primaryIndex->openRange(low, high);
+    if (!cursor) {
+        std::cerr << "The " << primaryIndexTypeName(primaryIndex->type())
+                  << " index format does not support range queries: " << indexFilename << std::endl;
+    }
+    return cursor;
 }
 
+/**
+ * @brief Opens the primary key index (and its Bloom filter) unless it is already open.
+ *
+ * @param indexFilename The name of the index file.
+ * @param dataFilename The data file the index describes.
+ * @return true if primaryIndex is open on indexFilename.
+ */
+bool Buffer::usePrimaryIndex(const std::string& indexFilename, const std::string& dataFilename) {
+    if (!primaryIndex || primaryIndexFilename != indexFilename || primaryDataFilename != dataFilename) {
+        primaryIndex = openPrimaryKeyIndex(indexFilename, dataFilename);
+        primaryIndexFilename = indexFilename;
+        primaryDataFilename = dataFilename;
+        if (!primaryIndex) {
+            return false;
+        }
+        openIndexBloomFilter(indexFilename, primaryFilter);
+    }
+    return true;
+}
 
 /**
  * @brief Reads a zip code record from the length-indicated file using the file offset.
  *
  * This function uses the file offset (retrieved from the primary key index) to locate
- * and read a zip code record from the length-indicated file.
+ * and read a zip code record from the length-indicated file. The data file is opened
+ * and its header validated on the first call; later calls for the same file reuse the
+ * open DataFileReader.
  *
  * @param dataFilename The name of the length-indicated file.
  * @param fileOffset The file offset where the record starts.
  * @return The ZipCodeRecord read from the file.
+ * @throws std::runtime_error if the file cannot be opened or the record cannot be read.
  */
 ZipCodeRecord Buffer::readRecordAtOffset(const std::string& dataFilename, std::streampos fileOffset) {
-    std::ifstream dataFile(dataFilename, std::ios::binary);
-    if (!dataFile.is_open()) {
-        std::cerr << "Unable to open data file: " << dataFilename << std::endl;
-        throw std::runtime_error("Failed to open data file");
+    ZipCodeRecord record;
+    if (!readRecordAtOffset(dataFilename, fileOffset, record)) {
+        throw std::runtime_error("Failed to read record from data file");
     }
+    return record;
+}
 
-    dataFile.seekg(fileOffset);  // Seek to the offset of the record
-
-    uint32_t recordLength;
-    dataFile.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength));  // Read the length of the record
-
-    std::vector<char> buffer(recordLength);
-    dataFile.read(buffer.data(), recordLength);  // Read the actual record
+/**
+ * @brief Opens the data file behind dataReader unless it is already open.
+ *
+ * @param dataFilename The name of the length-indicated file.
+ * @return false if the file cannot be opened; DataFileReader::open reports why.
+ */
+bool Buffer::useDataFile(const std::string& dataFilename) {
+    return (dataReader.isOpen() && dataReader.getFilename() == dataFilename) || dataReader.open(dataFilename);
+}
 
-    std::string recordString(buffer.begin(), buffer.end());
-    std::stringstream ss(recordString);
+/**
+ * @brief Reads a zip code record at a file offset into an existing record.
+ *
+ * Reusing the same record across calls lets its strings keep their capacity,
+ * so repeated lookups do not allocate.
+ *
+ * @param dataFilename The name of the length-indicated file.
+ * @param fileOffset The file offset where the record starts.
+ * @param record The record to fill in.
+ * @return true if the record was read, false otherwise.
+ */
+bool Buffer::readRecordAtOffset(const std::string& dataFilename, std::streampos fileOffset, ZipCodeRecord& record) {
+    if (!useDataFile(dataFilename)) {
+        return false;
+    }
 
-    ZipCodeRecord record;
-    std::string lat, lng;
+    if (fileOffset < 0 || !dataReader.readRecord(static_cast<uint64_t>(fileOffset), record)) {
+        std::cerr << "Unable to read record at offset " << fileOffset << " in " << dataFilename << std::endl;
+        return false;
+    }
+    return true;
+}
 
-    std::getline(ss, record.zipCode, ',');
-    std::getline(ss, record.placeName, ',');
-    std::getline(ss, record.state, ',');
-    std::getline(ss, record.county, ',');
-    std::getline(ss, lat, ',');
-    std::getline(ss, lng, ',');
+/**
+ * @brief Reads a batch of zip code records from the length-indicated file.
+ *
+ * The offsets are passed to DataFileReader::readRecords(), which submits
+ * every read before waiting for any of them.
+ *
+ * @param dataFilename The name of the length-indicated file.
+ * @param fileOffsets The file offsets of the records to read.
+ * @param results Receives the records, in the same order as fileOffsets.
+ * @return true if every record was read, false otherwise (including when the data file cannot be opened).
+ */
+bool Buffer::readRecordsAtOffsets(const std::string& dataFilename, const std::vector<std::streampos>& fileOffsets,
+                                  std::vector<ZipCodeRecord>& results) {
+    if (!useDataFile(dataFilename)) {
+        return false;
+    }
 
-    try {
-        record.latitude = std::stod(lat);
-        record.longitude = std::stod(lng);
-    } catch (const std::invalid_argument& e) {
-        std::cerr << "Invalid lat/long value: " << e.what() << std::endl;
-        throw;
+    std::vector<uint64_t> offsets;
+    offsets.reserve(fileOffsets.size());
+    for (const auto& fileOffset : fileOffsets) {
+        offsets.push_back(fileOffset < 0 ? 0 : static_cast<uint64_t>(fileOffset));
     }
 
-    dataFile.close();
-    return record;
+    results.resize(fileOffsets.size());
+    return dataReader.readRecords(offsets.data(), offsets.size(), results.data());
 }
 
 /**
  * @brief Creates a primary key index file from the length-indicated data file.
  *
  * This function creates an index file that stores zip codes and their corresponding
- * file offsets in the length-indicated data file.
+ * file offsets in the length-indicated data file. The data file is scanned once to
+ * collect the entries, which are then written in the format selected with
+ * setPrimaryIndexType. A Bloom filter over the same keys is written next to the
+ * index so searches for absent zip codes can skip it.
+ *
+ * With more than one build thread the data file is split into that many parts,
+ * whose keys are extracted and sorted on their own threads and then merged (see
+ * DataFileReader::forEachRecordPartitioned and sortIndexEntryParts). If the parts
+ * cannot be lined up the file is scanned on one thread instead. The text format
+ * keeps the entries in data file order, so they are only concatenated for it.
  *
  * @param dataFilename The name of the length-indicated file.
  * @param indexFilename The name of the primary key index file to be created.
  * @return true if the index file is successfully written, false otherwise.
  */
 bool Buffer::createPrimaryKeyIndex(const std::string& dataFilename, const std::string& indexFilename) {
-    std::ifstream dataFile(dataFilename, std::ios::binary);
-    if (!dataFile.is_open()) {
+    DataFileReader dataFile;
+    if (!dataFile.open(dataFilename, IoWorkload::Scan)) {
         std::cerr << "Unable to open data file: " << dataFilename << std::endl;
         return false;
     }
 
-    std::ofstream indexFile(indexFilename, std::ios::binary);
-    if (!indexFile.is_open()) {
-        std::cerr << "Unable to open index file: " << indexFilename << std::endl;
+    // Step through each record and save its zip code and file offset,
+    // one part of the file per thread
+    std::vector<std::vector<IndexEntry>> parts(indexBuildThreads);
+    for (auto& part : parts) {
+        part.reserve(dataFile.getRecordCount() / parts.size() + 1);
+    }
+    bool complete = parts.size() > 1 &&
+        dataFile.forEachRecordPartitioned(parts.size(), [&](size_t part, uint64_t fileOffset, const char* data, uint32_t length) {
+            IndexEntry entry;
+            if (parseRecordZipKey(data, length, entry.key)) {
+                entry.offset = fileOffset;
+                parts[part].push_back(entry);
+            }
+            return true;
+        });
+    if (!complete) {
+        parts.assign(1, std::vector<IndexEntry>());
+        parts[0].reserve(dataFile.getRecordCount());
+        complete = dataFile.forEachRecord([&](uint64_t fileOffset, const char* data, uint32_t length) {
+            IndexEntry entry;
+            if (parseRecordZipKey(data, length, entry.key)) {
+                entry.offset = fileOffset;
+                parts[0].push_back(entry);
+            }
+            return true;
+        });
+    }
+    if (!complete) {
+        std::cerr << "Data file is truncated: " << dataFilename << std::endl;
         return false;
     }
 
-    // Skip the header of the data file
-    std::string fileType;
-    uint16_t version;
-    uint32_t headerSize;
-    uint32_t recordCount;
+    std::vector<IndexEntry> entries;
+    if (indexType == PrimaryIndexType::Text) {
+        for (const auto& part : parts) {
+            entries.insert(entries.end(), part.begin(), part.end());
+        }
+    } else {
+        sortIndexEntryParts(parts, entries);
+    }
 
-    std::getline(dataFile, fileType, '\0');  // Read the null-terminated string
-    dataFile.read(reinterpret_cast<char*>(&version), sizeof(version));
-    dataFile.read(reinterpret_cast<char*>(&headerSize), sizeof(headerSize));
-    dataFile.read(reinterpret_cast<char*>(&recordCount), sizeof(recordCount));
+    // Drop any open handle on the old index and its filter before replacing them
+    if (primaryIndexFilename == indexFilename) {
+        primaryIndex.reset();
+        primaryFilter.close();
+    }
+    if (!writeIndexFiles(indexFilename, entries, indexType, dataFile.getSourceStamp(), dataFilename)) {
+        return false;
+    }
+    std::cout << "Primary key index file created successfully: " << indexFilename
+              << " (" << primaryIndexTypeName(indexType) << ")" << std::endl;
+    return true;
+}
 
-    // Step through each record and save its zip code and file offset to the index file
-    for (uint32_t i = 0; i < recordCount; ++i) {
-        std::streampos fileOffset = dataFile.tellg();  // Save the current file position
+/**
+ * @brief Looks up a zip code's state and coordinates in the covering index.
+ *
+ * The lookup is a binary search over the mapped covering index; no record
+ * offset is followed, so the data file is never opened.
+ *
+ * @param coveringFilename The name of the covering index file.
+ * @param zipCode The zip code to search for.
+ * @param fields Receives the state and coordinates if the zip code is found.
+ * @return true if the zip code is found.
+ */
+bool Buffer::searchCoveringIndex(const std::string& coveringFilename, const std::string& zipCode, CoveredFields& fields) {
+    if (!coveringIndex || coveringIndexFilename != coveringFilename) {
+        coveringIndexFilename = coveringFilename;
+        coveringIndex.reset(new CoveringIndex);
+        if (!coveringIndex->open(coveringFilename)) {
+            coveringIndex.reset();
+            std::cerr << "Unable to open covering index: " << coveringFilename << std::endl;
+            return false;
+        }
+    }
 
-        uint32_t recordLength;
-        dataFile.read(reinterpret_cast<char*>(&recordLength), sizeof(recordLength));
+    uint32_t key;
+    return parseZipKey(zipCode, key) && coveringIndex->find(key, fields);
+}
 
-        std::vector<char> buffer(recordLength);
-        dataFile.read(buffer.data(), recordLength);  // Read the actual record
+/**
+ * @brief Opens a cursor over one state's entries with zip codes in [low, high].
+ *
+ * The state is found in the index's directory and its zip codes are a
+ * contiguous run of entries, so only the entries returned are read.
+ *
+ * @param indexFilename The name of the state/zip index file.
+ * @param state The state abbreviation.
+ * @param low The smallest zip code of the range.
+ * @param high The largest zip code of the range.
+ * @return The cursor, or nullptr if the index cannot be opened.
+ */
+std::unique_ptr<IndexCursor> Buffer::openStateZipRange(const std::string& indexFilename, const std::string& state,
+                                                       uint32_t low, uint32_t high) {
+    if (!useStateZipIndex(indexFilename)) {
+        return nullptr;
+    }
+    return stateZipIndex->openRange(state, low, high);
+}
 
-        std::string recordString(buffer.begin(), buffer.end());
-        std::stringstream ss(recordString);
+/**
+ * @brief Returns the states in the state/zip index, in name order.
+ *
+ * @param indexFilename The name of the state/zip index file.
+ * @param states Receives the state abbreviations.
+ * @return false if the index cannot be opened.
+ */
+bool Buffer::getIndexedStates(const std::string& indexFilename, std::vector<std::string>& states) {
+    if (!useStateZipIndex(indexFilename)) {
+        return false;
+    }
+    states = stateZipIndex->states();
+    return true;
+}
 
-        std::string zipCode;
-        std::getline(ss, zipCode, ',');
+/**
+ * @brief Opens a cursor over the records whose field value is in [low, high], in value order.
+ *
+ * The range is found with two binary searches over the field's mapped
+ * secondary index; the cursor then walks the entries between them.
+ *
+ * @param field The name of an indexed numeric field.
+ * @param low The smallest value of the range.
+ * @param high The largest value of the range.
+ * @return The cursor, or nullptr if the field has no secondary index.
+ */
+std::unique_ptr<SecondaryCursor> Buffer::openSecondaryRange(const std::string& field, double low, double high) {
+    std::unique_ptr<SecondaryIndex>& index = secondaryIndexes[field];
+    if (!index) {
+        std::string filename = secondaryIndexFilename(field);
+        index.reset(new SecondaryIndex);
+        if (!findNumericField(field) || !index->open(filename)) {
+            secondaryIndexes.erase(field);
+            std::cerr << "Unable to open secondary index: " << filename << std::endl;
+            return nullptr;
+        }
+    }
+    return std::unique_ptr<SecondaryCursor>(new SecondaryCursor(index->openRange(low, high)));
+}
 
-        indexFile << zipCode << " " << fileOffset << "\n";  // Write the zip code and file offset to the index file
+/**
+ * @brief Opens a cursor over the records matching every (field, value) pair, in data file order.
+ *
+ * Each value's posting list is found with a binary search over its field's
+ * term directory. The lists are then intersected as they are decoded, so
+ * no record is read to answer the query.
+ *
+ * @param terms (text field name, value) pairs; values are compared without regard to case.
+ * @return The cursor, or nullptr if a field has no inverted index.
+ */
+std::unique_ptr<PostingIntersection> Buffer::openInvertedLists(const std::vector<std::pair<std::string, std::string>>& terms) {
+    std::vector<PostingCursor> lists;
+    for (const auto& term : terms) {
+        std::unique_ptr<InvertedIndex>& index = invertedIndexes[term.first];
+        if (!index) {
+            std::string filename = invertedIndexFilename(term.first);
+            index.reset(new InvertedIndex);
+            if (!findTextField(term.first) || !index->open(filename)) {
+                invertedIndexes.erase(term.first);
+                std::cerr << "Unable to open inverted index: " << filename << std::endl;
+                return nullptr;
+            }
+        }
+        lists.push_back(index->openList(term.second));
     }
+    return std::unique_ptr<PostingIntersection>(new PostingIntersection(lists));
+}
 
-    dataFile.close();
-    indexFile.close();
-    std::cout << "Primary key index file created successfully: " << indexFilename << std::endl;
+/**
+ * @brief Finds the place names that start with a prefix, with their zip codes.
+ *
+ * @param indexFilename The place name index file.
+ * @param prefix The typed prefix; case does not matter.
+ * @param limit The most completions to return.
+ * @param completions Receives the names with the most zip codes first.
+ * @return false if the index cannot be opened.
+ */
+bool Buffer::completePlaceName(const std::string& indexFilename, const std::string& prefix, size_t limit,
+                               std::vector<PlaceCompletion>& completions) {
+    if (!placeNameIndex || placeNameIndexFilename != indexFilename) {
+        placeNameIndexFilename = indexFilename;
+        placeNameIndex.reset(new PlaceNameIndex);
+        if (!placeNameIndex->open(indexFilename)) {
+            placeNameIndex.reset();
+            std::cerr << "Unable to open place name index: " << indexFilename << std::endl;
+            return false;
+        }
+    }
+    placeNameIndex->complete(prefix, limit, completions);
     return true;
 }
 
+/**
+ * @brief Opens the state/zip index unless it is already open.
+ *
+ * @param indexFilename The name of the state/zip index file.
+ * @return true if stateZipIndex is open on indexFilename.
+ */
+bool Buffer::useStateZipIndex(const std::string& indexFilename) {
+    if (!stateZipIndex || stateZipIndexFilename != indexFilename) {
+        stateZipIndexFilename = indexFilename;
+        stateZipIndex.reset(new StateZipIndex);
+        if (!stateZipIndex->open(indexFilename)) {
+            stateZipIndex.reset();
+            std::cerr << "Unable to open state/zip index: " << indexFilename << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes a primary key index and its Bloom filter.
+ *
+ * The old filter is removed first, so if the new index is written but its
+ * filter is not, lookups run without a filter rather than with one built
+ * for other keys. Touches no Buffer state, so it can run on a thread of
+ * its own.
+ */
+bool Buffer::writeIndexFiles(const std::string& indexFilename, std::vector<IndexEntry>& entries,
+                             PrimaryIndexType type, const SourceStamp& source, const std::string& dataFilename) {
+    return removeIndexBloomFilter(indexFilename) &&
+           writePrimaryKeyIndex(indexFilename, entries, type, dataFilename) &&
+           writeIndexBloomFilter(indexFilename, entries, source);
+}
+
 
 
 
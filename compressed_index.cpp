@@ -0,0 +1,402 @@
+/**
+ * @file compressed_index.cpp
+ * @brief Implementation of the EliasFanoSequence and CompressedIndex classes.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "compressed_index.h"
+#include <algorithm>
+#include <cstring>
+
+const uint32_t EliasFanoSequence::kZeroSampleRate;
+const char CompressedIndex::kFileType[] = "ZipCodeCompressedIndex";
+const uint32_t CompressedIndex::kOffsetBlockSize;
+
+namespace {
+
+// Key count, low bit count, high words, low words, sample count, padding, universe
+const size_t kSequenceParametersSize = 6 * sizeof(uint32_t) + sizeof(uint64_t);
+
+// Block count, packed word count
+const size_t kOffsetParametersSize = 2 * sizeof(uint32_t);
+
+unsigned popcount(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcountll(word));
+#else
+    unsigned bits = 0;
+    for (; word; word &= word - 1) {
+        ++bits;
+    }
+    return bits;
+#endif
+}
+
+unsigned trailingZeros(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+    unsigned zeros = 0;
+    while (!(word & 1)) {
+        word >>= 1;
+        ++zeros;
+    }
+    return zeros;
+#endif
+}
+
+uint64_t lowMask(uint32_t width) {
+    return width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+}
+
+uint32_t bitWidth(uint64_t value) {
+    uint32_t width = 0;
+    while (value) {
+        value >>= 1;
+        ++width;
+    }
+    return width;
+}
+
+// Reads width bits at bit position; words must have a spare word at the end
+uint64_t readBits(const uint64_t* words, uint64_t position, uint32_t width) {
+    if (width == 0) {
+        return 0;
+    }
+    uint64_t word = position >> 6;
+    unsigned shift = static_cast<unsigned>(position & 63);
+    uint64_t value = words[word] >> shift;
+    if (shift + width > 64) {
+        value |= words[word + 1] << (64 - shift);
+    }
+    return value & lowMask(width);
+}
+
+void writeBits(std::vector<uint64_t>& words, uint64_t position, uint32_t width, uint64_t value) {
+    if (width == 0) {
+        return;
+    }
+    uint64_t word = position >> 6;
+    unsigned shift = static_cast<unsigned>(position & 63);
+    words[word] |= value << shift;
+    if (shift + width > 64) {
+        words[word + 1] |= value >> (64 - shift);
+    }
+}
+
+} // namespace
+
+EliasFanoSequence::EliasFanoSequence()
+    : high(nullptr), low(nullptr), samples(nullptr), count(0), lowBits(0),
+      highWords(0), lowWords(0), sampleCount(0), universe(0) {}
+
+void EliasFanoSequence::build(const uint32_t* sortedKeys, size_t keyCount) {
+    count = keyCount;
+    universe = count ? static_cast<uint64_t>(sortedKeys[count - 1]) + 1 : 0;
+    lowBits = 0;
+    while (count && (universe >> (lowBits + 1)) >= count) {
+        ++lowBits;   // floor(log2(universe / count))
+    }
+
+    uint64_t highBits = count + (universe >> lowBits) + 1;
+    highWords = static_cast<uint32_t>((highBits + 63) / 64 + 1);
+    lowWords = static_cast<uint32_t>((count * lowBits + 63) / 64 + 1);
+    ownedHigh.assign(highWords, 0);
+    ownedLow.assign(lowWords, 0);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t bit = (sortedKeys[i] >> lowBits) + i;
+        ownedHigh[bit >> 6] |= uint64_t(1) << (bit & 63);
+        writeBits(ownedLow, i * lowBits, lowBits, sortedKeys[i] & lowMask(lowBits));
+    }
+
+    // Sample every kZeroSampleRate-th zero of the high bits
+    ownedSamples.clear();
+    uint64_t zeros = 0;
+    for (uint64_t bit = 0; bit < highBits; ++bit) {
+        if (!(ownedHigh[bit >> 6] & (uint64_t(1) << (bit & 63)))) {
+            if (zeros % kZeroSampleRate == 0) {
+                ownedSamples.push_back(static_cast<uint32_t>(bit));
+            }
+            ++zeros;
+        }
+    }
+    sampleCount = static_cast<uint32_t>(ownedSamples.size());
+    high = ownedHigh.data();
+    low = ownedLow.data();
+    samples = ownedSamples.data();
+}
+
+bool EliasFanoSequence::write(SequentialWriter& writer) const {
+    uint32_t parameters[6] = { static_cast<uint32_t>(count), lowBits, highWords, lowWords, sampleCount, 0 };
+    writer.write(parameters, sizeof(parameters));
+    writer.write(&universe, sizeof(universe));
+    writer.write(high, highWords * sizeof(uint64_t));
+    writer.write(low, lowWords * sizeof(uint64_t));
+    writer.write(samples, sampleCount * sizeof(uint32_t));
+    const char padding[sizeof(uint32_t)] = {};
+    return writer.write(padding, (sampleCount % 2) * sizeof(uint32_t));
+}
+
+uint64_t EliasFanoSequence::attach(const char* data, uint64_t size) {
+    if (size < kSequenceParametersSize) {
+        return 0;
+    }
+    uint32_t parameters[6];
+    std::memcpy(parameters, data, sizeof(parameters));
+    std::memcpy(&universe, data + sizeof(parameters), sizeof(universe));
+    uint64_t used = kSequenceParametersSize +
+                    (static_cast<uint64_t>(parameters[2]) + parameters[3]) * sizeof(uint64_t) +
+                    (static_cast<uint64_t>(parameters[4]) + parameters[4] % 2) * sizeof(uint32_t);
+    if (used > size || parameters[1] > 32 || parameters[2] == 0 || parameters[3] == 0 ||
+        (parameters[0] != 0 && parameters[4] == 0) || universe > (uint64_t(1) << 32)) {
+        return 0;
+    }
+    // The high bits, the low bits (with their spare word) and the zero samples
+    // must cover every key below universe, or a lookup would read past them
+    uint64_t buckets = universe >> parameters[1];
+    uint64_t highBits = parameters[0] + buckets + 1;
+    if (static_cast<uint64_t>(parameters[2]) * 64 < highBits ||
+        parameters[3] <= (static_cast<uint64_t>(parameters[0]) * parameters[1] + 63) / 64 ||
+        parameters[4] < (buckets + kZeroSampleRate - 1) / kZeroSampleRate) {
+        return 0;
+    }
+    const uint32_t* sampleData = reinterpret_cast<const uint32_t*>(
+        data + kSequenceParametersSize + (static_cast<uint64_t>(parameters[2]) + parameters[3]) * sizeof(uint64_t));
+    for (uint32_t i = 0; i < parameters[4]; ++i) {
+        if (sampleData[i] >= highBits) {
+            return 0;
+        }
+    }
+    std::vector<uint64_t>().swap(ownedHigh);
+    std::vector<uint64_t>().swap(ownedLow);
+    std::vector<uint32_t>().swap(ownedSamples);
+    count = parameters[0];
+    lowBits = parameters[1];
+    highWords = parameters[2];
+    lowWords = parameters[3];
+    sampleCount = parameters[4];
+    high = reinterpret_cast<const uint64_t*>(data + kSequenceParametersSize);
+    low = high + highWords;
+    samples = reinterpret_cast<const uint32_t*>(low + lowWords);
+    return used;
+}
+
+uint64_t EliasFanoSequence::selectZero(uint64_t rank) const {
+    uint64_t position = samples[rank / kZeroSampleRate];
+    uint64_t remaining = rank % kZeroSampleRate;
+    if (remaining == 0) {
+        return position;
+    }
+    // Count the zeros after the sample a word at a time
+    ++position;
+    uint64_t word = position >> 6;
+    uint64_t zeros = ~high[word] & (~uint64_t(0) << (position & 63));
+    for (;;) {
+        unsigned found = popcount(zeros);
+        if (found >= remaining) {
+            while (--remaining) {
+                zeros &= zeros - 1;
+            }
+            return (word << 6) + trailingZeros(zeros);
+        }
+        remaining -= found;
+        zeros = ~high[++word];
+    }
+}
+
+uint64_t EliasFanoSequence::nextOne(uint64_t bit) const {
+    uint64_t word = bit >> 6;
+    uint64_t ones = high[word] & (~uint64_t(0) << (bit & 63));
+    while (ones == 0) {
+        ones = high[++word];
+    }
+    return (word << 6) + trailingZeros(ones);
+}
+
+uint32_t EliasFanoSequence::keyAt(const Position& position) const {
+    uint64_t bucket = position.bit - position.index;
+    return static_cast<uint32_t>((bucket << lowBits) | readBits(low, position.index * lowBits, lowBits));
+}
+
+/**
+ * @brief Finds the first key not less than key.
+ *
+ * The keys of bucket h = key >> lowBits are the ones following the h-th
+ * zero of the high bits (or the start, for bucket 0); they are compared in
+ * turn, and if all are smaller the answer is the first key of a later bucket.
+ */
+bool EliasFanoSequence::seek(uint32_t key, Position& position) const {
+    if (key >= universe) {
+        return false;
+    }
+    uint64_t bucket = key >> lowBits;
+    position.bit = bucket == 0 ? 0 : selectZero(bucket - 1) + 1;
+    position.index = position.bit - bucket;
+    while (high[position.bit >> 6] & (uint64_t(1) << (position.bit & 63))) {
+        if (keyAt(position) >= key) {
+            return true;
+        }
+        ++position.bit;
+        ++position.index;
+    }
+    if (position.index >= count) {
+        return false;
+    }
+    position.bit = nextOne(position.bit);
+    return true;
+}
+
+bool EliasFanoSequence::advance(Position& position) const {
+    if (position.index + 1 >= count) {
+        return false;
+    }
+    ++position.index;
+    position.bit = nextOne(position.bit + 1);
+    return true;
+}
+
+int64_t EliasFanoSequence::find(uint32_t key) const {
+    Position position;
+    if (seek(key, position) && keyAt(position) == key) {
+        return static_cast<int64_t>(position.index);
+    }
+    return -1;
+}
+
+size_t EliasFanoSequence::memoryUsage() const {
+    return (static_cast<size_t>(highWords) + lowWords) * sizeof(uint64_t) + sampleCount * sizeof(uint32_t);
+}
+
+/**
+ * @brief Maps an existing compressed index file.
+ */
+bool CompressedIndex::open(const std::string& filename) {
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != 1) {
+        return false;
+    }
+    uint64_t used = keys.attach(file.data() + header.headerSize, file.size() - header.headerSize);
+    if (used == 0 || keys.size() != header.entryCount) {
+        return false;
+    }
+    uint64_t offsetsAt = header.headerSize + used;
+    if (file.size() < offsetsAt + kOffsetParametersSize) {
+        return false;
+    }
+    uint32_t parameters[2];
+    std::memcpy(parameters, file.data() + offsetsAt, sizeof(parameters));
+    uint64_t blocksAt = offsetsAt + kOffsetParametersSize;
+    uint64_t wordsAt = blocksAt + static_cast<uint64_t>(parameters[0]) * sizeof(OffsetBlock);
+    if (parameters[0] != (keys.size() + kOffsetBlockSize - 1) / kOffsetBlockSize ||
+        file.size() < wordsAt + static_cast<uint64_t>(parameters[1]) * sizeof(uint64_t)) {
+        return false;
+    }
+    // Each block's packed values, plus the spare word after them, must lie within the packed words
+    const OffsetBlock* frames = reinterpret_cast<const OffsetBlock*>(file.data() + blocksAt);
+    for (uint32_t i = 0; i < parameters[0]; ++i) {
+        uint64_t values = std::min<uint64_t>(kOffsetBlockSize, keys.size() - static_cast<uint64_t>(i) * kOffsetBlockSize);
+        if (frames[i].width > 64 ||
+            frames[i].firstWord + (values * frames[i].width + 63) / 64 >= parameters[1]) {
+            return false;
+        }
+    }
+    blocks = frames;
+    offsetWords = reinterpret_cast<const uint64_t*>(file.data() + wordsAt);
+    return true;
+}
+
+/**
+ * @class CompressedIndex::RangeCursor
+ * @brief Decodes keys and offsets in order until a key exceeds the range.
+ */
+class CompressedIndex::RangeCursor : public IndexCursor {
+public:
+    RangeCursor(const CompressedIndex& owner, uint32_t low, uint32_t high)
+        : index(owner), high(high) {
+        valid = low <= high && index.keys.seek(low, position);
+    }
+
+    bool next(IndexEntry& entry) override {
+        if (!valid) {
+            return false;
+        }
+        entry.key = index.keys.keyAt(position);
+        if (entry.key > high) {
+            valid = false;
+            return false;
+        }
+        entry.offset = index.offsetAt(position.index);
+        valid = index.keys.advance(position);
+        return true;
+    }
+
+private:
+    const CompressedIndex& index;
+    EliasFanoSequence::Position position;
+    uint32_t high;
+    bool valid;   /**< position holds the next key to return. */
+};
+
+uint64_t CompressedIndex::offsetAt(uint64_t index) const {
+    const OffsetBlock& block = blocks[index / kOffsetBlockSize];
+    uint64_t position = static_cast<uint64_t>(block.firstWord) * 64 + (index % kOffsetBlockSize) * block.width;
+    return block.base + readBits(offsetWords, position, block.width);
+}
+
+int64_t CompressedIndex::find(uint32_t key) const {
+    int64_t index = keys.find(key);
+    return index < 0 ? -1 : static_cast<int64_t>(offsetAt(static_cast<uint64_t>(index)));
+}
+
+std::unique_ptr<IndexCursor> CompressedIndex::openRange(uint32_t low, uint32_t high) const {
+    return std::unique_ptr<IndexCursor>(new RangeCursor(*this, low, high));
+}
+
+bool CompressedIndex::write(SequentialWriter& writer, std::vector<IndexEntry>& entries) {
+    sortIndexEntries(entries);
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return a.key == b.key;
+    }), entries.end());
+
+    std::vector<uint32_t> sortedKeys(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        sortedKeys[i] = entries[i].key;
+    }
+    EliasFanoSequence sequence;
+    sequence.build(sortedKeys.data(), sortedKeys.size());
+
+    // Frame each block of offsets by its smallest value and pack the differences
+    std::vector<OffsetBlock> blocks;
+    std::vector<uint64_t> words;
+    for (size_t first = 0; first < entries.size(); first += kOffsetBlockSize) {
+        size_t last = std::min(entries.size(), first + kOffsetBlockSize);
+        uint64_t base = entries[first].offset;
+        uint64_t top = base;
+        for (size_t i = first; i < last; ++i) {
+            base = std::min(base, entries[i].offset);
+            top = std::max(top, entries[i].offset);
+        }
+        OffsetBlock block;
+        block.base = base;
+        block.firstWord = static_cast<uint32_t>(words.size());
+        block.width = bitWidth(top - base);
+        blocks.push_back(block);
+        words.resize(words.size() + ((last - first) * block.width + 63) / 64, 0);
+        for (size_t i = first; i < last; ++i) {
+            writeBits(words, static_cast<uint64_t>(block.firstWord) * 64 + (i - first) * block.width,
+                      block.width, entries[i].offset - base);
+        }
+    }
+    words.push_back(0);   // Spare word so a read may span past the last value
+
+    writeIndexHeader(writer, kFileType, 1, static_cast<uint32_t>(entries.size()));
+    sequence.write(writer);
+    uint32_t parameters[2] = { static_cast<uint32_t>(blocks.size()), static_cast<uint32_t>(words.size()) };
+    writer.write(parameters, sizeof(parameters));
+    writer.write(blocks.data(), blocks.size() * sizeof(OffsetBlock));
+    return writer.write(words.data(), words.size() * sizeof(uint64_t));
+}
@@ -0,0 +1,211 @@
+/**
+ * @file compressed_index.h
+ * @brief Header file for the EliasFanoSequence and CompressedIndex classes.
+ *
+ * The sorted binary index spends 12 bytes per zip code, although the
+ * sorted zip codes are dense and record offsets only need as many bits as
+ * the data file is long. The compressed index stores the keys with
+ * Elias-Fano coding (about 2 + log2(universe / count) bits per key) and
+ * the offsets bit-packed in blocks, and searches both in place, so the
+ * national index is small enough to stay in cache.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef COMPRESSED_INDEX_H
+#define COMPRESSED_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+#include "primary_key_index.h"
+
+/**
+ * @class EliasFanoSequence
+ * @brief Sorted distinct keys in Elias-Fano coding, searchable without decoding.
+ *
+ * Each key is split into its low lowBits bits, stored verbatim in a packed
+ * array, and its high part h, stored in unary: key i sets bit h + i of the
+ * high bit vector, so the keys of bucket h follow the h-th zero. Every
+ * kZeroSampleRate-th zero position is sampled, so a search jumps close to
+ * its bucket and counts the remaining zeros a word at a time, then
+ * compares the few keys of the bucket.
+ *
+ * Like EytzingerLayout, the sequence either owns its words (after build())
+ * or views words stored in a mapped file (after attach()).
+ */
+class EliasFanoSequence {
+public:
+    static const uint32_t kZeroSampleRate = 256;   /**< Zeros between select samples. */
+
+    EliasFanoSequence();
+
+    /**
+     * @brief Encodes sorted distinct keys.
+     * @param sortedKeys The keys, in ascending order without duplicates.
+     * @param count Number of keys.
+     */
+    void build(const uint32_t* sortedKeys, size_t count);
+
+    /**
+     * @brief Writes the parameters and words, a multiple of 8 bytes in total.
+     */
+    bool write(SequentialWriter& writer) const;
+
+    /**
+     * @brief Uses a sequence stored in a mapped file.
+     * @param data Start of the data written by write(), 8-byte aligned.
+     * @param size Bytes available from data.
+     * @return The bytes used, or 0 if the data is not a valid sequence.
+     */
+    uint64_t attach(const char* data, uint64_t size);
+
+    /**
+     * @struct Position
+     * @brief A key's place in the sequence.
+     */
+    struct Position {
+        uint64_t index;   /**< Position in the sorted keys. */
+        uint64_t bit;     /**< The key's one bit in the high bits. */
+    };
+
+    /**
+     * @brief Finds a key.
+     * @return Its position in the sorted keys, or -1 if it is not present.
+     */
+    int64_t find(uint32_t key) const;
+
+    /**
+     * @brief Finds the first key not less than key.
+     * @return false if every key is smaller.
+     */
+    bool seek(uint32_t key, Position& position) const;
+
+    /**
+     * @brief Moves to the next key.
+     * @return false if position held the last key.
+     */
+    bool advance(Position& position) const;
+
+    /**
+     * @brief Decodes the key at a position.
+     */
+    uint32_t keyAt(const Position& position) const;
+
+    /**
+     * @brief Returns the number of keys.
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief Returns the bytes used by the encoded keys and samples.
+     */
+    size_t memoryUsage() const;
+
+private:
+    /**
+     * @brief Returns the position in the high bits of the rank-th zero (0-based).
+     */
+    uint64_t selectZero(uint64_t rank) const;
+
+    /**
+     * @brief Returns the position of the first one in the high bits at or after bit.
+     */
+    uint64_t nextOne(uint64_t bit) const;
+
+    std::vector<uint64_t> ownedHigh;     /**< Storage after build(). */
+    std::vector<uint64_t> ownedLow;
+    std::vector<uint32_t> ownedSamples;
+    const uint64_t* high;                /**< Unary-coded high parts, one spare word at the end. */
+    const uint64_t* low;                 /**< Packed low parts, one spare word at the end. */
+    const uint32_t* samples;             /**< Position of zero number i * kZeroSampleRate. */
+    size_t count;
+    uint32_t lowBits;
+    uint32_t highWords;                  /**< Words in high, including the spare. */
+    uint32_t lowWords;                   /**< Words in low, including the spare. */
+    uint32_t sampleCount;
+    uint64_t universe;                   /**< One more than the largest key. */
+};
+
+/**
+ * @class CompressedIndex
+ * @brief Memory-mapped primary key index with compressed keys and offsets.
+ *
+ * The file holds the binary index header, the EliasFanoSequence of the
+ * keys, and the offsets in key order, split into blocks of kOffsetBlockSize.
+ * Each block stores its smallest offset and the bit width of the largest
+ * difference from it, followed by the differences bit-packed at that width.
+ * Offsets of records stored in random order need about log2(file size)
+ * bits; offsets of a data file sorted by zip code are close together
+ * within a block and pack much tighter.
+ */
+class CompressedIndex : public PrimaryKeyIndex {
+public:
+    static const char kFileType[];                 /**< File type stored in the index header. */
+    static const uint32_t kOffsetBlockSize = 128;  /**< Offsets per bit-packed block. */
+
+    /**
+     * @brief Maps an existing compressed index file.
+     * @return false if the file cannot be mapped or is not a compressed index.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Looks up a zip code.
+     * @return The record's file offset, or -1 if the zip code is not in the index.
+     */
+    int64_t find(uint32_t key) const override;
+
+    /**
+     * @brief Returns the number of keys in the index.
+     */
+    size_t size() const override { return keys.size(); }
+
+    /**
+     * @brief Returns PrimaryIndexType::Compressed.
+     */
+    PrimaryIndexType type() const override { return PrimaryIndexType::Compressed; }
+
+    /**
+     * @brief Opens a cursor that decodes keys and offsets in order from the first key not less than low.
+     */
+    std::unique_ptr<IndexCursor> openRange(uint32_t low, uint32_t high) const override;
+
+    /**
+     * @brief Writes a compressed index.
+     *
+     * @param writer Destination, positioned at the start of the file.
+     * @param entries The entries in data file order; sorted in place, keeping the first of any duplicate keys.
+     * @return true if the file was written.
+     */
+    static bool write(SequentialWriter& writer, std::vector<IndexEntry>& entries);
+
+private:
+    class RangeCursor;
+
+    /**
+     * @brief Decodes the offset of the key at a position in the sorted keys.
+     */
+    uint64_t offsetAt(uint64_t index) const;
+
+    /**
+     * @struct OffsetBlock
+     * @brief Frame of one block of offsets, as stored in the file.
+     */
+    struct OffsetBlock {
+        uint64_t base;        /**< Smallest offset in the block. */
+        uint32_t firstWord;   /**< Index of the block's first packed word. */
+        uint32_t width;       /**< Bits per packed difference. */
+    };
+
+    MappedFile file;
+    EliasFanoSequence keys;
+    const OffsetBlock* blocks = nullptr;
+    const uint64_t* offsetWords = nullptr;
+};
+
+#endif // COMPRESSED_INDEX_H
@@ -0,0 +1,128 @@
+/**
+ * @file covering_index.cpp
+ * @brief Implementation of the CoveringIndex class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "covering_index.h"
+#include "primary_key_index.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+const char CoveringIndex::kFileType[] = "ZipCodeCoveringIndex";
+const double CoveringIndex::kCoordinateScale = 1000000.0;
+const size_t CoveringIndex::kStateNameSize;
+
+namespace {
+
+// State count, padding and source stamp follow the index header
+const size_t kParametersSize = 2 * sizeof(uint32_t) + SourceStamp::kEncodedSize;
+
+int32_t toFixedPoint(double degrees) {
+    return static_cast<int32_t>(std::lround(degrees * CoveringIndex::kCoordinateScale));
+}
+
+} // namespace
+
+/**
+ * @brief Maps an existing covering index file.
+ */
+bool CoveringIndex::open(const std::string& filename) {
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != 1 ||
+        file.size() < header.headerSize + kParametersSize) {
+        return false;
+    }
+    uint32_t states;
+    std::memcpy(&states, file.data() + header.headerSize, sizeof(states));
+    uint64_t namesAt = header.headerSize + kParametersSize;
+    uint64_t entriesAt = namesAt + static_cast<uint64_t>(states) * kStateNameSize;
+    if (file.size() < entriesAt + static_cast<uint64_t>(header.entryCount) * sizeof(Entry)) {
+        return false;
+    }
+    source.decode(file.data() + header.headerSize + 2 * sizeof(uint32_t));
+    stateCount = states;
+    count = header.entryCount;
+    stateNames = file.data() + namesAt;
+    entries = reinterpret_cast<const Entry*>(file.data() + entriesAt);
+    return true;
+}
+
+bool CoveringIndex::find(uint32_t key, CoveredFields& fields) const {
+    const Entry* end = entries + count;
+    const Entry* entry = std::lower_bound(entries, end, key, [](const Entry& e, uint32_t k) {
+        return e.key < k;
+    });
+    if (entry == end || entry->key != key) {
+        return false;
+    }
+    fields.key = entry->key;
+    if (entry->state < stateCount) {
+        const char* name = stateNames + entry->state * kStateNameSize;
+        fields.state.assign(name, strnlen(name, kStateNameSize));
+    } else {
+        fields.state.clear();
+    }
+    fields.latitude = entry->latitude / kCoordinateScale;
+    fields.longitude = entry->longitude / kCoordinateScale;
+    return true;
+}
+
+bool CoveringIndex::write(const std::string& filename, std::vector<CoveredFields>& fields, const SourceStamp& source) {
+    std::stable_sort(fields.begin(), fields.end(), [](const CoveredFields& a, const CoveredFields& b) {
+        return a.key < b.key;
+    });
+    fields.erase(std::unique(fields.begin(), fields.end(), [](const CoveredFields& a, const CoveredFields& b) {
+        return a.key == b.key;
+    }), fields.end());
+
+    // Number the states in name order
+    std::vector<std::string> states;
+    for (const auto& field : fields) {
+        states.push_back(field.state.substr(0, kStateNameSize - 1));
+    }
+    std::sort(states.begin(), states.end());
+    states.erase(std::unique(states.begin(), states.end()), states.end());
+
+    std::vector<Entry> entries(fields.size());
+    for (size_t i = 0; i < fields.size(); ++i) {
+        entries[i].key = fields[i].key;
+        entries[i].state = static_cast<uint16_t>(std::lower_bound(states.begin(), states.end(),
+                                                 fields[i].state.substr(0, kStateNameSize - 1)) - states.begin());
+        entries[i].reserved = 0;
+        entries[i].latitude = toFixedPoint(fields[i].latitude);
+        entries[i].longitude = toFixedPoint(fields[i].longitude);
+    }
+
+    TemporaryFile temporary(filename);
+    std::unique_ptr<IoBackend> out = openIoBackend(temporary.getFilename(), IoWorkload::Write);
+    if (!out || states.size() > 0xFFFF) {
+        std::cerr << "Unable to write covering index: " << filename << std::endl;
+        return false;
+    }
+    SequentialWriter writer(*out);
+    writeIndexHeader(writer, kFileType, 1, static_cast<uint32_t>(entries.size()));
+    uint32_t parameters[2] = { static_cast<uint32_t>(states.size()), 0 };
+    writer.write(parameters, sizeof(parameters));
+    char stamp[SourceStamp::kEncodedSize];
+    source.encode(stamp);
+    writer.write(stamp, sizeof(stamp));
+    for (const auto& state : states) {
+        char name[kStateNameSize] = {};
+        std::memcpy(name, state.data(), state.size());
+        writer.write(name, sizeof(name));
+    }
+    writer.write(entries.data(), entries.size() * sizeof(Entry));
+    if (!writer.finish()) {
+        std::cerr << "Error writing covering index: " << filename << std::endl;
+        return false;
+    }
+    out.reset();
+    return temporary.commit();
+}
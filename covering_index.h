@@ -0,0 +1,110 @@
+/**
+ * @file covering_index.h
+ * @brief Header file for the CoveringIndex class.
+ *
+ * Many lookups only need a zip code's state and coordinates. The covering
+ * index stores those fields inline with each key, so such lookups are
+ * answered from the index file alone: no record offset is followed and no
+ * record is read or parsed from the data file.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef COVERING_INDEX_H
+#define COVERING_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+#include "source_stamp.h"
+
+/**
+ * @struct CoveredFields
+ * @brief The fields of a record kept in the covering index.
+ */
+struct CoveredFields {
+    uint32_t key;        /**< Numeric zip code. */
+    std::string state;   /**< State abbreviation. */
+    double latitude;     /**< Latitude, to a millionth of a degree. */
+    double longitude;    /**< Longitude, to a millionth of a degree. */
+};
+
+/**
+ * @class CoveringIndex
+ * @brief Memory-mapped index of zip codes with their state and coordinates.
+ *
+ * The file holds the binary index header, the state count, the stamp of
+ * the CSV the index was generated from, the state names (8 bytes each,
+ * null padded, sorted), and then one 16-byte entry per zip code sorted by
+ * key: the key, the state's position in the name table, and the latitude
+ * and longitude in millionths of a degree as 32-bit integers. Four entries
+ * share a cache line, so a lookup is a binary search that reads nothing
+ * else.
+ */
+class CoveringIndex {
+public:
+    static const char kFileType[];          /**< File type stored in the index header. */
+    static const double kCoordinateScale;   /**< Fixed-point units per degree. */
+
+    /**
+     * @brief Maps an existing covering index file.
+     * @return false if the file cannot be mapped or is not a covering index.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Looks up a zip code.
+     * @param key Numeric zip code.
+     * @param fields Receives the covered fields if the zip code is present.
+     * @return false if the zip code is not in the index.
+     */
+    bool find(uint32_t key, CoveredFields& fields) const;
+
+    /**
+     * @brief Returns the number of zip codes in the index.
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief Returns the stamp of the CSV the index was generated from.
+     */
+    const SourceStamp& getSourceStamp() const { return source; }
+
+    /**
+     * @brief Writes a covering index.
+     *
+     * @param filename The index file to create.
+     * @param fields The covered fields of every record; sorted in place, keeping the first of any duplicate keys.
+     * @param source Stamp of the CSV the records came from.
+     * @return true if the file was written.
+     */
+    static bool write(const std::string& filename, std::vector<CoveredFields>& fields, const SourceStamp& source);
+
+private:
+    /**
+     * @struct Entry
+     * @brief One zip code as stored in the file.
+     */
+    struct Entry {
+        uint32_t key;
+        uint16_t state;      /**< Position in the state name table. */
+        uint16_t reserved;
+        int32_t latitude;    /**< Millionths of a degree. */
+        int32_t longitude;   /**< Millionths of a degree. */
+    };
+
+    static const size_t kStateNameSize = 8;   /**< Bytes per state name, null padded. */
+
+    MappedFile file;
+    const char* stateNames = nullptr;
+    const Entry* entries = nullptr;
+    size_t stateCount = 0;
+    size_t count = 0;
+    SourceStamp source;
+};
+
+#endif // COVERING_INDEX_H
@@ -0,0 +1,470 @@
+/**
+ * @file data_file_reader.cpp
+ * @brief Implementation of the DataFileReader class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "data_file_reader.h"
+#include "buffer.h"
+#include "async_record_fetcher.h"
+#include "batch_read_planner.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char kFileType[] = "ZipCodeLengthIndicated";  // Includes the null-terminator
+const size_t kVersionOffset = sizeof(kFileType);
+const size_t kHeaderSizeOffset = kVersionOffset + sizeof(uint16_t);
+const size_t kRecordCountOffset = kHeaderSizeOffset + sizeof(uint32_t);
+const size_t kMinHeaderSize = kRecordCountOffset + sizeof(uint32_t);
+const size_t kSourceStampOffset = kMinHeaderSize;  // Version 2 and later
+const size_t kStampedHeaderSize = kSourceStampOffset + SourceStamp::kEncodedSize;
+
+// Finding the first record of a partition
+const size_t kMinPartitionSize = 1 << 20;      // Smaller parts are not worth a thread
+const size_t kSyncWindowSize = 64 * 1024;      // Bytes searched for the first record
+const size_t kSyncRecords = 8;                 // Consecutive records that must look valid
+const uint32_t kMaxSyncRecordLength = 4096;    // Longest record accepted while searching
+const size_t kMaxZipDigits = 9;
+
+/**
+ * @brief Parses a coordinate field without allocating.
+ *
+ * @param field Pointer to the first character of the field.
+ * @param length Number of characters in the field.
+ * @param value Receives the parsed value.
+ * @return true if the whole field is a valid number.
+ */
+bool parseCoordinate(const char* field, size_t length, double& value) {
+    char text[32];
+    if (length == 0 || length >= sizeof(text)) {
+        return false;
+    }
+    std::memcpy(text, field, length);
+    text[length] = '\0';
+
+    char* end = nullptr;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0';
+}
+
+} // namespace
+
+DataFileReader::DataFileReader()
+    : version(0), headerSize(0), recordCount(0), fileSize(0) {}
+
+DataFileReader::~DataFileReader() {
+    close();
+}
+
+/**
+ * @brief Opens a length-indicated file and validates its header.
+ *
+ * The header is read with one positional read. The file type string,
+ * version and header size are checked so that later record reads can
+ * trust the offsets they are given without re-reading the header.
+ * Versions 1 and 2 are accepted; version 2 adds the source stamp, and
+ * records always start at the stored header size.
+ *
+ * @param name The name of the length-indicated file.
+ * @param workload The access pattern the file will be used for; selects the I/O backend.
+ * @return true if the file was opened and the header is valid, false otherwise.
+ */
+bool DataFileReader::open(const std::string& name, IoWorkload workload) {
+    close();
+
+    backend = openIoBackend(name, workload);
+    if (!backend) {
+        std::cerr << "Unable to open data file: " << name << std::endl;
+        return false;
+    }
+    fileSize = backend->size();
+
+    char header[kStampedHeaderSize];
+    long long headerRead = backend->readAt(header, sizeof(header), 0);
+    if (headerRead < static_cast<long long>(kMinHeaderSize) ||
+        std::memcmp(header, kFileType, sizeof(kFileType)) != 0) {
+        std::cerr << "Not a length-indicated data file: " << name << std::endl;
+        close();
+        return false;
+    }
+
+    std::memcpy(&version, header + kVersionOffset, sizeof(version));
+    std::memcpy(&headerSize, header + kHeaderSizeOffset, sizeof(headerSize));
+    std::memcpy(&recordCount, header + kRecordCountOffset, sizeof(recordCount));
+
+    if (version < 1 || version > 2 || headerSize < (version == 1 ? kMinHeaderSize : kStampedHeaderSize) ||
+        headerSize > fileSize) {
+        std::cerr << "Invalid header in data file: " << name << std::endl;
+        close();
+        return false;
+    }
+    if (version >= 2) {
+        source.decode(header + kSourceStampOffset);
+    }
+
+    filename = name;
+    return true;
+}
+
+/**
+ * @brief Closes the data file if it is open.
+ */
+void DataFileReader::close() {
+    fetcher.reset();
+    backend.reset();
+    filename.clear();
+    version = 0;
+    headerSize = 0;
+    recordCount = 0;
+    fileSize = 0;
+    source = SourceStamp();
+}
+
+/**
+ * @brief Reads the record that starts at the given file offset.
+ *
+ * A single read of kRecordReadSize bytes normally covers both the length
+ * prefix and the record body. Only records that do not fit need a second
+ * read into a temporary buffer. Memory-mapped files are parsed in place.
+ *
+ * @param fileOffset The file offset of the record's length prefix.
+ * @param record The record to fill in.
+ * @return true if a complete, well-formed record was read, false otherwise.
+ */
+bool DataFileReader::readRecord(uint64_t fileOffset, ZipCodeRecord& record) const {
+    if (!backend || fileOffset < headerSize || fileOffset >= fileSize) {
+        return false;
+    }
+
+    uint32_t recordLength;
+    const char* mapped = backend->data();
+    if (mapped) {
+        if (fileOffset + sizeof(recordLength) > fileSize) {
+            return false;
+        }
+        std::memcpy(&recordLength, mapped + fileOffset, sizeof(recordLength));
+        if (fileOffset + sizeof(recordLength) + recordLength > fileSize) {
+            return false;
+        }
+        return parseRecord(mapped + fileOffset + sizeof(recordLength), recordLength, record);
+    }
+
+    char chunk[kRecordReadSize];
+    long long bytesRead = backend->readAt(chunk, sizeof(chunk), fileOffset);
+    if (bytesRead < static_cast<long long>(sizeof(uint32_t))) {
+        return false;
+    }
+
+    std::memcpy(&recordLength, chunk, sizeof(recordLength));
+    if (fileOffset + sizeof(recordLength) + recordLength > fileSize) {
+        return false;
+    }
+
+    size_t available = static_cast<size_t>(bytesRead) - sizeof(recordLength);
+    if (recordLength <= available) {
+        return parseRecord(chunk + sizeof(recordLength), recordLength, record);
+    }
+
+    // Oversized record: fetch the whole body in a second read
+    std::string body(recordLength, '\0');
+    if (backend->readAt(&body[0], recordLength, fileOffset + sizeof(recordLength)) !=
+        static_cast<long long>(recordLength)) {
+        return false;
+    }
+    return parseRecord(body.data(), body.size(), record);
+}
+
+/**
+ * @brief Reads a batch of records with all reads in flight at once.
+ *
+ * A BatchReadPlanner sorts the offsets and merges neighbouring records into
+ * larger reads, which are submitted together in file order. Each record is
+ * then parsed out of its read and stored at its original position. Records
+ * that extend past the end of their read are re-read individually.
+ *
+ * @param offsets File offsets of the records' length prefixes.
+ * @param count Number of offsets.
+ * @param records Array of count records to fill in, in the same order as offsets.
+ * @return true if every record was read, false if any read failed.
+ */
+bool DataFileReader::readRecords(const uint64_t* offsets, size_t count, ZipCodeRecord* records) const {
+    if (!backend) {
+        return false;
+    }
+
+    AsyncRecordFetcher* batchFetcher;
+    {
+        std::lock_guard<std::mutex> lock(fetcherMutex);
+        if (!fetcher) {
+            fetcher.reset(new AsyncRecordFetcher(*backend));
+        }
+        batchFetcher = fetcher.get();
+    }
+
+    // Offsets outside the record area cannot be planned; they fail below
+    bool allRead = true;
+    std::vector<uint64_t> validOffsets;
+    std::vector<size_t> validIndices;
+    validOffsets.reserve(count);
+    validIndices.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (offsets[i] >= headerSize && offsets[i] < fileSize) {
+            validOffsets.push_back(offsets[i]);
+            validIndices.push_back(i);
+        } else {
+            allRead = false;
+        }
+    }
+
+    BatchReadPlanner planner(kRecordReadSize);
+    planner.plan(validOffsets.data(), validOffsets.size(), fileSize);
+    const std::vector<PlannedRead>& reads = planner.getReads();
+    const std::vector<size_t>& order = planner.getOrder();
+
+    std::vector<char> scratch(static_cast<size_t>(planner.getTotalBytes()));
+    std::vector<RecordFetch> requests(reads.size());
+    size_t position = 0;
+    for (size_t i = 0; i < reads.size(); ++i) {
+        requests[i].offset = reads[i].offset;
+        requests[i].buffer = scratch.data() + position;
+        requests[i].capacity = reads[i].length;
+        requests[i].result = -1;
+        position += reads[i].length;
+    }
+    batchFetcher->fetch(requests.data(), requests.size());
+
+    // Scatter each record from its read back to its request position
+    for (size_t i = 0; i < reads.size(); ++i) {
+        const RecordFetch& request = requests[i];
+        uint64_t bytesRead = request.result > 0 ? static_cast<uint64_t>(request.result) : 0;
+
+        for (size_t k = reads[i].firstEntry; k < reads[i].firstEntry + reads[i].entryCount; ++k) {
+            uint64_t fileOffset = validOffsets[order[k]];
+            ZipCodeRecord& record = records[validIndices[order[k]]];
+            uint64_t relative = fileOffset - request.offset;
+
+            uint32_t recordLength = 0;
+            bool complete = relative + sizeof(recordLength) <= bytesRead;
+            if (complete) {
+                std::memcpy(&recordLength, request.buffer + relative, sizeof(recordLength));
+                complete = relative + sizeof(recordLength) + recordLength <= bytesRead;
+            }
+
+            bool read = complete ? parseRecord(request.buffer + relative + sizeof(recordLength), recordLength, record)
+                                 : readRecord(fileOffset, record);
+            allRead = allRead && read;
+        }
+    }
+    return allRead;
+}
+
+/**
+ * @brief Visits every record in file order.
+ *
+ * @param visitor Called once per record with its offset, bytes and length.
+ * @return true if every record stated in the header was read (or the
+ *         visitor stopped the scan), false if the file is truncated.
+ */
+bool DataFileReader::forEachRecord(const RecordVisitor& visitor) const {
+    if (!backend) {
+        return false;
+    }
+
+    SequentialReader reader(*backend, headerSize);
+    for (uint32_t i = 0; i < recordCount; ++i) {
+        uint64_t fileOffset = reader.tell();
+
+        const char* prefix = reader.next(sizeof(uint32_t));
+        if (!prefix) {
+            return false;
+        }
+        uint32_t recordLength;
+        std::memcpy(&recordLength, prefix, sizeof(recordLength));
+
+        const char* body = reader.next(recordLength);
+        if (!body) {
+            return false;
+        }
+        if (!visitor(fileOffset, body, recordLength)) {
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Visits every record, splitting the file into parts walked by their own threads.
+ *
+ * A part walks forward from its first record until it reaches the nominal
+ * start of the next part, so it ends on the first record boundary at or
+ * after that point. The next part's search finds that same boundary unless
+ * it was fooled by record contents, in which case the two do not meet and
+ * the scan fails rather than visiting a misaligned record as valid.
+ */
+bool DataFileReader::forEachRecordPartitioned(size_t parts, const PartitionVisitor& visitor) const {
+    if (!backend) {
+        return false;
+    }
+    uint64_t bodySize = fileSize > headerSize ? fileSize - headerSize : 0;
+    parts = static_cast<size_t>(std::max<uint64_t>(1, std::min<uint64_t>(parts, bodySize / kMinPartitionSize + 1)));
+
+    std::vector<uint64_t> starts(parts, 0);
+    std::vector<uint64_t> ends(parts, 0);
+    std::vector<uint64_t> counts(parts, 0);
+    std::vector<char> complete(parts, 0);
+    std::atomic<bool> stopped(false);
+
+    auto walk = [&](size_t part) {
+        uint64_t start = headerSize;
+        if (part > 0 && !findRecordStart(headerSize + bodySize * part / parts, start)) {
+            return;
+        }
+        uint64_t nominalEnd = part + 1 < parts ? headerSize + bodySize * (part + 1) / parts : fileSize;
+        SequentialReader reader(*backend, start);
+        uint64_t count = 0;
+        while (reader.tell() < nominalEnd && !stopped) {
+            uint64_t fileOffset = reader.tell();
+            const char* prefix = reader.next(sizeof(uint32_t));
+            if (!prefix) {
+                return;
+            }
+            uint32_t recordLength;
+            std::memcpy(&recordLength, prefix, sizeof(recordLength));
+            const char* body = reader.next(recordLength);
+            if (!body) {
+                return;
+            }
+            ++count;
+            if (!visitor(part, fileOffset, body, recordLength)) {
+                stopped = true;
+            }
+        }
+        starts[part] = start;
+        ends[part] = reader.tell();
+        counts[part] = count;
+        complete[part] = 1;
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t part = 1; part < parts; ++part) {
+        workers.push_back(std::thread(walk, part));
+    }
+    walk(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (stopped) {
+        return true;
+    }
+
+    uint64_t total = 0;
+    for (size_t part = 0; part < parts; ++part) {
+        if (!complete[part] || (part + 1 < parts && ends[part] != starts[part + 1])) {
+            return false;
+        }
+        total += counts[part];
+    }
+    return total == recordCount;
+}
+
+/**
+ * @brief Finds the first record that starts at or after a file offset.
+ *
+ * A position is taken as a record start if kSyncRecords records in a row
+ * from there have a plausible length and begin with a zip code and a comma
+ * (or the chain reaches the end of the file exactly).
+ *
+ * @param from The offset to search from.
+ * @param start Receives the offset of the record's length prefix.
+ * @return false if no record start was found within kSyncWindowSize bytes.
+ */
+bool DataFileReader::findRecordStart(uint64_t from, uint64_t& start) const {
+    std::vector<char> window(kSyncWindowSize);
+    long long got = backend->readAt(window.data(), window.size(), from);
+    if (got <= 0) {
+        return false;
+    }
+    size_t available = static_cast<size_t>(got);
+
+    for (size_t candidate = 0; candidate < available; ++candidate) {
+        size_t position = candidate;
+        size_t checked = 0;
+        while (checked < kSyncRecords && from + position != fileSize) {
+            if (position + sizeof(uint32_t) > available) {
+                break;
+            }
+            uint32_t recordLength;
+            std::memcpy(&recordLength, window.data() + position, sizeof(recordLength));
+            const char* body = window.data() + position + sizeof(uint32_t);
+            size_t visible = std::min<size_t>(recordLength, kMaxZipDigits + 1);
+            if (recordLength == 0 || recordLength > kMaxSyncRecordLength ||
+                position + sizeof(uint32_t) + visible > available) {
+                break;
+            }
+            size_t digits = 0;
+            while (digits < visible && body[digits] >= '0' && body[digits] <= '9') {
+                ++digits;
+            }
+            if (digits == 0 || digits == visible || body[digits] != ',') {
+                break;
+            }
+            position += sizeof(uint32_t) + recordLength;
+            ++checked;
+        }
+        if (checked == kSyncRecords || (checked > 0 && from + position == fileSize)) {
+            start = from + candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Parses one comma-separated record body into a ZipCodeRecord.
+ *
+ * The fields are located by scanning for commas in place; the string
+ * members are assigned directly from the input bytes.
+ *
+ * @param data Pointer to the record bytes (without the length prefix).
+ * @param length Number of bytes in the record.
+ * @param record The record to fill in.
+ * @return true if all six fields were present and the coordinates parsed.
+ */
+bool DataFileReader::parseRecord(const char* data, size_t length, ZipCodeRecord& record) {
+    const char* fields[6];
+    size_t lengths[6];
+    const char* end = data + length;
+    const char* cursor = data;
+
+    for (int i = 0; i < 6; ++i) {
+        if (cursor > end) {
+            return false;
+        }
+        const char* comma = static_cast<const char*>(std::memchr(cursor, ',', end - cursor));
+        const char* fieldEnd = comma ? comma : end;
+        fields[i] = cursor;
+        lengths[i] = fieldEnd - cursor;
+        cursor = fieldEnd + 1;
+    }
+
+    record.zipCode.assign(fields[0], lengths[0]);
+    record.placeName.assign(fields[1], lengths[1]);
+    record.state.assign(fields[2], lengths[2]);
+    record.county.assign(fields[3], lengths[3]);
+
+    if (!parseCoordinate(fields[4], lengths[4], record.latitude) ||
+        !parseCoordinate(fields[5], lengths[5], record.longitude)) {
+        std::cerr << "Invalid lat/long value in record: " << record.zipCode << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,211 @@
+/**
+ * @file data_file_reader.h
+ * @brief Header file for the DataFileReader class.
+ *
+ * The DataFileReader keeps a length-indicated data file open for the
+ * lifetime of the object and reads individual records with positional
+ * reads, so point lookups do not have to reopen and re-validate the
+ * file every time.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef DATA_FILE_READER_H
+#define DATA_FILE_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "io_backend.h"
+#include "source_stamp.h"
+
+struct ZipCodeRecord;
+class AsyncRecordFetcher;
+
+/**
+ * @class DataFileReader
+ * @brief Long-lived reader for the length-indicated zip code data file.
+ *
+ * The header is read and validated once in open(). Each call to readRecord()
+ * then issues a single positional read into a stack buffer and parses the
+ * record in place, so a lookup costs one system call and no heap allocation
+ * (the output record's strings reuse their existing capacity). With the mmap
+ * backend the record is parsed straight out of the mapping.
+ *
+ * All I/O goes through an IoBackend chosen for the workload passed to open().
+ * Backend reads are positional, so one reader may be used from several
+ * threads at the same time.
+ */
+class DataFileReader {
+public:
+    /**
+     * @brief Number of bytes fetched by a single record read.
+     *
+     * Records longer than this (including their length prefix) are still
+     * read correctly, but need a second read and a temporary buffer.
+     */
+    static const size_t kRecordReadSize = 512;
+
+    DataFileReader();
+    ~DataFileReader();
+
+    DataFileReader(const DataFileReader&) = delete;
+    DataFileReader& operator=(const DataFileReader&) = delete;
+
+    /**
+     * @brief Callback used by forEachRecord().
+     *
+     * Receives the record's file offset, its bytes (without the length prefix)
+     * and its length. Returning false stops the scan.
+     */
+    typedef std::function<bool(uint64_t, const char*, uint32_t)> RecordVisitor;
+
+    /**
+     * @brief Callback used by forEachRecordPartitioned().
+     *
+     * Like RecordVisitor, with the number of the part the record belongs to
+     * first. Calls for different parts come from different threads.
+     */
+    typedef std::function<bool(size_t, uint64_t, const char*, uint32_t)> PartitionVisitor;
+
+    /**
+     * @brief Opens a length-indicated file and validates its header.
+     *
+     * Any file already open in this reader is closed first.
+     *
+     * @param filename The name of the length-indicated file.
+     * @param workload The access pattern the file will be used for; selects the I/O backend.
+     * @return true if the file was opened and the header is valid, false otherwise.
+     */
+    bool open(const std::string& filename, IoWorkload workload = IoWorkload::Lookup);
+
+    /**
+     * @brief Closes the data file if it is open.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether a data file is currently open.
+     * @return true if open() succeeded and close() has not been called.
+     */
+    bool isOpen() const { return backend != nullptr; }
+
+    /**
+     * @brief Returns the name of the currently open file.
+     * @return The filename passed to open(), or an empty string.
+     */
+    const std::string& getFilename() const { return filename; }
+
+    /** @brief Returns the version stored in the file header. */
+    uint16_t getVersion() const { return version; }
+
+    /** @brief Returns the header size stored in the file header. */
+    uint32_t getHeaderSize() const { return headerSize; }
+
+    /** @brief Returns the record count stored in the file header. */
+    uint32_t getRecordCount() const { return recordCount; }
+
+    /** @brief Returns the size of the data file in bytes. */
+    uint64_t getFileSize() const { return fileSize; }
+
+    /**
+     * @brief Returns the stamp of the CSV the file was generated from.
+     *
+     * Version 2 headers carry the stamp after the record count; for a
+     * version 1 file the stamp is unknown (all zero).
+     */
+    const SourceStamp& getSourceStamp() const { return source; }
+
+    /**
+     * @brief Reads the record that starts at the given file offset.
+     *
+     * @param fileOffset The file offset of the record's length prefix.
+     * @param record The record to fill in.
+     * @return true if a complete, well-formed record was read, false otherwise.
+     */
+    bool readRecord(uint64_t fileOffset, ZipCodeRecord& record) const;
+
+    /**
+     * @brief Reads a batch of records with all reads in flight at once.
+     *
+     * The offsets are sorted and neighbouring records coalesced into larger
+     * reads (see BatchReadPlanner). The reads are submitted together in file
+     * order through an AsyncRecordFetcher (io_uring where available, a
+     * thread pool otherwise), which is created on the first call and reused
+     * afterwards.
+     *
+     * @param offsets File offsets of the records' length prefixes.
+     * @param count Number of offsets.
+     * @param records Array of count records to fill in, in the same order as offsets.
+     * @return true if every record was read, false if any read failed.
+     */
+    bool readRecords(const uint64_t* offsets, size_t count, ZipCodeRecord* records) const;
+
+    /**
+     * @brief Visits every record in file order.
+     *
+     * The file is read in large chunks, independently of the backend's
+     * record-at-a-time lookups.
+     *
+     * @param visitor Called once per record.
+     * @return true if every record stated in the header was read (or the
+     *         visitor stopped the scan), false if the file is truncated.
+     */
+    bool forEachRecord(const RecordVisitor& visitor) const;
+
+    /**
+     * @brief Visits every record, splitting the file into parts walked by their own threads.
+     *
+     * The file is cut into parts of about equal size. Records carry no
+     * markers, so each part after the first finds its first record by
+     * looking for a run of plausible length prefixes, each followed by a
+     * zip code and a comma. The parts are only trusted if each ends exactly
+     * where the next one starts and together they hold every record stated
+     * in the header. Records within a part are visited in file order.
+     *
+     * @param parts Number of parts, and of threads (the calling thread walks the first part).
+     * @param visitor Called once per record; must be safe to call for different parts at once.
+     * @return true if every record was visited exactly once (or the visitor stopped
+     *         the scan). false if the file is truncated or the parts could not be
+     *         lined up; the visitor's output must then be discarded, and
+     *         forEachRecord() still works.
+     */
+    bool forEachRecordPartitioned(size_t parts, const PartitionVisitor& visitor) const;
+
+    /**
+     * @brief Parses one comma-separated record body into a ZipCodeRecord.
+     *
+     * @param data Pointer to the record bytes (without the length prefix).
+     * @param length Number of bytes in the record.
+     * @param record The record to fill in.
+     * @return true if all six fields were present and the coordinates parsed.
+     */
+    static bool parseRecord(const char* data, size_t length, ZipCodeRecord& record);
+
+private:
+    /**
+     * @brief Finds the first record that starts at or after a file offset.
+     *
+     * @param from The offset to search from.
+     * @param start Receives the offset of the record's length prefix.
+     * @return false if no record start was found near from.
+     */
+    bool findRecordStart(uint64_t from, uint64_t& start) const;
+
+    std::unique_ptr<IoBackend> backend; /**< Backend for the open file, or nullptr. */
+    mutable std::unique_ptr<AsyncRecordFetcher> fetcher; /**< Batch reader, created on first use. */
+    mutable std::mutex fetcherMutex;    /**< Guards creation of fetcher. */
+    std::string filename;    /**< Name of the open file. */
+    uint16_t version;        /**< Header version. */
+    uint32_t headerSize;     /**< Header size in bytes (offset of the first record). */
+    uint32_t recordCount;    /**< Number of records stated in the header. */
+    uint64_t fileSize;       /**< Size of the file in bytes. */
+    SourceStamp source;      /**< Stamp of the CSV the file was generated from. */
+};
+
+#endif // DATA_FILE_READER_H
@@ -0,0 +1,144 @@
+/**
+ * @file direct_address_index.cpp
+ * @brief Implementation of the DirectAddressTable and DirectAddressIndex classes.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "direct_address_index.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+const uint32_t DirectAddressTable::kSlots;
+const uint32_t DirectAddressTable::kMissing;
+const char DirectAddressIndex::kFileType[] = "ZipCodeDirectIndex";
+
+namespace {
+
+/**
+ * @class DirectRangeCursor
+ * @brief Steps through the slots of a range, skipping empty ones.
+ */
+class DirectRangeCursor : public IndexCursor {
+public:
+    DirectRangeCursor(const DirectAddressTable& table, uint32_t low, uint32_t high)
+        : table(table), key(low),
+          end(std::min<uint64_t>(static_cast<uint64_t>(high) + 1, DirectAddressTable::kSlots)) {}
+
+    bool next(IndexEntry& entry) override {
+        for (; key < end; ++key) {
+            uint32_t offset = table.get(static_cast<uint32_t>(key));
+            if (offset != DirectAddressTable::kMissing) {
+                entry.key = static_cast<uint32_t>(key++);
+                entry.offset = offset;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    const DirectAddressTable& table;
+    uint64_t key;   /**< Next slot to examine. */
+    uint64_t end;   /**< One past the last slot of the range. */
+};
+
+} // namespace
+
+DirectAddressTable::DirectAddressTable() : entries(nullptr) {}
+
+void DirectAddressTable::clear() {
+    std::vector<uint32_t>().swap(owned);
+    entries = nullptr;
+}
+
+/**
+ * @brief Stores a value for a key unless the key already has one.
+ *
+ * The owned array is allocated (all entries kMissing) on the first insert,
+ * replacing any attached entries.
+ */
+bool DirectAddressTable::insert(uint32_t key, uint32_t value) {
+    if (key >= kSlots || value == kMissing) {
+        return false;
+    }
+    if (owned.empty()) {
+        owned.assign(kSlots, kMissing);
+        entries = owned.data();
+    }
+    if (owned[key] != kMissing) {
+        return false;
+    }
+    owned[key] = value;
+    return true;
+}
+
+void DirectAddressTable::attach(const uint32_t* attached) {
+    std::vector<uint32_t>().swap(owned);
+    entries = attached;
+}
+
+/**
+ * @brief Maps an existing direct-address index file.
+ *
+ * The table starts at an 8-byte aligned offset of a page-aligned mapping,
+ * so its entries are read in place.
+ */
+bool DirectAddressIndex::open(const std::string& filename) {
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != 1) {
+        return false;
+    }
+    uint64_t tableAt = header.headerSize + 2 * sizeof(uint32_t);
+    uint32_t slots = 0;
+    if (file.size() >= tableAt) {
+        std::memcpy(&slots, file.data() + header.headerSize, sizeof(slots));
+    }
+    if (slots != DirectAddressTable::kSlots || file.size() < tableAt + slots * sizeof(uint32_t)) {
+        return false;
+    }
+    table.attach(reinterpret_cast<const uint32_t*>(file.data() + tableAt));
+    count = header.entryCount;
+    return true;
+}
+
+int64_t DirectAddressIndex::find(uint32_t key) const {
+    uint32_t offset = table.get(key);
+    return offset == DirectAddressTable::kMissing ? -1 : static_cast<int64_t>(offset);
+}
+
+std::unique_ptr<IndexCursor> DirectAddressIndex::openRange(uint32_t low, uint32_t high) const {
+    return std::unique_ptr<IndexCursor>(new DirectRangeCursor(table, low, high));
+}
+
+bool DirectAddressIndex::write(SequentialWriter& writer, const std::vector<IndexEntry>& entries) {
+    DirectAddressTable table;
+    uint32_t stored = 0;
+    for (const auto& entry : entries) {
+        if (entry.key >= DirectAddressTable::kSlots || entry.offset >= DirectAddressTable::kMissing) {
+            std::cerr << "Zip code " << entry.key << " at offset " << entry.offset
+                      << " does not fit a direct-address index." << std::endl;
+            return false;
+        }
+        if (table.insert(entry.key, static_cast<uint32_t>(entry.offset))) {
+            ++stored;
+        }
+    }
+    writeIndexHeader(writer, kFileType, 1, stored);
+    const uint32_t slots[2] = { DirectAddressTable::kSlots, 0 };
+    if (!writer.write(slots, sizeof(slots))) {
+        return false;
+    }
+    std::vector<uint32_t> missing;
+    const uint32_t* values = table.data();
+    if (!values) {
+        // No entries were inserted, so the table was never allocated
+        missing.assign(DirectAddressTable::kSlots, DirectAddressTable::kMissing);
+        values = missing.data();
+    }
+    return writer.write(values, DirectAddressTable::kSlots * sizeof(uint32_t));
+}
@@ -0,0 +1,132 @@
+/**
+ * @file direct_address_index.h
+ * @brief Header file for the DirectAddressTable and DirectAddressIndex classes.
+ *
+ * US zip codes have at most five digits, so every possible key fits in a
+ * table of 100,000 32-bit entries (about 400 KB). The DirectAddressTable
+ * stores one value per key at the key's position, and a lookup is a single
+ * array access followed by a check for the "missing" sentinel. Buffer uses
+ * a table in memory to map zip codes to record positions, and the
+ * DirectAddressIndex persists one next to the data file as a primary key
+ * index that is memory-mapped and read in place.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef DIRECT_ADDRESS_INDEX_H
+#define DIRECT_ADDRESS_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+#include "primary_key_index.h"
+
+/**
+ * @class DirectAddressTable
+ * @brief Array of 32-bit values indexed directly by five-digit zip code.
+ *
+ * The table either owns its entries (filled with insert()) or is a
+ * read-only view of entries stored elsewhere, such as a mapped file.
+ */
+class DirectAddressTable {
+public:
+    static const uint32_t kSlots = 100000;          /**< One entry per five-digit key. */
+    static const uint32_t kMissing = 0xFFFFFFFFu;   /**< Value of an unused entry. */
+
+    DirectAddressTable();
+
+    /**
+     * @brief Drops all entries. The table owns no storage until the next insert().
+     */
+    void clear();
+
+    /**
+     * @brief Stores a value for a key unless the key already has one.
+     * @param key Numeric zip code, below kSlots.
+     * @param value The value to store; kMissing cannot be stored.
+     * @return false if the key is out of range, already present or value is kMissing.
+     */
+    bool insert(uint32_t key, uint32_t value);
+
+    /**
+     * @brief Uses kSlots entries stored elsewhere instead of owned storage.
+     * @param entries The entries; they must stay valid while the table is used.
+     */
+    void attach(const uint32_t* entries);
+
+    /**
+     * @brief Returns the value stored for a key, or kMissing.
+     */
+    uint32_t get(uint32_t key) const {
+        return key < kSlots && entries ? entries[key] : kMissing;
+    }
+
+    /**
+     * @brief Returns the kSlots entries, or nullptr if the table is empty.
+     */
+    const uint32_t* data() const { return entries; }
+
+private:
+    std::vector<uint32_t> owned;   /**< Storage when the table is filled in memory. */
+    const uint32_t* entries;       /**< owned.data() or attached entries. */
+};
+
+/**
+ * @class DirectAddressIndex
+ * @brief Memory-mapped direct-address primary key index.
+ *
+ * The file holds the binary index header, the 32-bit slot count and four
+ * bytes of padding, then kSlots 32-bit record offsets. Offsets must
+ * therefore stay below 4 GiB, and keys below 100,000.
+ */
+class DirectAddressIndex : public PrimaryKeyIndex {
+public:
+    static const char kFileType[];   /**< File type stored in the index header. */
+
+    /**
+     * @brief Maps an existing direct-address index file.
+     * @return false if the file cannot be mapped or is not a direct-address index.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Looks up a zip code with one array access.
+     * @return The record's file offset, or -1 if the zip code is not in the index.
+     */
+    int64_t find(uint32_t key) const override;
+
+    /**
+     * @brief Opens a cursor that steps through the table slots from low to high.
+     */
+    std::unique_ptr<IndexCursor> openRange(uint32_t low, uint32_t high) const override;
+
+    /**
+     * @brief Returns the number of keys in the index.
+     */
+    size_t size() const override { return count; }
+
+    /**
+     * @brief Returns PrimaryIndexType::Direct.
+     */
+    PrimaryIndexType type() const override { return PrimaryIndexType::Direct; }
+
+    /**
+     * @brief Writes a direct-address index.
+     *
+     * @param writer Destination, positioned at the start of the file.
+     * @param entries The entries in any order; the first of any duplicate keys is kept.
+     * @return false if a key or offset does not fit the table, or a write fails.
+     */
+    static bool write(SequentialWriter& writer, const std::vector<IndexEntry>& entries);
+
+private:
+    MappedFile file;
+    DirectAddressTable table;
+    size_t count = 0;
+};
+
+#endif // DIRECT_ADDRESS_INDEX_H
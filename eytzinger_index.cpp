@@ -0,0 +1,265 @@
+/**
+ * @file eytzinger_index.cpp
+ * @brief Implementation of the EytzingerLayout and EytzingerIndex classes.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "eytzinger_index.h"
+#include <algorithm>
+
+const size_t EytzingerLayout::kAlignment;
+const char EytzingerIndex::kFileType[] = "ZipCodeEytzinger";
+
+namespace {
+
+// Sixteen 4-byte keys fill a cache line, so the line holding the
+// descendants of k four levels down starts at 16 * k
+const size_t kPrefetchStride = 16;
+
+inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+// Number of trailing one bits of k
+inline unsigned trailingOnes(uint64_t k) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(~k));
+#else
+    unsigned ones = 0;
+    while (k & 1) {
+        k >>= 1;
+        ++ones;
+    }
+    return ones;
+#endif
+}
+
+uint64_t alignedTo(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Fills layout positions by an in-order walk of the implicit tree.
+ *
+ * Visiting position k's left subtree, then k, then its right subtree
+ * assigns the sorted keys in order, which is exactly the Eytzinger order.
+ * The walk is iterative so deep trees cannot overflow the stack.
+ */
+void fillInOrder(const uint32_t* sortedKeys, size_t count, uint32_t* layout, std::vector<uint32_t>* sortedPositions) {
+    size_t next = 0;
+    std::vector<size_t> stack;
+    size_t k = 1;
+    while (k <= count || !stack.empty()) {
+        while (k <= count) {
+            stack.push_back(k);
+            k = 2 * k;
+        }
+        k = stack.back();
+        stack.pop_back();
+        layout[k] = sortedKeys[next];
+        if (sortedPositions) {
+            (*sortedPositions)[k] = static_cast<uint32_t>(next);
+        }
+        ++next;
+        k = 2 * k + 1;
+    }
+}
+
+/**
+ * @class EytzingerRangeCursor
+ * @brief Visits layout positions in key order until a key exceeds the range.
+ */
+class EytzingerRangeCursor : public IndexCursor {
+public:
+    EytzingerRangeCursor(const EytzingerLayout& layout, const uint64_t* offsets, size_t position, uint32_t high)
+        : layout(layout), offsets(offsets), position(position), high(high) {}
+
+    bool next(IndexEntry& entry) override {
+        if (position == 0 || layout.keyAt(position) > high) {
+            position = 0;
+            return false;
+        }
+        entry.key = layout.keyAt(position);
+        entry.offset = offsets[position];
+        position = layout.successor(position);
+        return true;
+    }
+
+private:
+    const EytzingerLayout& layout;
+    const uint64_t* offsets;
+    size_t position;   /**< Next layout position, 0 once the range is exhausted. */
+    uint32_t high;
+};
+
+} // namespace
+
+EytzingerLayout::EytzingerLayout() : keys(nullptr), count(0) {}
+
+void EytzingerLayout::build(const uint32_t* sortedKeys, size_t keyCount, std::vector<uint32_t>* sortedPositions) {
+    count = keyCount;
+    std::vector<char>((count + 1) * sizeof(uint32_t) + kAlignment).swap(memory);
+    uintptr_t address = reinterpret_cast<uintptr_t>(memory.data());
+    uint32_t* aligned = reinterpret_cast<uint32_t*>((address + kAlignment - 1) & ~static_cast<uintptr_t>(kAlignment - 1));
+    aligned[0] = 0;
+    if (sortedPositions) {
+        sortedPositions->assign(count + 1, 0);
+    }
+    fillInOrder(sortedKeys, count, aligned, sortedPositions);
+    keys = aligned;
+}
+
+void EytzingerLayout::attach(const uint32_t* attached, size_t keyCount) {
+    std::vector<char>().swap(memory);
+    keys = attached;
+    count = keyCount;
+}
+
+/**
+ * @brief Finds the first key not less than key.
+ *
+ * The descent goes right (2k + 1) when keys[k] < key and left (2k)
+ * otherwise, which compiles to an add of the comparison result rather
+ * than a branch. Once it falls off the tree, the path bits record every
+ * turn; the last left turn marks the answer, so shifting out the trailing
+ * right turns (trailing ones) and the final left turn recovers it.
+ */
+size_t EytzingerLayout::lowerBound(uint32_t key) const {
+    size_t k = 1;
+    while (k <= count) {
+        prefetch(keys + kPrefetchStride * k);
+        k = 2 * k + (keys[k] < key);
+    }
+    // Drop the trailing ones and the zero before them
+    return static_cast<size_t>(k >> (trailingOnes(k) + 1));
+}
+
+/**
+ * @brief Finds the first key not less than each of several keys, searching them in lockstep.
+ *
+ * Groups of kBatchSearchWidth searches descend one level at a time, each
+ * taking one step before the next search takes its own. The prefetches of
+ * the whole group are then in flight together rather than one search's
+ * chain of misses at a time. Paths differ in length only on the last,
+ * partial level, so a search that has fallen off the tree just waits.
+ */
+void EytzingerLayout::lowerBoundMany(const uint32_t* queries, size_t queryCount, size_t* positions) const {
+    size_t depth = 0;
+    for (size_t levels = count; levels != 0; levels >>= 1) {
+        ++depth;
+    }
+    size_t k[kBatchSearchWidth];
+    for (size_t start = 0; start < queryCount; start += kBatchSearchWidth) {
+        size_t width = std::min(kBatchSearchWidth, queryCount - start);
+        const uint32_t* group = queries + start;
+        std::fill(k, k + width, 1);
+        for (size_t level = 0; level < depth; ++level) {
+            for (size_t i = 0; i < width; ++i) {
+                if (k[i] <= count) {
+                    prefetch(keys + kPrefetchStride * k[i]);
+                    k[i] = 2 * k[i] + (keys[k[i]] < group[i]);
+                }
+            }
+        }
+        for (size_t i = 0; i < width; ++i) {
+            positions[start + i] = static_cast<size_t>(k[i] >> (trailingOnes(k[i]) + 1));
+        }
+    }
+}
+
+/**
+ * @brief Returns the layout position of the next larger key.
+ *
+ * With a right subtree, the successor is its leftmost node. Otherwise it
+ * is the parent of the closest ancestor reached by a left turn: climb past
+ * the trailing right turns (trailing ones) and then one more level.
+ */
+size_t EytzingerLayout::successor(size_t position) const {
+    if (2 * position + 1 <= count) {
+        position = 2 * position + 1;
+        while (2 * position <= count) {
+            position = 2 * position;
+        }
+        return position;
+    }
+    return static_cast<size_t>(position >> (trailingOnes(position) + 1));
+}
+
+/**
+ * @brief Maps an existing Eytzinger index file.
+ */
+bool EytzingerIndex::open(const std::string& filename) {
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != 1) {
+        return false;
+    }
+    uint64_t count = header.entryCount;
+    uint64_t keysAt = alignedTo(header.headerSize, EytzingerLayout::kAlignment);
+    uint64_t offsetsAt = alignedTo(keysAt + (count + 1) * sizeof(uint32_t), sizeof(uint64_t));
+    if (file.size() < offsetsAt + (count + 1) * sizeof(uint64_t)) {
+        return false;
+    }
+    layout.attach(reinterpret_cast<const uint32_t*>(file.data() + keysAt), static_cast<size_t>(count));
+    offsets = reinterpret_cast<const uint64_t*>(file.data() + offsetsAt);
+    return true;
+}
+
+int64_t EytzingerIndex::find(uint32_t key) const {
+    size_t position = layout.lowerBound(key);
+    if (position != 0 && layout.keyAt(position) == key) {
+        return static_cast<int64_t>(offsets[position]);
+    }
+    return -1;
+}
+
+void EytzingerIndex::findMany(const uint32_t* keys, size_t count, int64_t* results) const {
+    size_t positions[kBatchSearchWidth];
+    for (size_t start = 0; start < count; start += kBatchSearchWidth) {
+        size_t width = std::min(kBatchSearchWidth, count - start);
+        layout.lowerBoundMany(keys + start, width, positions);
+        for (size_t i = 0; i < width; ++i) {
+            results[start + i] = positions[i] != 0 && layout.keyAt(positions[i]) == keys[start + i]
+                                    ? static_cast<int64_t>(offsets[positions[i]]) : -1;
+        }
+    }
+}
+
+std::unique_ptr<IndexCursor> EytzingerIndex::openRange(uint32_t low, uint32_t high) const {
+    size_t position = low <= high ? layout.lowerBound(low) : 0;
+    return std::unique_ptr<IndexCursor>(new EytzingerRangeCursor(layout, offsets, position, high));
+}
+
+bool EytzingerIndex::write(SequentialWriter& writer, std::vector<IndexEntry>& entries) {
+    sortIndexEntries(entries);
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return a.key == b.key;
+    }), entries.end());
+
+    std::vector<uint32_t> sortedKeys(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        sortedKeys[i] = entries[i].key;
+    }
+    EytzingerLayout layout;
+    std::vector<uint32_t> sortedPositions;
+    layout.build(sortedKeys.data(), sortedKeys.size(), &sortedPositions);
+    std::vector<uint64_t> offsets(entries.size() + 1, 0);
+    for (size_t k = 1; k <= entries.size(); ++k) {
+        offsets[k] = entries[sortedPositions[k]].offset;
+    }
+
+    uint32_t headerSize = writeIndexHeader(writer, kFileType, 1, static_cast<uint32_t>(entries.size()));
+    const char padding[EytzingerLayout::kAlignment] = {};
+    writer.write(padding, alignedTo(headerSize, EytzingerLayout::kAlignment) - headerSize);
+    size_t bytes = (entries.size() + 1) * sizeof(uint32_t);
+    writer.write(layout.data(), bytes);
+    writer.write(padding, alignedTo(bytes, sizeof(uint64_t)) - bytes);
+    return writer.write(offsets.data(), offsets.size() * sizeof(uint64_t));
+}
@@ -0,0 +1,161 @@
+/**
+ * @file eytzinger_index.h
+ * @brief Header file for the EytzingerLayout and EytzingerIndex classes.
+ *
+ * A binary search over a sorted array jumps half the array, then a
+ * quarter, and so on, so nearly every probe of a large array is a cache
+ * miss that the processor cannot anticipate. The Eytzinger layout stores
+ * the same keys in breadth-first order of the implicit search tree: the
+ * root at position 1 and the children of position k at 2k and 2k + 1. The
+ * sixteen descendants four levels below a key are then sixteen adjacent
+ * keys, i.e. one cache line, and can be prefetched while the next levels
+ * are compared. The search loop itself has no data-dependent branch.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef EYTZINGER_INDEX_H
+#define EYTZINGER_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+#include "primary_key_index.h"
+
+/**
+ * @class EytzingerLayout
+ * @brief Keys in Eytzinger order with a branchless, prefetching lower-bound search.
+ *
+ * Position 0 is unused so the tree arithmetic stays 1-based, and the array
+ * starts on a cache line so each group of sixteen siblings shares one line.
+ * Like PiecewiseLinearModel, the layout either owns its keys (after
+ * build()) or views keys stored in a mapped file (after attach()).
+ */
+class EytzingerLayout {
+public:
+    static const size_t kAlignment = 64;   /**< Required alignment of the key array. */
+
+    EytzingerLayout();
+
+    /**
+     * @brief Builds the layout from sorted keys.
+     * @param sortedKeys The keys, in ascending order.
+     * @param count Number of keys.
+     * @param sortedPositions If not null, receives for each layout position (1..count)
+     *        the position of its key in sortedKeys, so values can be stored in the same order.
+     */
+    void build(const uint32_t* sortedKeys, size_t count, std::vector<uint32_t>* sortedPositions = nullptr);
+
+    /**
+     * @brief Uses keys stored elsewhere instead of owned ones.
+     * @param keys count + 1 keys in layout order, aligned to kAlignment bytes.
+     * @param count Number of keys (position 0 is not counted).
+     */
+    void attach(const uint32_t* keys, size_t count);
+
+    /**
+     * @brief Finds the first key not less than key.
+     * @return Its layout position in [1, count], or 0 if every key is smaller.
+     */
+    size_t lowerBound(uint32_t key) const;
+
+    /**
+     * @brief Finds the first key not less than each of several keys, searching them in lockstep.
+     * @param queries Keys to search for.
+     * @param queryCount Number of queries.
+     * @param positions Receives, for each query, what lowerBound() would return.
+     */
+    void lowerBoundMany(const uint32_t* queries, size_t queryCount, size_t* positions) const;
+
+    /**
+     * @brief Returns the layout position of the next larger key.
+     * @param position A layout position in [1, count].
+     * @return The in-order successor's position, or 0 if position holds the largest key.
+     */
+    size_t successor(size_t position) const;
+
+    /**
+     * @brief Returns the key at a layout position.
+     */
+    uint32_t keyAt(size_t position) const { return keys[position]; }
+
+    /**
+     * @brief Returns the count + 1 keys in layout order, or nullptr if empty.
+     */
+    const uint32_t* data() const { return keys; }
+
+    /**
+     * @brief Returns the number of keys.
+     */
+    size_t size() const { return count; }
+
+private:
+    std::vector<char> memory;   /**< Storage after build(), over-allocated for alignment. */
+    const uint32_t* keys;       /**< Aligned view of memory, or attached keys. */
+    size_t count;
+};
+
+/**
+ * @class EytzingerIndex
+ * @brief Memory-mapped primary key index in Eytzinger order.
+ *
+ * The file holds the binary index header, padding up to the next 64-byte
+ * boundary, the count + 1 keys in layout order, padding to 8 bytes, and the
+ * count + 1 record offsets in the same order.
+ */
+class EytzingerIndex : public PrimaryKeyIndex {
+public:
+    static const char kFileType[];   /**< File type stored in the index header. */
+
+    /**
+     * @brief Maps an existing Eytzinger index file.
+     * @return false if the file cannot be mapped or is not an Eytzinger index.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Looks up a zip code.
+     * @return The record's file offset, or -1 if the zip code is not in the index.
+     */
+    int64_t find(uint32_t key) const override;
+
+    /**
+     * @brief Looks up a batch of zip codes, descending the tree for all of them in lockstep.
+     */
+    void findMany(const uint32_t* keys, size_t count, int64_t* results) const override;
+
+    /**
+     * @brief Returns the number of keys in the index.
+     */
+    size_t size() const override { return layout.size(); }
+
+    /**
+     * @brief Returns PrimaryIndexType::Eytzinger.
+     */
+    PrimaryIndexType type() const override { return PrimaryIndexType::Eytzinger; }
+
+    /**
+     * @brief Opens a cursor that visits the tree in order from the first key not less than low.
+     */
+    std::unique_ptr<IndexCursor> openRange(uint32_t low, uint32_t high) const override;
+
+    /**
+     * @brief Writes an Eytzinger index.
+     *
+     * @param writer Destination, positioned at the start of the file.
+     * @param entries The entries in data file order; sorted in place, keeping the first of any duplicate keys.
+     * @return true if the file was written.
+     */
+    static bool write(SequentialWriter& writer, std::vector<IndexEntry>& entries);
+
+private:
+    MappedFile file;
+    EytzingerLayout layout;
+    const uint64_t* offsets = nullptr;
+};
+
+#endif // EYTZINGER_INDEX_H
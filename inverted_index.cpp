@@ -0,0 +1,280 @@
+/**
+ * @file inverted_index.cpp
+ * @brief Implementation of the text field registry, the posting list cursors and the InvertedIndex class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "inverted_index.h"
+#include "buffer.h"
+#include "primary_key_index.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+
+const char InvertedIndex::kFileType[] = "ZipCodeInvertedIndex";
+const size_t InvertedIndex::kFieldNameSize;
+const size_t InvertedIndex::kSlotSize;
+
+namespace {
+
+// Field name, source stamp, name pool size, padding and list area size follow the index header
+const size_t kParametersSize = InvertedIndex::kFieldNameSize + SourceStamp::kEncodedSize +
+                               2 * sizeof(uint32_t) + sizeof(uint64_t);
+
+const std::string& stateOf(const ZipCodeRecord& record) {
+    return record.state;
+}
+
+const std::string& countyOf(const ZipCodeRecord& record) {
+    return record.county;
+}
+
+// Terms are stored and looked up in upper case
+std::string foldTerm(const std::string& term) {
+    std::string folded(term);
+    std::transform(folded.begin(), folded.end(), folded.begin(), [](unsigned char c) {
+        return static_cast<char>(std::toupper(c));
+    });
+    return folded;
+}
+
+void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+} // namespace
+
+const std::vector<TextField>& textFields() {
+    static const std::vector<TextField> fields = {
+        { "state", stateOf },
+        { "county", countyOf }
+    };
+    return fields;
+}
+
+const TextField* findTextField(const std::string& name) {
+    for (const auto& field : textFields()) {
+        if (name == field.name) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+std::string invertedIndexFilename(const std::string& field) {
+    return field + "_lists.dat";
+}
+
+/**
+ * @brief Decodes the next gap and adds it to the previous offset.
+ */
+bool PostingCursor::next(PostingEntry& entry) {
+    if (remaining == 0) {
+        return false;
+    }
+    uint64_t gap = 0;
+    for (unsigned shift = 0; position < end && shift < 64; shift += 7) {
+        uint8_t byte = *position++;
+        gap |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            --remaining;
+            previous += gap;
+            entry.offset = previous;
+            return true;
+        }
+    }
+    remaining = 0;  // Truncated list
+    return false;
+}
+
+/**
+ * @brief Moves to the next record present in every list.
+ *
+ * The candidate is the last offset read. Each list in turn is advanced to
+ * the first offset not below it; an equal offset adds a list that agrees,
+ * a larger one becomes the new candidate, which only the list it came from
+ * agrees with so far.
+ */
+bool PostingIntersection::next(PostingEntry& entry) {
+    if (lists.empty() || !lists[0].next(entry)) {
+        return false;
+    }
+    size_t agreeing = 1;
+    for (size_t i = 1 % lists.size(); agreeing < lists.size(); i = (i + 1) % lists.size()) {
+        PostingEntry other;
+        do {
+            if (!lists[i].next(other)) {
+                return false;
+            }
+        } while (other.offset < entry.offset);
+        if (other.offset == entry.offset) {
+            ++agreeing;
+        } else {
+            entry = other;
+            agreeing = 1;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Maps an existing inverted index file.
+ */
+bool InvertedIndex::open(const std::string& filename) {
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != 1 ||
+        file.size() < header.headerSize + kParametersSize) {
+        return false;
+    }
+    const char* parameters = file.data() + header.headerSize;
+    uint32_t poolSize;
+    uint64_t areaSize;
+    std::memcpy(&poolSize, parameters + kFieldNameSize + SourceStamp::kEncodedSize, sizeof(poolSize));
+    std::memcpy(&areaSize, parameters + kFieldNameSize + SourceStamp::kEncodedSize + 2 * sizeof(uint32_t),
+                sizeof(areaSize));
+    uint64_t directoryAt = header.headerSize + kParametersSize;
+    uint64_t namesAt = directoryAt + static_cast<uint64_t>(header.entryCount) * kSlotSize;
+    uint64_t listsAt = (namesAt + poolSize + 7) & ~uint64_t(7);
+    if (file.size() < listsAt + areaSize) {
+        return false;
+    }
+    field.assign(parameters, strnlen(parameters, kFieldNameSize));
+    source.decode(parameters + kFieldNameSize);
+    count = header.entryCount;
+    namesSize = poolSize;
+    listsSize = areaSize;
+    directory = file.data() + directoryAt;
+    names = file.data() + namesAt;
+    lists = reinterpret_cast<const uint8_t*>(file.data() + listsAt);
+    return true;
+}
+
+/**
+ * @brief Returns the directory slot of a term, or nullptr if it is not in the index.
+ *
+ * A slot holds the list offset (8 bytes), the record count and the name
+ * offset; a name or a list ends where the next slot's begins.
+ */
+const char* InvertedIndex::findTerm(const std::string& term) const {
+    std::string folded = foldTerm(term);
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        const char* slot = directory + middle * kSlotSize;
+        uint32_t nameAt;
+        uint32_t nameEnd = namesSize;
+        std::memcpy(&nameAt, slot + sizeof(uint64_t) + sizeof(uint32_t), sizeof(nameAt));
+        if (middle + 1 < count) {
+            std::memcpy(&nameEnd, slot + kSlotSize + sizeof(uint64_t) + sizeof(uint32_t), sizeof(nameEnd));
+        }
+        if (nameAt > nameEnd || nameEnd > namesSize) {
+            return nullptr;
+        }
+        int order = folded.compare(0, std::string::npos, names + nameAt, nameEnd - nameAt);
+        if (order == 0) {
+            return slot;
+        }
+        if (order > 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return nullptr;
+}
+
+PostingCursor InvertedIndex::openList(const std::string& term) const {
+    const char* slot = findTerm(term);
+    if (!slot) {
+        return PostingCursor();
+    }
+    uint64_t listAt;
+    uint64_t listEnd = listsSize;
+    uint32_t records;
+    std::memcpy(&listAt, slot, sizeof(listAt));
+    std::memcpy(&records, slot + sizeof(listAt), sizeof(records));
+    if (static_cast<size_t>(slot - directory) / kSlotSize + 1 < count) {
+        std::memcpy(&listEnd, slot + kSlotSize, sizeof(listEnd));
+    }
+    if (listAt > listEnd || listEnd > listsSize) {
+        return PostingCursor();
+    }
+    return PostingCursor(lists + listAt, lists + listEnd, records);
+}
+
+bool InvertedIndex::write(const std::string& filename, const std::string& field,
+                          std::vector<std::pair<std::string, uint64_t>>& entries, const SourceStamp& source) {
+    for (auto& entry : entries) {
+        entry.first = foldTerm(entry.first);
+    }
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    TemporaryFile temporary(filename);
+    std::unique_ptr<IoBackend> out = openIoBackend(temporary.getFilename(), IoWorkload::Write);
+    if (!out || field.size() >= kFieldNameSize) {
+        std::cerr << "Unable to write inverted index: " << filename << std::endl;
+        return false;
+    }
+
+    // One directory slot, name and gap-coded list per run of entries with the same term
+    std::string slots;
+    std::string pool;
+    std::string encoded;
+    uint32_t terms = 0;
+    for (size_t first = 0; first < entries.size();) {
+        size_t last = first;
+        uint64_t previous = 0;
+        uint64_t listAt = encoded.size();
+        uint32_t nameAt = static_cast<uint32_t>(pool.size());
+        while (last < entries.size() && entries[last].first == entries[first].first) {
+            appendVarint(encoded, entries[last].second - previous);
+            previous = entries[last].second;
+            ++last;
+        }
+        uint32_t records = static_cast<uint32_t>(last - first);
+        char slot[kSlotSize];
+        std::memcpy(slot, &listAt, sizeof(listAt));
+        std::memcpy(slot + sizeof(listAt), &records, sizeof(records));
+        std::memcpy(slot + sizeof(listAt) + sizeof(records), &nameAt, sizeof(nameAt));
+        slots.append(slot, sizeof(slot));
+        pool += entries[first].first;
+        ++terms;
+        first = last;
+    }
+
+    SequentialWriter writer(*out);
+    uint32_t headerSize = writeIndexHeader(writer, kFileType, 1, terms);
+    char name[kFieldNameSize] = {};
+    std::memcpy(name, field.data(), field.size());
+    writer.write(name, sizeof(name));
+    char stamp[SourceStamp::kEncodedSize];
+    source.encode(stamp);
+    writer.write(stamp, sizeof(stamp));
+    uint32_t sizes[2] = { static_cast<uint32_t>(pool.size()), 0 };
+    uint64_t areaSize = encoded.size();
+    writer.write(sizes, sizeof(sizes));
+    writer.write(&areaSize, sizeof(areaSize));
+    writer.write(slots.data(), slots.size());
+    // Pad the names so the lists start on an 8-byte boundary, as open() expects
+    uint64_t namesEnd = headerSize + kParametersSize + slots.size() + pool.size();
+    pool.append(static_cast<size_t>(((namesEnd + 7) & ~uint64_t(7)) - namesEnd), '\0');
+    writer.write(pool.data(), pool.size());
+    writer.write(encoded.data(), encoded.size());
+    if (!writer.finish()) {
+        std::cerr << "Error writing inverted index: " << filename << std::endl;
+        return false;
+    }
+    out.reset();
+    return temporary.commit();
+}
@@ -0,0 +1,202 @@
+/**
+ * @file inverted_index.h
+ * @brief Header file for the text field registry, the posting list cursors and the InvertedIndex class.
+ *
+ * "Every zip code in county X" used to mean comparing the county of every
+ * loaded record. An inverted index interns each distinct value of a text
+ * field (a state, a county) as a term and keeps, for each term, the sorted
+ * list of the records that have it. A record is identified by the offset
+ * of its length prefix in the data file, as in every other index, so the
+ * lists lead straight to the records. Lists are stored as varint-coded
+ * gaps, and queries on several fields intersect the lists without reading
+ * any record.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef INVERTED_INDEX_H
+#define INVERTED_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "io_backend.h"
+#include "source_stamp.h"
+
+struct ZipCodeRecord;
+
+/**
+ * @struct TextField
+ * @brief A text record field that inverted indexes can be built on.
+ */
+struct TextField {
+    const char* name;                                        /**< Name used in file names. */
+    const std::string& (*value)(const ZipCodeRecord& record); /**< Reads the field from a record. */
+};
+
+/**
+ * @brief Returns every field inverted indexes can be built on.
+ */
+const std::vector<TextField>& textFields();
+
+/**
+ * @brief Finds a field by name.
+ * @return The field, or nullptr if no field has that name.
+ */
+const TextField* findTextField(const std::string& name);
+
+/**
+ * @brief Returns the file a field's inverted index is kept in ("<field>_lists.dat").
+ */
+std::string invertedIndexFilename(const std::string& field);
+
+/**
+ * @struct PostingEntry
+ * @brief One record of a posting list.
+ */
+struct PostingEntry {
+    uint64_t offset;   /**< Offset of the record's length prefix in the data file. */
+};
+
+/**
+ * @class PostingCursor
+ * @brief Decodes one term's posting list in data file order.
+ *
+ * The cursor reads the index it was opened from, which must stay open
+ * while the cursor is in use.
+ */
+class PostingCursor {
+public:
+    typedef PostingEntry Entry;   /**< Type returned by next(). */
+
+    /**
+     * @brief Creates a cursor over an encoded list.
+     * @param first The first encoded byte (nullptr for an empty list).
+     * @param last One past the last encoded byte.
+     * @param count Number of records in the list.
+     */
+    PostingCursor(const uint8_t* first = nullptr, const uint8_t* last = nullptr, uint32_t count = 0)
+        : position(first), end(last), remaining(count), previous(0) {}
+
+    /**
+     * @brief Moves to the next record of the list.
+     * @param entry Receives the record offset.
+     * @return false once the list is exhausted.
+     */
+    bool next(PostingEntry& entry);
+
+private:
+    const uint8_t* position;
+    const uint8_t* end;
+    uint32_t remaining;   /**< Records not yet decoded. */
+    uint64_t previous;    /**< The last offset decoded; gaps are relative to it. */
+};
+
+/**
+ * @class PostingIntersection
+ * @brief Yields the records present in every one of several posting lists, in data file order.
+ *
+ * The lists are advanced in turn to the largest offset seen so far, so the
+ * work is one pass over each list and no record is read. A single list is
+ * returned as it is.
+ */
+class PostingIntersection {
+public:
+    typedef PostingEntry Entry;   /**< Type returned by next(). */
+
+    explicit PostingIntersection(const std::vector<PostingCursor>& lists) : lists(lists) {}
+
+    /**
+     * @brief Moves to the next record present in every list.
+     * @param entry Receives the record offset.
+     * @return false once any list is exhausted.
+     */
+    bool next(PostingEntry& entry);
+
+private:
+    std::vector<PostingCursor> lists;
+};
+
+/**
+ * @class InvertedIndex
+ * @brief Memory-mapped posting lists of one text field, keyed by interned term.
+ *
+ * The file holds the binary index header (whose entry count is the number
+ * of terms), the field name (null padded to 16 bytes), the stamp of the CSV
+ * the index was generated from, the sizes of the name pool and of the list
+ * area, then one 16-byte directory slot per term in term order (the term's
+ * list offset, record count and name offset: a term's id is its slot), the
+ * term names back to back padded to 8 bytes, and the lists. Each list is
+ * the record offsets in increasing order, stored as LEB128 varints of the
+ * gap from the previous offset.
+ */
+class InvertedIndex {
+public:
+    static const char kFileType[];            /**< File type stored in the index header. */
+    static const size_t kFieldNameSize = 16;  /**< Bytes for the field name, null padded. */
+    static const size_t kSlotSize = 16;       /**< Bytes per directory slot. */
+
+    /**
+     * @brief Maps an existing inverted index file.
+     * @return false if the file cannot be mapped or is not an inverted index.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Opens a cursor over the records whose field has the given value.
+     *
+     * Terms are compared without regard to ASCII case.
+     *
+     * @return The cursor; it is empty if no record has that value.
+     */
+    PostingCursor openList(const std::string& term) const;
+
+    /**
+     * @brief Returns the name of the indexed field.
+     */
+    const std::string& getField() const { return field; }
+
+    /**
+     * @brief Returns the number of distinct terms.
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief Returns the stamp of the CSV the index was generated from.
+     */
+    const SourceStamp& getSourceStamp() const { return source; }
+
+    /**
+     * @brief Writes an inverted index.
+     *
+     * @param filename The index file to create.
+     * @param field The name of the indexed field.
+     * @param entries (term, record offset) pairs in any order; sorted in place.
+     * @param source Stamp of the CSV the records came from.
+     * @return true if the file was written.
+     */
+    static bool write(const std::string& filename, const std::string& field,
+                      std::vector<std::pair<std::string, uint64_t>>& entries, const SourceStamp& source);
+
+private:
+    /**
+     * @brief Returns the directory slot of a term, or nullptr if it is not in the index.
+     */
+    const char* findTerm(const std::string& term) const;
+
+    MappedFile file;
+    const char* directory = nullptr;
+    const char* names = nullptr;       /**< The term names, back to back. */
+    const uint8_t* lists = nullptr;    /**< The encoded posting lists. */
+    uint32_t namesSize = 0;
+    uint64_t listsSize = 0;
+    size_t count = 0;
+    std::string field;
+    SourceStamp source;
+};
+
+#endif // INVERTED_INDEX_H
@@ -0,0 +1,795 @@
+/**
+ * @file io_backend.cpp
+ * @brief Implementation of the pluggable I/O backends.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "io_backend.h"
+#include "block_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#ifndef NOMINMAX
+#define NOMINMAX  // Keep windows.h from defining min/max macros over std::min/std::max
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t kDirectAlignment = 4096;  // Safe logical block size for O_DIRECT on common devices
+
+/**
+ * @brief Rounds value up to a multiple of alignment (a power of two).
+ */
+inline uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * @brief Rounds value down to a multiple of alignment (a power of two).
+ */
+inline uint64_t alignDown(uint64_t value, uint64_t alignment) {
+    return value & ~(alignment - 1);
+}
+
+/**
+ * @brief Returns the first address in storage aligned to alignment.
+ */
+inline char* alignPointer(std::vector<char>& storage, size_t alignment) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+    return storage.data() + (alignUp(address, alignment) - address);
+}
+
+/**
+ * @class StreamBackend
+ * @brief Backend over a std::fstream. Every call seeks under a mutex.
+ */
+class StreamBackend : public IoBackend {
+public:
+    bool open(const std::string& name, IoMode mode) {
+        filename = name;
+        std::ios::openmode flags = std::ios::binary | std::ios::in;
+        if (mode == IoMode::Write) {
+            flags |= std::ios::out | std::ios::trunc;
+        } else if (mode == IoMode::Update) {
+            flags |= std::ios::out;
+        }
+        file.open(name, flags);
+        return file.is_open();
+    }
+
+    long long readAt(void* dest, size_t count, uint64_t offset) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(static_cast<char*>(dest), static_cast<std::streamsize>(count));
+        long long bytesRead = file.gcount();
+        if (file.bad()) {
+            return -1;
+        }
+        return bytesRead;
+    }
+
+    long long writeAt(const void* src, size_t count, uint64_t offset) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        file.clear();
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(static_cast<const char*>(src), static_cast<std::streamsize>(count));
+        return file.good() ? static_cast<long long>(count) : -1;
+    }
+
+    bool truncate(uint64_t length) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        file.flush();
+#ifdef _WIN32
+        return length == sizeUnlocked();
+#else
+        return ::truncate(filename.c_str(), static_cast<off_t>(length)) == 0;
+#endif
+    }
+
+    uint64_t size() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sizeUnlocked();
+    }
+
+    IoBackendType type() const override { return IoBackendType::Stream; }
+
+private:
+    uint64_t sizeUnlocked() const {
+        file.clear();
+        file.seekg(0, std::ios::end);
+        std::streamoff end = file.tellg();
+        return end < 0 ? 0 : static_cast<uint64_t>(end);
+    }
+
+    std::string filename;
+    mutable std::fstream file;
+    mutable std::mutex mutex;
+};
+
+/**
+ * @class PreadBackend
+ * @brief Backend over a raw file descriptor using pread/pwrite.
+ */
+class PreadBackend : public IoBackend {
+public:
+    PreadBackend() : fd(-1) {}
+
+    ~PreadBackend() override {
+        if (fd >= 0) {
+#ifdef _WIN32
+            ::_close(fd);
+#else
+            ::close(fd);
+#endif
+        }
+    }
+
+    virtual bool open(const std::string& name, IoMode mode) {
+        return openWithFlags(name, mode, 0);
+    }
+
+    long long readAt(void* dest, size_t count, uint64_t offset) override {
+#ifdef _WIN32
+        OVERLAPPED request;
+        std::memset(&request, 0, sizeof(request));
+        request.Offset = static_cast<DWORD>(offset);
+        request.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD bytesRead = 0;
+        if (!::ReadFile(handle(), dest, static_cast<DWORD>(count), &bytesRead, &request)) {
+            return ::GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+        }
+        return bytesRead;
+#else
+        char* out = static_cast<char*>(dest);
+        size_t total = 0;
+        while (total < count) {
+            ssize_t n = ::pread(fd, out + total, count - total, static_cast<off_t>(offset + total));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            if (n == 0) {
+                break;
+            }
+            total += static_cast<size_t>(n);
+        }
+        return static_cast<long long>(total);
+#endif
+    }
+
+    long long writeAt(const void* src, size_t count, uint64_t offset) override {
+#ifdef _WIN32
+        OVERLAPPED request;
+        std::memset(&request, 0, sizeof(request));
+        request.Offset = static_cast<DWORD>(offset);
+        request.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD bytesWritten = 0;
+        if (!::WriteFile(handle(), src, static_cast<DWORD>(count), &bytesWritten, &request)) {
+            return -1;
+        }
+        return bytesWritten;
+#else
+        const char* in = static_cast<const char*>(src);
+        size_t total = 0;
+        while (total < count) {
+            ssize_t n = ::pwrite(fd, in + total, count - total, static_cast<off_t>(offset + total));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            total += static_cast<size_t>(n);
+        }
+        return static_cast<long long>(total);
+#endif
+    }
+
+    bool truncate(uint64_t length) override {
+#ifdef _WIN32
+        return ::_chsize_s(fd, static_cast<long long>(length)) == 0;
+#else
+        return ::ftruncate(fd, static_cast<off_t>(length)) == 0;
+#endif
+    }
+
+    uint64_t size() const override {
+#ifdef _WIN32
+        struct _stat64 info;
+        return ::_fstat64(fd, &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+#else
+        struct stat info;
+        return ::fstat(fd, &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+#endif
+    }
+
+    void advise(AccessPattern pattern, uint64_t offset, uint64_t length) override {
+#if defined(POSIX_FADV_NORMAL)
+        int advice = POSIX_FADV_NORMAL;
+        switch (pattern) {
+            case AccessPattern::Sequential: advice = POSIX_FADV_SEQUENTIAL; break;
+            case AccessPattern::Random:     advice = POSIX_FADV_RANDOM; break;
+            case AccessPattern::WillNeed:   advice = POSIX_FADV_WILLNEED; break;
+            case AccessPattern::Normal:     break;
+        }
+        ::posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), advice);
+#else
+        (void)pattern; (void)offset; (void)length;
+#endif
+    }
+
+    int nativeHandle() const override { return fd; }
+
+    IoBackendType type() const override { return IoBackendType::Pread; }
+
+protected:
+    bool openWithFlags(const std::string& name, IoMode mode, int extraFlags) {
+#ifdef _WIN32
+        (void)extraFlags;
+        int flags = _O_BINARY | (mode == IoMode::Write ? (_O_RDWR | _O_CREAT | _O_TRUNC) : mode == IoMode::Update ? _O_RDWR : _O_RDONLY);
+        fd = ::_open(name.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+        int flags = O_CLOEXEC | extraFlags | (mode == IoMode::Write ? (O_RDWR | O_CREAT | O_TRUNC) : mode == IoMode::Update ? O_RDWR : O_RDONLY);
+        fd = ::open(name.c_str(), flags, 0644);
+#endif
+        return fd >= 0;
+    }
+
+#ifdef _WIN32
+    HANDLE handle() const { return reinterpret_cast<HANDLE>(::_get_osfhandle(fd)); }
+#endif
+
+    int fd;
+};
+
+#ifndef _WIN32
+
+/**
+ * @class MmapBackend
+ * @brief Backend that maps the whole file read-only and serves reads from memory.
+ *
+ * Files opened for writing are not mapped; writes go through pwrite.
+ */
+class MmapBackend : public PreadBackend {
+public:
+    MmapBackend() : mapping(nullptr), mappedLength(0) {}
+
+    ~MmapBackend() override {
+        if (mapping) {
+            ::munmap(mapping, mappedLength);
+        }
+    }
+
+    bool open(const std::string& name, IoMode mode) override {
+        if (!PreadBackend::open(name, mode)) {
+            return false;
+        }
+        if (mode == IoMode::Read) {
+            uint64_t length = PreadBackend::size();
+            if (length > 0) {
+                void* address = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+                if (address != MAP_FAILED) {
+                    mapping = static_cast<char*>(address);
+                    mappedLength = length;
+                }
+            }
+        }
+        return true;
+    }
+
+    long long readAt(void* dest, size_t count, uint64_t offset) override {
+        if (!mapping) {
+            return PreadBackend::readAt(dest, count, offset);
+        }
+        if (offset >= mappedLength) {
+            return 0;
+        }
+        size_t available = static_cast<size_t>(std::min<uint64_t>(count, mappedLength - offset));
+        std::memcpy(dest, mapping + offset, available);
+        return static_cast<long long>(available);
+    }
+
+    uint64_t size() const override {
+        return mapping ? mappedLength : PreadBackend::size();
+    }
+
+    void advise(AccessPattern pattern, uint64_t offset, uint64_t length) override {
+        if (!mapping) {
+            PreadBackend::advise(pattern, offset, length);
+            return;
+        }
+        int advice = MADV_NORMAL;
+        switch (pattern) {
+            case AccessPattern::Sequential: advice = MADV_SEQUENTIAL; break;
+            case AccessPattern::Random:     advice = MADV_RANDOM; break;
+            case AccessPattern::WillNeed:   advice = MADV_WILLNEED; break;
+            case AccessPattern::Normal:     break;
+        }
+        uint64_t pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+        uint64_t start = alignDown(std::min(offset, mappedLength), pageSize);
+        uint64_t end = length == 0 ? mappedLength : std::min(mappedLength, offset + length);
+        if (end > start) {
+            ::madvise(mapping + start, end - start, advice);
+        }
+    }
+
+    const char* data() const override { return mapping; }
+
+    IoBackendType type() const override { return IoBackendType::Mmap; }
+
+private:
+    char* mapping;
+    uint64_t mappedLength;
+};
+
+/**
+ * @class DirectBackend
+ * @brief Backend that opens the file with O_DIRECT to bypass the page cache.
+ *
+ * Aligned transfers go straight to the device. Unaligned reads are widened
+ * to whole blocks and copied out of a per-thread bounce buffer; unaligned
+ * writes read, patch and rewrite the blocks they touch, so concurrent
+ * unaligned writes to the same block are not safe.
+ */
+class DirectBackend : public PreadBackend {
+public:
+    DirectBackend() : direct(false) {}
+
+    bool open(const std::string& name, IoMode mode) override {
+#ifdef O_DIRECT
+        if (openWithFlags(name, mode, O_DIRECT)) {
+            direct = true;
+            return true;
+        }
+        if (errno != EINVAL) {
+            return false;
+        }
+        // The file system does not support O_DIRECT (e.g. tmpfs)
+        std::cerr << "O_DIRECT not supported for " << name << ", using buffered I/O." << std::endl;
+#endif
+        return PreadBackend::open(name, mode);
+    }
+
+    long long readAt(void* dest, size_t count, uint64_t offset) override {
+        if (!direct || isAligned(dest, count, offset)) {
+            return PreadBackend::readAt(dest, count, offset);
+        }
+        uint64_t start = alignDown(offset, kDirectAlignment);
+        size_t span = static_cast<size_t>(alignUp(offset + count, kDirectAlignment) - start);
+        char* bounce = bounceBuffer(span);
+        long long n = PreadBackend::readAt(bounce, span, start);
+        if (n < 0) {
+            return -1;
+        }
+        uint64_t skip = offset - start;
+        if (static_cast<uint64_t>(n) <= skip) {
+            return 0;
+        }
+        size_t available = static_cast<size_t>(std::min<uint64_t>(count, static_cast<uint64_t>(n) - skip));
+        std::memcpy(dest, bounce + skip, available);
+        return static_cast<long long>(available);
+    }
+
+    long long writeAt(const void* src, size_t count, uint64_t offset) override {
+        if (!direct || isAligned(src, count, offset)) {
+            return PreadBackend::writeAt(src, count, offset);
+        }
+        uint64_t start = alignDown(offset, kDirectAlignment);
+        size_t span = static_cast<size_t>(alignUp(offset + count, kDirectAlignment) - start);
+        uint64_t oldSize = size();
+        char* bounce = bounceBuffer(span);
+        long long n = PreadBackend::readAt(bounce, span, start);
+        if (n < 0) {
+            return -1;
+        }
+        std::memset(bounce + n, 0, span - static_cast<size_t>(n));
+        std::memcpy(bounce + (offset - start), src, count);
+        if (PreadBackend::writeAt(bounce, span, start) != static_cast<long long>(span)) {
+            return -1;
+        }
+        // Drop the padding if the write extended the file
+        uint64_t newEnd = std::max(oldSize, offset + count);
+        if (newEnd < start + span && !truncate(newEnd)) {
+            return -1;
+        }
+        return static_cast<long long>(count);
+    }
+
+    void advise(AccessPattern, uint64_t, uint64_t) override {
+        // Readahead hints do not apply when the page cache is bypassed
+    }
+
+    size_t alignment() const override { return direct ? kDirectAlignment : 1; }
+
+    IoBackendType type() const override { return IoBackendType::Direct; }
+
+private:
+    static bool isAligned(const void* pointer, size_t count, uint64_t offset) {
+        return reinterpret_cast<uintptr_t>(pointer) % kDirectAlignment == 0 &&
+               count % kDirectAlignment == 0 && offset % kDirectAlignment == 0;
+    }
+
+    static char* bounceBuffer(size_t span) {
+        thread_local std::vector<char> storage;
+        if (storage.size() < span + kDirectAlignment) {
+            storage.resize(span + kDirectAlignment);
+        }
+        return alignPointer(storage, kDirectAlignment);
+    }
+
+    bool direct;
+};
+
+#endif // _WIN32
+
+/**
+ * @struct IoConfig
+ * @brief The backend selected for each workload.
+ */
+struct IoConfig {
+    IoBackendType lookup;
+    IoBackendType scan;
+    IoBackendType write;
+};
+
+bool parseBackendName(const std::string& name, IoBackendType& type) {
+    if (name == "stream") {
+        type = IoBackendType::Stream;
+    } else if (name == "pread") {
+        type = IoBackendType::Pread;
+    } else if (name == "mmap") {
+        type = IoBackendType::Mmap;
+    } else if (name == "direct") {
+        type = IoBackendType::Direct;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseIoSpec(const std::string& spec, IoConfig& config) {
+    IoBackendType type;
+    if (parseBackendName(spec, type)) {
+        config.lookup = config.scan = config.write = type;
+        return true;
+    }
+
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        std::string::size_type equals = item.find('=');
+        if (equals == std::string::npos || !parseBackendName(item.substr(equals + 1), type)) {
+            return false;
+        }
+        std::string workload = item.substr(0, equals);
+        if (workload == "lookup") {
+            config.lookup = type;
+        } else if (workload == "scan") {
+            config.scan = type;
+        } else if (workload == "write") {
+            config.write = type;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+IoConfig& ioConfig() {
+    static IoConfig config = [] {
+        IoConfig defaults = { IoBackendType::Pread, IoBackendType::Pread, IoBackendType::Pread };
+        const char* spec = std::getenv("ZIPCODE_IO");
+        if (spec && *spec) {
+            IoConfig parsed = defaults;
+            if (parseIoSpec(spec, parsed)) {
+                return parsed;
+            }
+            std::cerr << "Ignoring invalid ZIPCODE_IO setting: " << spec << std::endl;
+        }
+        return defaults;
+    }();
+    return config;
+}
+
+} // namespace
+
+std::unique_ptr<IoBackend> openIoBackend(const std::string& filename, IoMode mode, IoBackendType type) {
+    if (type == IoBackendType::Stream) {
+        std::unique_ptr<StreamBackend> backend(new StreamBackend());
+        if (!backend->open(filename, mode)) {
+            return nullptr;
+        }
+        return std::unique_ptr<IoBackend>(std::move(backend));
+    }
+
+    std::unique_ptr<PreadBackend> backend;
+#ifndef _WIN32
+    if (type == IoBackendType::Mmap) {
+        backend.reset(new MmapBackend());
+    } else if (type == IoBackendType::Direct) {
+        backend.reset(new DirectBackend());
+    }
+#endif
+    if (!backend) {
+        backend.reset(new PreadBackend());
+    }
+    if (!backend->open(filename, mode)) {
+        return nullptr;
+    }
+    return std::unique_ptr<IoBackend>(std::move(backend));
+}
+
+std::unique_ptr<IoBackend> openIoBackend(const std::string& filename, IoWorkload workload) {
+    IoMode mode = workload == IoWorkload::Write ? IoMode::Write : IoMode::Read;
+    std::unique_ptr<IoBackend> backend = openIoBackend(filename, mode, ioBackendFor(workload));
+    if (!backend) {
+        return nullptr;
+    }
+
+    BlockCache& cache = sharedBlockCache();
+    if (workload == IoWorkload::Lookup) {
+        backend->advise(AccessPattern::Random);
+        // Point lookups share cached blocks; scans stream past the cache
+        if (cache.isEnabled()) {
+            return makeCachedBackend(std::move(backend), filename, cache);
+        }
+    } else if (workload == IoWorkload::Scan) {
+        backend->advise(AccessPattern::Sequential);
+    } else {
+        cache.invalidate(filename);
+    }
+    return backend;
+}
+
+IoBackendType ioBackendFor(IoWorkload workload) {
+    const IoConfig& config = ioConfig();
+    switch (workload) {
+        case IoWorkload::Lookup: return config.lookup;
+        case IoWorkload::Scan:   return config.scan;
+        case IoWorkload::Write:  return config.write;
+    }
+    return IoBackendType::Pread;
+}
+
+bool configureIoBackends(const std::string& spec) {
+    IoConfig parsed = ioConfig();
+    if (!parseIoSpec(spec, parsed)) {
+        return false;
+    }
+    ioConfig() = parsed;
+    return true;
+}
+
+const char* ioBackendName(IoBackendType type) {
+    switch (type) {
+        case IoBackendType::Stream: return "stream";
+        case IoBackendType::Pread:  return "pread";
+        case IoBackendType::Mmap:   return "mmap";
+        case IoBackendType::Direct: return "direct";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Maps a file, replacing any file mapped before.
+ *
+ * @param filename The file to map.
+ * @param pattern Access hint for the mapping.
+ * @return true if the file could be opened and read.
+ */
+bool MappedFile::open(const std::string& filename, AccessPattern pattern) {
+    backend = openIoBackend(filename, IoMode::Read, IoBackendType::Mmap);
+    mapped = nullptr;
+    copy.clear();
+    length = 0;
+    if (!backend) {
+        return false;
+    }
+
+    length = backend->size();
+    mapped = backend->data();
+    if (mapped) {
+        backend->advise(pattern);
+        return true;
+    }
+
+    copy.resize(static_cast<size_t>(length));
+    if (length > 0 && backend->readAt(copy.data(), copy.size(), 0) != static_cast<long long>(length)) {
+        copy.clear();
+        length = 0;
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    backend.reset();
+    mapped = nullptr;
+    copy.clear();
+    length = 0;
+}
+
+SequentialReader::SequentialReader(IoBackend& source, uint64_t startOffset, size_t chunk)
+    : backend(source), window(nullptr), windowCapacity(0), begin(0), end(0),
+      position(startOffset), skip(0), atEnd(false) {
+    size_t align = std::max<size_t>(backend.alignment(), 1);
+    chunkSize = static_cast<size_t>(alignUp(std::max<size_t>(chunk, align), align));
+    fileOffset = alignDown(startOffset, align);
+    // Bytes before startOffset in the first aligned chunk are skipped by fill()
+    skip = static_cast<size_t>(startOffset - fileOffset);
+}
+
+/**
+ * @brief Makes at least count unread bytes available in the window.
+ *
+ * Unread bytes are moved so that they end on an aligned boundary, which
+ * keeps every backend read aligned in both file offset and memory.
+ *
+ * @return true if count bytes are available.
+ */
+bool SequentialReader::fill(size_t count) {
+    size_t align = std::max<size_t>(backend.alignment(), 1);
+    while (end - begin < count && !atEnd) {
+        size_t leftover = end - begin;
+        size_t readStart = static_cast<size_t>(alignUp(leftover, align));
+        size_t required = readStart + std::max(chunkSize, static_cast<size_t>(alignUp(count, align)));
+
+        if (required > windowCapacity) {
+            std::vector<char> grown(required + align);
+            char* grownWindow = alignPointer(grown, align);
+            if (leftover > 0) {
+                std::memcpy(grownWindow + readStart - leftover, window + begin, leftover);
+            }
+            storage.swap(grown);
+            window = grownWindow;
+            windowCapacity = required;
+        } else if (leftover > 0) {
+            std::memmove(window + readStart - leftover, window + begin, leftover);
+        }
+        begin = readStart - leftover;
+        end = readStart;
+
+        long long n = backend.readAt(window + end, windowCapacity - end, fileOffset);
+        if (n <= 0) {
+            atEnd = true;
+            break;
+        }
+        end += static_cast<size_t>(n);
+        fileOffset += static_cast<uint64_t>(n);
+
+        size_t skipped = std::min(skip, end - begin);
+        begin += skipped;
+        skip -= skipped;
+    }
+    return end - begin >= count;
+}
+
+const char* SequentialReader::next(size_t count) {
+    if (!fill(count)) {
+        return nullptr;
+    }
+    const char* result = window + begin;
+    begin += count;
+    position += count;
+    return result;
+}
+
+bool SequentialReader::readUntil(char delimiter, std::string& out) {
+    out.clear();
+    for (;;) {
+        if (begin == end && !fill(1)) {
+            return !out.empty();
+        }
+        const char* start = window + begin;
+        const char* found = static_cast<const char*>(std::memchr(start, delimiter, end - begin));
+        if (found) {
+            size_t length = found - start;
+            out.append(start, length);
+            begin += length + 1;
+            position += length + 1;
+            return true;
+        }
+        out.append(start, end - begin);
+        position += end - begin;
+        begin = end;
+    }
+}
+
+SequentialWriter::SequentialWriter(IoBackend& destination, size_t chunk)
+    : backend(destination), used(0), written(0), failed(false) {
+    size_t align = std::max<size_t>(backend.alignment(), 1);
+    chunkSize = static_cast<size_t>(alignUp(std::max<size_t>(chunk, align), align));
+    storage.resize(chunkSize + align);
+    this->chunk = alignPointer(storage, align);
+}
+
+bool SequentialWriter::write(const void* data, size_t count) {
+    const char* in = static_cast<const char*>(data);
+    while (count > 0 && !failed) {
+        size_t space = chunkSize - used;
+        size_t n = std::min(space, count);
+        std::memcpy(chunk + used, in, n);
+        used += n;
+        in += n;
+        count -= n;
+        if (used == chunkSize) {
+            flushChunk();
+        }
+    }
+    return !failed;
+}
+
+bool SequentialWriter::flushChunk() {
+    if (used > 0 && !failed) {
+        if (backend.writeAt(chunk, used, written) != static_cast<long long>(used)) {
+            failed = true;
+        }
+        written += used;
+        used = 0;
+    }
+    return !failed;
+}
+
+bool SequentialWriter::finish() {
+    size_t align = std::max<size_t>(backend.alignment(), 1);
+    if (used % align == 0 || failed) {
+        return flushChunk();
+    }
+
+    // Pad the tail to a whole block, then cut the file back to its real length
+    size_t padded = static_cast<size_t>(alignUp(used, align));
+    std::memset(chunk + used, 0, padded - used);
+    uint64_t length = written + used;
+    if (backend.writeAt(chunk, padded, written) != static_cast<long long>(padded) ||
+        !backend.truncate(length)) {
+        failed = true;
+    }
+    written = length;
+    used = 0;
+    return !failed;
+}
+
+TemporaryFile::TemporaryFile(const std::string& filename)
+    : targetName(filename), temporaryName(filename + ".tmp"), committed(false) {}
+
+TemporaryFile::~TemporaryFile() {
+    if (!committed) {
+        std::remove(temporaryName.c_str());
+    }
+}
+
+bool TemporaryFile::commit() {
+#ifdef _WIN32
+    // rename() does not replace an existing file on Windows
+    committed = MoveFileExA(temporaryName.c_str(), targetName.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    committed = std::rename(temporaryName.c_str(), targetName.c_str()) == 0;
+#endif
+    sharedBlockCache().invalidate(targetName);
+    if (!committed) {
+        std::cerr << "Unable to replace " << targetName << " with " << temporaryName << std::endl;
+    }
+    return committed;
+}
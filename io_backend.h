@@ -0,0 +1,374 @@
+/**
+ * @file io_backend.h
+ * @brief Pluggable file I/O backends for the data and index files.
+ *
+ * All reads and writes of the length-indicated data file and the index
+ * files go through the IoBackend interface declared here. Several
+ * implementations are provided (buffered stream, pread/pwrite, mmap and
+ * O_DIRECT), and the one used for each kind of workload is chosen at run
+ * time from the ZIPCODE_IO environment variable or the -io command-line
+ * option, so a host can be tuned without rebuilding.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @enum IoBackendType
+ * @brief The available I/O backend implementations.
+ */
+enum class IoBackendType {
+    Stream,  /**< std::fstream guarded by a mutex. Portable, buffered by the C++ library. */
+    Pread,   /**< pread/pwrite on a file descriptor. No shared file position. */
+    Mmap,    /**< Read-only memory mapping with madvise hints. Writes fall back to pwrite. */
+    Direct   /**< O_DIRECT aligned I/O that bypasses the page cache. */
+};
+
+/**
+ * @enum IoWorkload
+ * @brief The kinds of file access the program performs.
+ *
+ * Each workload has its own backend selection and access-pattern hint.
+ */
+enum class IoWorkload {
+    Lookup,  /**< Hot point lookups at random offsets. */
+    Scan,    /**< Cold sequential scans over a whole file. */
+    Write    /**< Sequential generation of data and index files. */
+};
+
+/**
+ * @enum AccessPattern
+ * @brief Readahead hints passed to posix_fadvise or madvise.
+ */
+enum class AccessPattern {
+    Normal,      /**< Kernel default readahead. */
+    Sequential,  /**< Aggressive readahead, pages can be dropped behind the reader. */
+    Random,      /**< Disable readahead. */
+    WillNeed     /**< Prefetch the range now. */
+};
+
+/**
+ * @enum IoMode
+ * @brief How a backend opens its file.
+ */
+enum class IoMode {
+    Read,   /**< Open an existing file read-only. */
+    Write,  /**< Create or truncate the file for writing. */
+    Update  /**< Open an existing file for reading and writing in place. */
+};
+
+/**
+ * @class IoBackend
+ * @brief Positional read/write interface over a single open file.
+ *
+ * readAt() and writeAt() take explicit offsets and are safe to call from
+ * several threads at once on the same backend.
+ */
+class IoBackend {
+public:
+    virtual ~IoBackend() {}
+
+    /**
+     * @brief Reads up to count bytes starting at offset.
+     * @return The number of bytes read (0 at end of file), or -1 on error.
+     */
+    virtual long long readAt(void* dest, size_t count, uint64_t offset) = 0;
+
+    /**
+     * @brief Writes count bytes starting at offset.
+     * @return The number of bytes written, or -1 on error.
+     */
+    virtual long long writeAt(const void* src, size_t count, uint64_t offset) = 0;
+
+    /**
+     * @brief Sets the file size, discarding or zero-filling the tail.
+     * @return true on success.
+     */
+    virtual bool truncate(uint64_t length) = 0;
+
+    /**
+     * @brief Returns the current size of the file in bytes.
+     */
+    virtual uint64_t size() const = 0;
+
+    /**
+     * @brief Gives the kernel a readahead hint for a range of the file.
+     *
+     * A length of 0 means "to the end of the file". Backends that cannot use
+     * the hint ignore it.
+     */
+    virtual void advise(AccessPattern pattern, uint64_t offset = 0, uint64_t length = 0) {
+        (void)pattern; (void)offset; (void)length;
+    }
+
+    /**
+     * @brief Returns the whole file as contiguous memory, if the backend maps it.
+     * @return Pointer to the first byte of the file, or nullptr.
+     */
+    virtual const char* data() const { return nullptr; }
+
+    /**
+     * @brief Returns the underlying file descriptor, if there is one.
+     * @return The descriptor, or -1 for backends without one.
+     */
+    virtual int nativeHandle() const { return -1; }
+
+    /**
+     * @brief Returns the I/O alignment this backend requires for unbuffered transfers.
+     *
+     * readAt() and writeAt() accept any alignment, but transfers that are not
+     * aligned to this value are bounced through an internal buffer.
+     */
+    virtual size_t alignment() const { return 1; }
+
+    /**
+     * @brief Returns the backend type.
+     */
+    virtual IoBackendType type() const = 0;
+};
+
+/**
+ * @brief Opens a file with the given backend.
+ *
+ * Backends that are not supported on this platform fall back to Pread
+ * (or Stream where there are no file descriptors).
+ *
+ * @param filename The file to open.
+ * @param mode Whether to open for reading or to create for writing.
+ * @param type The requested backend.
+ * @return The open backend, or nullptr if the file could not be opened.
+ */
+std::unique_ptr<IoBackend> openIoBackend(const std::string& filename, IoMode mode, IoBackendType type);
+
+/**
+ * @brief Opens a file with the backend configured for a workload.
+ *
+ * The backend is chosen with ioBackendFor() and given the workload's
+ * readahead hint before it is returned. Lookup backends read through the
+ * shared BlockCache when it has a budget; opening a file for writing
+ * drops its cached blocks.
+ *
+ * @param filename The file to open.
+ * @param workload The kind of access that will be performed.
+ * @return The open backend, or nullptr if the file could not be opened.
+ */
+std::unique_ptr<IoBackend> openIoBackend(const std::string& filename, IoWorkload workload);
+
+/**
+ * @brief Returns the backend configured for a workload.
+ *
+ * The configuration is read from the ZIPCODE_IO environment variable on
+ * first use and can be replaced with configureIoBackends().
+ */
+IoBackendType ioBackendFor(IoWorkload workload);
+
+/**
+ * @brief Sets the backend used for one or more workloads.
+ *
+ * The specification is either a single backend name applied to every
+ * workload ("mmap") or a comma-separated list of workload=backend pairs
+ * ("lookup=mmap,scan=direct,write=pread").
+ *
+ * @param spec The backend specification.
+ * @return true if the specification was valid, false otherwise (nothing is changed).
+ */
+bool configureIoBackends(const std::string& spec);
+
+/**
+ * @brief Returns the name of a backend type ("stream", "pread", "mmap" or "direct").
+ */
+const char* ioBackendName(IoBackendType type);
+
+/**
+ * @class MappedFile
+ * @brief Read-only view of a whole file as contiguous memory.
+ *
+ * The file is memory-mapped through the mmap backend. Where mapping is not
+ * available the file is read into memory instead, so callers can always
+ * use data() directly.
+ */
+class MappedFile {
+public:
+    MappedFile() {}
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps a file, replacing any file mapped before.
+     * @param filename The file to map.
+     * @param pattern Access hint for the mapping.
+     * @return true if the file could be opened and read.
+     */
+    bool open(const std::string& filename, AccessPattern pattern = AccessPattern::Random);
+
+    /** @brief Unmaps the file, leaving an empty view. */
+    void close();
+
+    /** @brief Returns the first byte of the file. */
+    const char* data() const { return mapped ? mapped : copy.data(); }
+
+    /** @brief Returns the size of the file in bytes. */
+    uint64_t size() const { return length; }
+
+private:
+    std::unique_ptr<IoBackend> backend; /**< Backend holding the mapping. */
+    const char* mapped = nullptr;       /**< Start of the mapping, or nullptr. */
+    std::vector<char> copy;             /**< File contents when mapping is not available. */
+    uint64_t length = 0;                /**< Size of the file. */
+};
+
+/**
+ * @class SequentialReader
+ * @brief Chunked forward reader on top of an IoBackend.
+ *
+ * Reads large aligned chunks from the backend and hands out contiguous
+ * views of the requested size, so scans over a file cost one backend call
+ * per chunk regardless of record size.
+ */
+class SequentialReader {
+public:
+    /**
+     * @param backend The backend to read from. It must outlive the reader.
+     * @param startOffset The file offset of the first byte to return.
+     * @param chunkSize Number of bytes fetched per backend read.
+     */
+    explicit SequentialReader(IoBackend& backend, uint64_t startOffset = 0, size_t chunkSize = 1 << 20);
+
+    /**
+     * @brief Returns a pointer to the next count bytes and advances past them.
+     *
+     * The pointer stays valid until the next call.
+     *
+     * @return Pointer to count contiguous bytes, or nullptr if fewer remain.
+     */
+    const char* next(size_t count);
+
+    /**
+     * @brief Reads up to and excluding a delimiter, advancing past it.
+     *
+     * @param delimiter The byte that ends the field.
+     * @param out Receives the bytes before the delimiter.
+     * @return false if the end of the file was reached before any byte.
+     */
+    bool readUntil(char delimiter, std::string& out);
+
+    /**
+     * @brief Returns the file offset of the next byte that will be returned.
+     */
+    uint64_t tell() const { return position; }
+
+private:
+    bool fill(size_t count);
+
+    IoBackend& backend;       /**< Source of the data. */
+    size_t chunkSize;         /**< Bytes requested per backend read. */
+    std::vector<char> storage;/**< Backing memory, over-allocated for alignment. */
+    char* window;             /**< Aligned start of the usable part of storage. */
+    size_t windowCapacity;    /**< Usable bytes from window. */
+    size_t begin;             /**< Index of the next unread byte in window. */
+    size_t end;               /**< One past the last valid byte in window. */
+    uint64_t position;        /**< File offset of window[begin]. */
+    uint64_t fileOffset;      /**< File offset of window[end]. */
+    size_t skip;              /**< Bytes still to discard before startOffset. */
+    bool atEnd;               /**< The backend has returned end of file. */
+};
+
+/**
+ * @class SequentialWriter
+ * @brief Buffered append-only writer on top of an IoBackend.
+ *
+ * Output is collected into aligned chunks and written with one backend
+ * call per chunk. finish() writes the tail; for backends that require
+ * aligned transfers the tail is padded and the file truncated afterwards.
+ */
+class SequentialWriter {
+public:
+    /**
+     * @param backend The backend to write to. It must outlive the writer.
+     * @param chunkSize Number of bytes written per backend call.
+     */
+    explicit SequentialWriter(IoBackend& backend, size_t chunkSize = 1 << 20);
+
+    /**
+     * @brief Appends bytes to the output.
+     * @return false if an earlier or the current backend write failed.
+     */
+    bool write(const void* data, size_t count);
+
+    /**
+     * @brief Writes any buffered bytes and fixes up the file size.
+     * @return true if every write succeeded.
+     */
+    bool finish();
+
+    /**
+     * @brief Returns the number of bytes appended so far.
+     */
+    uint64_t tell() const { return written + used; }
+
+private:
+    bool flushChunk();
+
+    IoBackend& backend;       /**< Destination of the data. */
+    std::vector<char> storage;/**< Backing memory, over-allocated for alignment. */
+    char* chunk;              /**< Aligned start of the chunk buffer. */
+    size_t chunkSize;         /**< Capacity of the chunk buffer. */
+    size_t used;              /**< Bytes currently buffered. */
+    uint64_t written;         /**< Bytes already handed to the backend. */
+    bool failed;              /**< A backend write has failed. */
+};
+
+/**
+ * @class TemporaryFile
+ * @brief Name to write a file under until it is complete, so a failed write leaves the old file in place.
+ *
+ * The file is written to "<filename>.tmp" and commit() renames it over the
+ * file. If commit() is not called, or fails, the temporary file is removed
+ * when the object is destroyed. Close every backend open on the temporary
+ * file before committing.
+ */
+class TemporaryFile {
+public:
+    /**
+     * @brief Names the temporary file for a file.
+     * @param filename The file that commit() replaces.
+     */
+    explicit TemporaryFile(const std::string& filename);
+
+    /**
+     * @brief Removes the temporary file unless it was committed.
+     */
+    ~TemporaryFile();
+
+    TemporaryFile(const TemporaryFile&) = delete;
+    TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+    /**
+     * @brief Returns the name to write the file under.
+     */
+    const std::string& getFilename() const { return temporaryName; }
+
+    /**
+     * @brief Replaces the file with the temporary file and drops its cached blocks.
+     * @return false if the rename failed; the old file is then left as it was.
+     */
+    bool commit();
+
+private:
+    std::string targetName;     /**< The file being replaced. */
+    std::string temporaryName;  /**< Where the new contents are written. */
+    bool committed;             /**< The temporary file has been renamed. */
+};
+
+#endif // IO_BACKEND_H
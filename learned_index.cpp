@@ -0,0 +1,206 @@
+/**
+ * @file learned_index.cpp
+ * @brief Implementation of the PiecewiseLinearModel and LearnedIndex classes.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "learned_index.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+const char LearnedIndex::kFileType[] = "ZipCodeLearnedIndex";
+const uint32_t LearnedIndex::kDefaultEpsilon;
+
+namespace {
+
+// Error bound and segment count follow the index header
+const size_t kParametersSize = 2 * sizeof(uint32_t);
+
+uint64_t padded(uint64_t size) {
+    return (size + 7) & ~static_cast<uint64_t>(7);
+}
+
+/**
+ * @class KeyArrayCursor
+ * @brief Walks parallel sorted key and offset arrays until a key exceeds the range.
+ */
+class KeyArrayCursor : public IndexCursor {
+public:
+    KeyArrayCursor(const uint32_t* keys, const uint64_t* offsets, size_t position, size_t count, uint32_t high)
+        : keys(keys), offsets(offsets), position(position), count(count), high(high) {}
+
+    bool next(IndexEntry& entry) override {
+        if (position >= count || keys[position] > high) {
+            position = count;
+            return false;
+        }
+        entry.key = keys[position];
+        entry.offset = offsets[position];
+        ++position;
+        return true;
+    }
+
+private:
+    const uint32_t* keys;
+    const uint64_t* offsets;
+    size_t position;
+    size_t count;
+    uint32_t high;
+};
+
+} // namespace
+
+PiecewiseLinearModel::PiecewiseLinearModel() : segments(nullptr), segmentCount(0), epsilon(0) {}
+
+/**
+ * @brief Fits the model to a sorted array of distinct keys.
+ *
+ * For a segment starting at (x0, y0), key x at position y stays within
+ * epsilon of the line when the slope lies in
+ * [(y - epsilon - y0) / (x - x0), (y + epsilon - y0) / (x - x0)].
+ * The intersection of these ranges shrinks as keys are added; the segment
+ * ends just before the key that would make it empty, and its slope is the
+ * middle of the final range.
+ */
+void PiecewiseLinearModel::build(const uint32_t* keys, size_t count, uint32_t maxError) {
+    owned.clear();
+    epsilon = maxError;
+
+    size_t start = 0;
+    while (start < count) {
+        double low = 0.0;
+        double high = std::numeric_limits<double>::infinity();
+        size_t end = start + 1;
+        for (; end < count; ++end) {
+            double dx = static_cast<double>(keys[end] - keys[start]);
+            double dy = static_cast<double>(end - start);
+            double newLow = std::max(low, (dy - epsilon) / dx);
+            double newHigh = std::min(high, (dy + epsilon) / dx);
+            if (newLow > newHigh) {
+                break;
+            }
+            low = newLow;
+            high = newHigh;
+        }
+
+        LinearSegment segment;
+        segment.firstKey = keys[start];
+        segment.firstPosition = static_cast<uint32_t>(start);
+        segment.slope = std::isinf(high) ? 0.0 : (low + high) / 2;
+        owned.push_back(segment);
+        start = end;
+    }
+
+    segments = owned.data();
+    segmentCount = owned.size();
+}
+
+void PiecewiseLinearModel::attach(const LinearSegment* attached, size_t count, uint32_t maxError) {
+    owned.clear();
+    segments = attached;
+    segmentCount = count;
+    epsilon = maxError;
+}
+
+/**
+ * @brief Finds the position of the first key not less than key.
+ *
+ * Keys below the first key of a segment's successor are predicted by that
+ * segment. For keys that are not in the array the prediction can be off by
+ * more than epsilon at a segment boundary, so the window is clamped to the
+ * segment's own positions plus the first position of the next segment,
+ * which always contains the answer.
+ */
+size_t PiecewiseLinearModel::lowerBound(const uint32_t* keys, size_t count, uint32_t key) const {
+    if (segmentCount == 0 || key <= keys[0]) {
+        return 0;
+    }
+    const LinearSegment* segment = std::upper_bound(segments, segments + segmentCount, key,
+        [](uint32_t k, const LinearSegment& s) { return k < s.firstKey; }) - 1;
+    size_t segmentEnd = segment + 1 < segments + segmentCount ? segment[1].firstPosition : count;
+
+    double predicted = segment->firstPosition + segment->slope * static_cast<double>(key - segment->firstKey);
+    size_t guess = static_cast<size_t>(std::max(0.0, predicted));
+    size_t low = guess > epsilon ? guess - epsilon : 0;
+    size_t high = guess + epsilon + 2;
+    low = std::max<size_t>(low, segment->firstPosition);
+    high = std::min(high, segmentEnd);
+    if (low > high) {
+        low = high;
+    }
+    return static_cast<size_t>(std::lower_bound(keys + low, keys + high, key) - keys);
+}
+
+/**
+ * @brief Maps an existing learned index file.
+ */
+bool LearnedIndex::open(const std::string& filename) {
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != 1 ||
+        file.size() < header.headerSize + kParametersSize) {
+        return false;
+    }
+    uint32_t epsilon;
+    uint32_t segmentCount;
+    std::memcpy(&epsilon, file.data() + header.headerSize, sizeof(epsilon));
+    std::memcpy(&segmentCount, file.data() + header.headerSize + sizeof(epsilon), sizeof(segmentCount));
+    count = header.entryCount;
+
+    uint64_t segmentsAt = header.headerSize + kParametersSize;
+    uint64_t keysAt = segmentsAt + static_cast<uint64_t>(segmentCount) * sizeof(LinearSegment);
+    uint64_t offsetsAt = keysAt + padded(count * sizeof(uint32_t));
+    if (file.size() < offsetsAt + count * sizeof(uint64_t) || (count > 0 && segmentCount == 0)) {
+        return false;
+    }
+    model.attach(reinterpret_cast<const LinearSegment*>(file.data() + segmentsAt), segmentCount, epsilon);
+    keys = reinterpret_cast<const uint32_t*>(file.data() + keysAt);
+    offsets = reinterpret_cast<const uint64_t*>(file.data() + offsetsAt);
+    return true;
+}
+
+int64_t LearnedIndex::find(uint32_t key) const {
+    size_t position = model.lowerBound(keys, count, key);
+    if (position < count && keys[position] == key) {
+        return static_cast<int64_t>(offsets[position]);
+    }
+    return -1;
+}
+
+std::unique_ptr<IndexCursor> LearnedIndex::openRange(uint32_t low, uint32_t high) const {
+    size_t position = low <= high ? model.lowerBound(keys, count, low) : count;
+    return std::unique_ptr<IndexCursor>(new KeyArrayCursor(keys, offsets, position, count, high));
+}
+
+bool LearnedIndex::write(SequentialWriter& writer, std::vector<IndexEntry>& entries, uint32_t epsilon) {
+    sortIndexEntries(entries);
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return a.key == b.key;
+    }), entries.end());
+
+    std::vector<uint32_t> keys(entries.size());
+    std::vector<uint64_t> offsets(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        keys[i] = entries[i].key;
+        offsets[i] = entries[i].offset;
+    }
+    PiecewiseLinearModel model;
+    model.build(keys.data(), keys.size(), epsilon);
+
+    writeIndexHeader(writer, kFileType, 1, static_cast<uint32_t>(keys.size()));
+    uint32_t segmentCount = static_cast<uint32_t>(model.getSegmentCount());
+    writer.write(&epsilon, sizeof(epsilon));
+    writer.write(&segmentCount, sizeof(segmentCount));
+    writer.write(model.getSegments(), segmentCount * sizeof(LinearSegment));
+
+    const char padding[8] = {};
+    size_t bytes = keys.size() * sizeof(uint32_t);
+    writer.write(keys.data(), bytes);
+    writer.write(padding, padded(bytes) - bytes);
+    return writer.write(offsets.data(), offsets.size() * sizeof(uint64_t));
+}
@@ -0,0 +1,166 @@
+/**
+ * @file learned_index.h
+ * @brief Header file for the PiecewiseLinearModel and LearnedIndex classes.
+ *
+ * Zip codes are dense and fairly evenly spread, so the position of a key
+ * in the sorted key list is close to a linear function of the key over
+ * long stretches. The PiecewiseLinearModel captures this with a short list
+ * of line segments whose predictions are never more than epsilon positions
+ * away from the truth; a lookup evaluates the segment covering the key and
+ * binary searches only the 2 * epsilon + 1 positions around the prediction.
+ * The LearnedIndex persists the model with the sorted keys and offsets.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef LEARNED_INDEX_H
+#define LEARNED_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+#include "primary_key_index.h"
+
+/**
+ * @struct LinearSegment
+ * @brief One piece of the model: predicts firstPosition + slope * (key - firstKey).
+ */
+struct LinearSegment {
+    uint32_t firstKey;        /**< Smallest key covered by the segment. */
+    uint32_t firstPosition;   /**< Position of firstKey in the sorted keys. */
+    double slope;             /**< Positions per key unit. */
+};
+
+/**
+ * @class PiecewiseLinearModel
+ * @brief Error-bounded piecewise linear approximation of a sorted key array.
+ *
+ * Segments are fitted with the greedy shrinking-cone method: each segment
+ * starts exactly at its first key and keeps the range of slopes that stays
+ * within epsilon of every key added so far; a key that empties the range
+ * starts the next segment. The segment list is searched with a binary
+ * search, so it should stay small relative to the keys (a few hundred
+ * segments for the zip codes at epsilon 32).
+ *
+ * Like DirectAddressTable, the model either owns its segments (after
+ * build()) or views segments stored in a mapped file (after attach()).
+ */
+class PiecewiseLinearModel {
+public:
+    PiecewiseLinearModel();
+
+    /**
+     * @brief Fits the model to a sorted array of distinct keys.
+     * @param keys The keys, in ascending order.
+     * @param count Number of keys.
+     * @param epsilon Largest allowed distance between prediction and position.
+     */
+    void build(const uint32_t* keys, size_t count, uint32_t epsilon);
+
+    /**
+     * @brief Uses segments stored elsewhere instead of owned ones.
+     * @param segments The segments; they must stay valid while the model is used.
+     * @param count Number of segments.
+     * @param epsilon The error bound the segments were fitted with.
+     */
+    void attach(const LinearSegment* segments, size_t count, uint32_t epsilon);
+
+    /**
+     * @brief Finds the position of the first key not less than key.
+     * @param keys The keys the model was fitted to.
+     * @param count Number of keys.
+     * @param key The key to locate.
+     * @return A position in [0, count].
+     */
+    size_t lowerBound(const uint32_t* keys, size_t count, uint32_t key) const;
+
+    /**
+     * @brief Returns the segments.
+     */
+    const LinearSegment* getSegments() const { return segments; }
+
+    /**
+     * @brief Returns the number of segments.
+     */
+    size_t getSegmentCount() const { return segmentCount; }
+
+    /**
+     * @brief Returns the error bound.
+     */
+    uint32_t getEpsilon() const { return epsilon; }
+
+private:
+    std::vector<LinearSegment> owned;   /**< Storage after build(). */
+    const LinearSegment* segments;      /**< owned.data() or attached segments. */
+    size_t segmentCount;
+    uint32_t epsilon;
+};
+
+/**
+ * @class LearnedIndex
+ * @brief Memory-mapped learned primary key index.
+ *
+ * The file holds the binary index header, the error bound and segment
+ * count, the segments, then the sorted keys and their record offsets as
+ * two separate arrays so the local search only touches key cache lines.
+ */
+class LearnedIndex : public PrimaryKeyIndex {
+public:
+    static const char kFileType[];              /**< File type stored in the index header. */
+    static const uint32_t kDefaultEpsilon = 32; /**< Error bound used by createPrimaryKeyIndex. */
+
+    /**
+     * @brief Maps an existing learned index file.
+     * @return false if the file cannot be mapped or is not a learned index.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Looks up a zip code.
+     * @return The record's file offset, or -1 if the zip code is not in the index.
+     */
+    int64_t find(uint32_t key) const override;
+
+    /**
+     * @brief Returns the number of keys in the index.
+     */
+    size_t size() const override { return count; }
+
+    /**
+     * @brief Returns PrimaryIndexType::Learned.
+     */
+    PrimaryIndexType type() const override { return PrimaryIndexType::Learned; }
+
+    /**
+     * @brief Opens a cursor that locates low with the model and walks the sorted keys.
+     */
+    std::unique_ptr<IndexCursor> openRange(uint32_t low, uint32_t high) const override;
+
+    /**
+     * @brief Returns the fitted model.
+     */
+    const PiecewiseLinearModel& getModel() const { return model; }
+
+    /**
+     * @brief Fits the model over the entries and writes the index.
+     *
+     * @param writer Destination, positioned at the start of the file.
+     * @param entries The entries in data file order; sorted in place, keeping the first of any duplicate keys.
+     * @param epsilon Error bound of the model.
+     * @return true if the file was written.
+     */
+    static bool write(SequentialWriter& writer, std::vector<IndexEntry>& entries, uint32_t epsilon = kDefaultEpsilon);
+
+private:
+    MappedFile file;
+    PiecewiseLinearModel model;
+    const uint32_t* keys = nullptr;
+    const uint64_t* offsets = nullptr;
+    size_t count = 0;
+};
+
+#endif // LEARNED_INDEX_H
@@ -1,9 +1,21 @@
 #include "buffer.h"
+#include "io_backend.h"
+#include "block_cache.h"
+#include "benchmark.h"
 #include <algorithm>
+#include <chrono>
 #include <map>
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <cctype>
+#include <cerrno>
 #include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <thread>
 
 /**
  * @brief Function to print the boundary zip codes for each state to terminal.
@@ -113,23 +125,18 @@ void writeStateBoundariesToFile(const std::map<std::string, std::vector<ZipCodeR
  * @param filename The name of the length-indicated file.
  */
 void displayHeaderInfo(const std::string& filename) {
-    std::ifstream inputFile(filename, std::ios::binary);
+    DataFileReader inputFile;
 
-    if (!inputFile.is_open()) {
+    // Opening the reader reads and validates the header fields
+    if (!inputFile.open(filename)) {
         std::cerr << "Unable to open file: " << filename << std::endl;
         return;
     }
 
-    std::string fileType;
-    uint16_t version;
-    uint32_t headerSize;
-    uint32_t recordCount;
-
-    // Read the header fields from the file
-    std::getline(inputFile, fileType, '\0');  // Reading the null-terminated string for file type
-    inputFile.read(reinterpret_cast<char*>(&version), sizeof(version));
-    inputFile.read(reinterpret_cast<char*>(&headerSize), sizeof(headerSize));
-    inputFile.read(reinterpret_cast<char*>(&recordCount), sizeof(recordCount));
+    std::string fileType = "ZipCodeLengthIndicated";
+    uint16_t version = inputFile.getVersion();
+    uint32_t headerSize = inputFile.getHeaderSize();
+    uint32_t recordCount = inputFile.getRecordCount();
 
     // Define additional header information
     uint32_t bytesPerRecord = sizeof(ZipCodeRecord);  // Assuming variable-length records, otherwise specify
@@ -146,6 +153,17 @@ void displayHeaderInfo(const std::string& filename) {
     std::cout << "Size Format Type: " << sizeFormatType << std::endl;
     std::cout << "Primary Key Index File Name: " << primaryKeyIndexFileName << std::endl;
     std::cout << "Field Count: " << fieldCount << std::endl;
+    const SourceStamp& source = inputFile.getSourceStamp();
+    if (source.isKnown()) {
+        std::ostringstream hash;
+        hash << std::hex << std::setw(16) << std::setfill('0') << source.hash;
+        std::ostringstream nanoseconds;
+        nanoseconds << std::setw(9) << std::setfill('0') << source.modified % 1000000000;
+        std::cout << "Source: " << source.size << " bytes, modified " << source.modified / 1000000000
+                  << "." << nanoseconds.str() << ", FNV-1a " << hash.str() << std::endl;
+    } else {
+        std::cout << "Source: not recorded" << std::endl;
+    }
 
     // Display field information for each field in ZipCodeRecord
     std::cout << "Field Information:" << std::endl;
@@ -155,8 +173,110 @@ void displayHeaderInfo(const std::string& filename) {
     std::cout << "  4. County (String)" << std::endl;
     std::cout << "  5. Latitude (Double)" << std::endl;
     std::cout << "  6. Longitude (Double)" << std::endl;
+    std::cout << "I/O Backends: lookup=" << ioBackendName(ioBackendFor(IoWorkload::Lookup))
+              << ", scan=" << ioBackendName(ioBackendFor(IoWorkload::Scan))
+              << ", write=" << ioBackendName(ioBackendFor(IoWorkload::Write)) << std::endl;
+
+    BlockedBloomFilter filter;
+    if (openIndexBloomFilter(primaryKeyIndexFileName, filter)) {
+        std::ostringstream summary;
+        summary << std::fixed << std::setprecision(1) << filter.memoryUsage() / 1024.0 << " KiB, "
+                << filter.getProbes() << " probes, false-positive rate "
+                << std::setprecision(2) << filter.falsePositiveRate() * 100.0 << "%";
+        std::cout << "Bloom Filter: " << bloomFilterFilename(primaryKeyIndexFileName) << ", "
+                  << filter.size() << " keys, " << summary.str() << std::endl;
+    } else {
+        std::cout << "Bloom Filter: none (missing or out of date)" << std::endl;
+    }
+}
+
+/**
+ * @brief Checks whether the files generated from the CSV are up to date.
+ *
+ * The data file header and the primary key index's Bloom filter both record
+ * the stamp of the CSV they were built from; both must match the CSV on
+ * disk, the filter must match the index file, and the state boundaries file
+ * must not be older than the CSV as recorded in the data file's stamp, so
+ * touching the CSV without changing it rebuilds nothing. The state/zip index, the secondary indexes,
+ * the inverted lists, the place name index and the covering index, if one
+ * was generated, record the stamp as well and must match too.
+ * Each stale file is reported.
+ *
+ * @param csvFilename The source CSV file.
+ * @param dataFilename The length-indicated data file.
+ * @param indexFilename The primary key index file.
+ * @param boundariesFilename The sorted state boundaries text file.
+ * @param stateZipFilename The state/zip index file.
+ * @param placeNameFilename The place name index file.
+ * @param coveringFilename The optional covering index file; checked only if it exists.
+ * @return true if nothing needs to be regenerated.
+ */
+bool generatedFilesAreCurrent(const std::string& csvFilename, const std::string& dataFilename,
+                              const std::string& indexFilename, const std::string& boundariesFilename,
+                              const std::string& stateZipFilename, const std::string& placeNameFilename,
+                              const std::string& coveringFilename) {
+    bool current = true;
+
+    DataFileReader dataFile;
+    if (!dataFile.open(dataFilename) || !sourceMatchesStamp(csvFilename, dataFile.getSourceStamp())) {
+        std::cout << "Out of date: " << dataFilename << std::endl;
+        current = false;
+    }
+
+    BlockedBloomFilter filter;
+    if (!openPrimaryKeyIndex(indexFilename, dataFilename) || !openIndexBloomFilter(indexFilename, filter) ||
+        !sourceMatchesStamp(csvFilename, filter.getSourceStamp())) {
+        std::cout << "Out of date: " << indexFilename << std::endl;
+        current = false;
+    }
 
-    inputFile.close();
+    // The boundaries are written in the same run as the data file, after the CSV
+    // it stamps was last modified, so a touched but unchanged CSV keeps them current
+    int64_t boundariesModified;
+    if (!fileModifiedTime(boundariesFilename, boundariesModified) || !dataFile.getSourceStamp().isKnown() ||
+        boundariesModified < dataFile.getSourceStamp().modified) {
+        std::cout << "Out of date: " << boundariesFilename << std::endl;
+        current = false;
+    }
+
+    StateZipIndex stateZip;
+    if (!stateZip.open(stateZipFilename) || !sourceMatchesStamp(csvFilename, stateZip.getSourceStamp())) {
+        std::cout << "Out of date: " << stateZipFilename << std::endl;
+        current = false;
+    }
+
+    for (const auto& field : numericFields()) {
+        std::string filename = secondaryIndexFilename(field.name);
+        SecondaryIndex secondary;
+        if (!secondary.open(filename) || !sourceMatchesStamp(csvFilename, secondary.getSourceStamp())) {
+            std::cout << "Out of date: " << filename << std::endl;
+            current = false;
+        }
+    }
+
+    for (const auto& field : textFields()) {
+        std::string filename = invertedIndexFilename(field.name);
+        InvertedIndex inverted;
+        if (!inverted.open(filename) || !sourceMatchesStamp(csvFilename, inverted.getSourceStamp())) {
+            std::cout << "Out of date: " << filename << std::endl;
+            current = false;
+        }
+    }
+
+    PlaceNameIndex placeNames;
+    if (!placeNames.open(placeNameFilename) || !sourceMatchesStamp(csvFilename, placeNames.getSourceStamp())) {
+        std::cout << "Out of date: " << placeNameFilename << std::endl;
+        current = false;
+    }
+
+    int64_t coveringModified;
+    CoveringIndex covering;
+    if (fileModifiedTime(coveringFilename, coveringModified) &&
+        (!covering.open(coveringFilename) || !sourceMatchesStamp(csvFilename, covering.getSourceStamp()))) {
+        std::cout << "Out of date: " << coveringFilename << std::endl;
+        current = false;
+    }
+    return current;
 }
 
 /**
@@ -166,7 +286,23 @@ void displayHeaderInfo(const std::string& filename) {
  * @param zipCode The zip code to search for.
  */
 void searchAndDisplayZipCode(Buffer& buffer, const std::string& zipCode) {
-    buffer.searchPrimaryKey("primary_key_index.dat", zipCode);
+    buffer.searchPrimaryKey("primary_key_index.dat", "us_postal_codes.dat", zipCode);
+}
+
+/**
+ * @brief Function to check that a record read through the index is the one searched for.
+ *
+ * Hashed index formats only keep a fingerprint of each key, so a zip code
+ * that is not in the data file can very rarely resolve to another record.
+ *
+ * @param record The record read from the data file.
+ * @param zipCode The zip code that was searched for.
+ * @return true if the record's zip code matches.
+ */
+bool recordMatchesZipCode(const ZipCodeRecord& record, const std::string& zipCode) {
+    uint32_t recordKey;
+    uint32_t searchedKey;
+    return parseZipKey(record.zipCode, recordKey) && parseZipKey(zipCode, searchedKey) && recordKey == searchedKey;
 }
 
 /**
@@ -174,39 +310,564 @@ void searchAndDisplayZipCode(Buffer& buffer, const std::string& zipCode) {
  *
  * @param buffer The buffer object to handle searching.
  * @param zipCode The zip code to search for.
+ * @return false if the record the index points to cannot be read.
  */
-void searchZipCode(Buffer& buffer, const std::string& zipCode) {
+bool searchZipCode(Buffer& buffer, const std::string& zipCode) {
     std::string dataFile = "us_postal_codes.dat";    // Data file name
     std::string indexFile = "primary_key_index.dat";  // Index file name
 
     // Search for the zip code in the primary key index
-    std::streampos offset = buffer.searchPrimaryKey(indexFile, zipCode);
+    std::streampos offset = buffer.searchPrimaryKey(indexFile, dataFile, zipCode);
 
     if (offset != -1) {
-        // If found, read and display the record at the file offset
-        ZipCodeRecord record = buffer.readRecordAtOffset(dataFile, offset);
-        buffer.printRecord(record);
+        // If found, read the record at the file offset and display it if it is the one searched for;
+        // an offset the data file does not hold (e.g. the index is older than the data file) is reported
+        ZipCodeRecord record;
+        if (!buffer.readRecordAtOffset(dataFile, offset, record)) {
+            std::cerr << "Lookup error for zip code " << zipCode << std::endl;
+            return false;
+        }
+        if (recordMatchesZipCode(record, zipCode)) {
+            buffer.printRecord(record);
+            return true;
+        }
+    }
+    std::cout << "Zip Code " << zipCode << " not found." << std::endl;
+    return true;
+}
+
+/**
+ * @brief Function to search for several zip codes and read their records as one batch.
+ *
+ * Every zip code is first resolved through the primary key index; the records
+ * that were found are then read with a single batched request.
+ *
+ * @param buffer The buffer object to handle searching.
+ * @param zipCodes The zip codes to search for.
+ * @return false if the records that were found cannot be read.
+ */
+bool searchZipCodes(Buffer& buffer, const std::vector<std::string>& zipCodes) {
+    std::string dataFile = "us_postal_codes.dat";    // Data file name
+    std::string indexFile = "primary_key_index.dat";  // Index file name
+
+    // Resolve every zip code to a file offset first, as one batch of index lookups
+    std::vector<std::streampos> found = buffer.searchPrimaryKeys(indexFile, dataFile, zipCodes);
+    std::vector<std::streampos> offsets;
+    std::vector<size_t> foundPositions;
+    for (size_t i = 0; i < zipCodes.size(); ++i) {
+        if (found[i] != -1) {
+            offsets.push_back(found[i]);
+            foundPositions.push_back(i);
+        }
+    }
+
+    // Fetch all records that were found in one batch, in file order
+    std::vector<ZipCodeRecord> records;
+    if (!offsets.empty() && !buffer.readRecordsAtOffsets(dataFile, offsets, records)) {
+        std::cerr << "Lookup error: unable to read the records found for " << offsets.size() << " zip codes" << std::endl;
+        return false;
+    }
+
+    // Display the results in the order the zip codes were given
+    size_t next = 0;
+    for (size_t i = 0; i < zipCodes.size(); ++i) {
+        bool found = false;
+        if (next < foundPositions.size() && foundPositions[next] == i) {
+            found = recordMatchesZipCode(records[next], zipCodes[i]);
+            if (found) {
+                buffer.printRecord(records[next]);
+            }
+            ++next;
+        }
+        if (!found) {
+            std::cout << "Zip Code " << zipCodes[i] << " not found." << std::endl;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Function to read the records of every entry an index cursor yields, in cursor order.
+ *
+ * The records are read in batches so large ranges do not hold every record at once.
+ * Works with any cursor whose entries carry a record offset (IndexCursor, SecondaryCursor).
+ *
+ * @param buffer The buffer object to read records with.
+ * @param cursor The index cursor.
+ * @param visit Called with each record.
+ * @param found Receives the number of records read.
+ * @return false if a batch of records cannot be read from the data file.
+ */
+template <typename Cursor>
+bool forEachIndexedRecord(Buffer& buffer, Cursor& cursor, const std::function<void(const ZipCodeRecord&)>& visit,
+                          size_t& found) {
+    std::string dataFile = "us_postal_codes.dat";  // Data file name
+    const size_t kBatchSize = 1024;                 // Records read per batch
+
+    found = 0;
+    bool more = true;
+    while (more) {
+        std::vector<std::streampos> offsets;
+        typename Cursor::Entry entry;
+        while (offsets.size() < kBatchSize && (more = cursor.next(entry))) {
+            offsets.push_back(std::streampos(static_cast<std::streamoff>(entry.offset)));
+        }
+        std::vector<ZipCodeRecord> records;
+        if (!offsets.empty() && !buffer.readRecordsAtOffsets(dataFile, offsets, records)) {
+            std::cerr << "Unable to read the records listed by the index from " << dataFile << std::endl;
+            return false;
+        }
+        for (const auto& record : records) {
+            visit(record);
+        }
+        found += records.size();
+    }
+    return true;
+}
+
+/**
+ * @brief Function to print every zip code in a range, in zip code order, using the index file.
+ *
+ * The index cursor yields the matching (zip code, offset) pairs in order.
+ *
+ * @param buffer The buffer object to handle searching.
+ * @param low The smallest zip code of the range.
+ * @param high The largest zip code of the range.
+ * @return false if the index cannot answer range queries or the records cannot be read.
+ */
+bool searchZipRange(Buffer& buffer, uint32_t low, uint32_t high) {
+    std::unique_ptr<IndexCursor> cursor =
+        buffer.openPrimaryKeyRange("primary_key_index.dat", "us_postal_codes.dat", low, high);
+    if (!cursor) {
+        return false;
+    }
+    size_t found;
+    if (!forEachIndexedRecord(buffer, *cursor, [&buffer](const ZipCodeRecord& record) {
+            buffer.printRecord(record);
+        }, found)) {
+        return false;
+    }
+    std::cout << found << " zip codes from " << low << " to " << high << "." << std::endl;
+    return true;
+}
+
+/**
+ * @brief Function to print every zip code of a state, in zip code order, using the state/zip index.
+ *
+ * @param buffer The buffer object to handle searching.
+ * @param stateZipIndexFile The state/zip index file.
+ * @param state The state abbreviation.
+ * @return false if the state/zip index cannot be opened or the records cannot be read.
+ */
+bool listStateZipCodes(Buffer& buffer, const std::string& stateZipIndexFile, const std::string& state) {
+    std::unique_ptr<IndexCursor> cursor = buffer.openStateZipRange(stateZipIndexFile, state, 0, UINT32_MAX);
+    if (!cursor) {
+        return false;
+    }
+    size_t found;
+    if (!forEachIndexedRecord(buffer, *cursor, [&buffer](const ZipCodeRecord& record) {
+            buffer.printRecord(record);
+        }, found)) {
+        return false;
+    }
+    std::cout << found << " zip codes in " << state << "." << std::endl;
+    return true;
+}
+
+/**
+ * @brief Function to print every record whose numeric field is in a range, in value order.
+ *
+ * @param buffer The buffer object to handle searching.
+ * @param field The name of the indexed numeric field.
+ * @param low The smallest value of the range.
+ * @param high The largest value of the range.
+ * @return false if the field has no secondary index or the records cannot be read.
+ */
+bool searchFieldRange(Buffer& buffer, const std::string& field, double low, double high) {
+    std::unique_ptr<SecondaryCursor> cursor = buffer.openSecondaryRange(field, low, high);
+    if (!cursor) {
+        return false;
+    }
+    size_t found;
+    if (!forEachIndexedRecord(buffer, *cursor, [&buffer](const ZipCodeRecord& record) {
+            buffer.printRecord(record);
+        }, found)) {
+        return false;
+    }
+    std::cout << found << " zip codes with " << field << " from " << low << " to " << high << "." << std::endl;
+    return true;
+}
+
+/**
+ * @brief Function to print every record matching a set of state and county values, in data file order.
+ *
+ * @param buffer The buffer object to handle searching.
+ * @param terms (text field name, value) pairs a record must all match.
+ * @return false if an inverted index cannot be opened or the records cannot be read.
+ */
+bool listInvertedRecords(Buffer& buffer, const std::vector<std::pair<std::string, std::string>>& terms) {
+    std::unique_ptr<PostingIntersection> cursor = buffer.openInvertedLists(terms);
+    if (!cursor) {
+        return false;
+    }
+    size_t found;
+    if (!forEachIndexedRecord(buffer, *cursor, [&buffer](const ZipCodeRecord& record) {
+            buffer.printRecord(record);
+        }, found)) {
+        return false;
+    }
+    std::cout << found << " zip codes with";
+    for (size_t i = 0; i < terms.size(); ++i) {
+        std::cout << (i == 0 ? " " : " and ") << terms[i].first << " " << terms[i].second;
+    }
+    std::cout << "." << std::endl;
+    return true;
+}
+
+/**
+ * @brief Function to print the place names that complete a prefix, with their zip codes.
+ *
+ * @param buffer The buffer object to handle searching.
+ * @param placeNameIndexFile The place name index file.
+ * @param prefix The typed prefix.
+ * @param limit The most completions to print.
+ * @return false if the place name index cannot be opened.
+ */
+bool completePlaceName(Buffer& buffer, const std::string& placeNameIndexFile, const std::string& prefix, size_t limit) {
+    // Open the index first (no completions asked for) so only the search is timed
+    std::vector<PlaceCompletion> completions;
+    if (!buffer.completePlaceName(placeNameIndexFile, prefix, 0, completions)) {
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    buffer.completePlaceName(placeNameIndexFile, prefix, limit, completions);
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    for (const auto& completion : completions) {
+        std::cout << completion.placeName << " (" << completion.zips.size() << " zip codes):";
+        for (uint32_t zip : completion.zips) {
+            std::cout << " " << std::setw(5) << std::setfill('0') << zip;
+        }
+        std::cout << std::setfill(' ') << std::endl;
+    }
+    std::cout << completions.size() << " completions of \"" << prefix << "\" in " << std::fixed
+              << std::setprecision(1) << elapsed << " us." << std::endl;
+    return true;
+}
+
+/**
+ * @brief Function to print and write the state boundaries from the state/zip index.
+ *
+ * Each state's records are read in zip code order straight from the data
+ * file, so neither the CSV nor a grouping and sorting pass is needed.
+ *
+ * @param buffer The buffer object to handle searching.
+ * @param stateZipIndexFile The state/zip index file.
+ * @param boundariesFile The sorted state boundaries text file to write.
+ * @return false if the state/zip index cannot be opened or the records cannot be read.
+ */
+bool reportStateBoundaries(Buffer& buffer, const std::string& stateZipIndexFile, const std::string& boundariesFile) {
+    std::vector<std::string> states;
+    if (!buffer.getIndexedStates(stateZipIndexFile, states)) {
+        return false;
+    }
+    std::map<std::string, std::vector<ZipCodeRecord>> stateRecords;
+    for (const auto& state : states) {
+        std::vector<ZipCodeRecord>& records = stateRecords[state];
+        std::unique_ptr<IndexCursor> cursor = buffer.openStateZipRange(stateZipIndexFile, state, 0, UINT32_MAX);
+        size_t found;
+        if (!forEachIndexedRecord(buffer, *cursor, [&records](const ZipCodeRecord& record) {
+                records.push_back(record);
+            }, found)) {
+            return false;
+        }
+        if (records.empty()) {
+            stateRecords.erase(state);
+        }
+    }
+    printStateBoundaries(stateRecords);
+    writeStateBoundariesToFile(stateRecords, boundariesFile);
+    return true;
+}
+
+/**
+ * @brief Function to print a zip code's state and coordinates from the covering index.
+ *
+ * Only the covering index is read; the data file is not opened.
+ *
+ * @param buffer The buffer object to handle searching.
+ * @param coveringFile The covering index file.
+ * @param zipCode The zip code to search for.
+ */
+void searchCoveredZipCode(Buffer& buffer, const std::string& coveringFile, const std::string& zipCode) {
+    CoveredFields fields;
+    if (buffer.searchCoveringIndex(coveringFile, zipCode, fields)) {
+        std::cout << "Zip Code: " << fields.key
+                  << ", State: " << fields.state
+                  << ", Latitude: " << fields.latitude
+                  << ", Longitude: " << fields.longitude << std::endl;
     } else {
-        std::cout << "Zip Code " << zipCode << " not found." << std::endl;
+        std::cout << "Zip code " << zipCode << " not found in the covering index." << std::endl;
+    }
+}
+
+/**
+ * @brief Function to print the shared block cache counters, if the cache is enabled.
+ */
+void printBlockCacheStats() {
+    BlockCacheStats stats = sharedBlockCache().getStats();
+    if (stats.budgetBytes < BlockCache::kBlockSize) {
+        return;
     }
+    std::cout << "Block Cache: budget " << (stats.budgetBytes >> 10) << " KiB"
+              << ", resident " << stats.residentBlocks << " blocks"
+              << ", hits " << stats.hits
+              << ", misses " << stats.misses
+              << " (ghost " << stats.ghostHits << ")"
+              << ", evictions " << stats.evictions << std::endl;
 }
 
 int main(int argc, char* argv[]) {
     Buffer buffer;
 
+    // Apply I/O backend options (-io=<backend> or -io=lookup=<backend>,scan=<backend>,write=<backend>)
+    // the primary key index format (-index=<type>), concurrent index writing (-concurrent),
+    // clustering by zip code (-cluster), the covering index (-covering), index rebuild threads (-threads=<n>)
+    // and the block cache budget (-cache=<MiB>), and keep the remaining arguments as flags
+    std::string coveringIndexFile = "covering_index.dat";
+    std::string stateZipIndexFile = "state_zip_index.dat";
+    std::string placeNameIndexFile = "place_name_index.dat";
+    bool writeCoveringIndex = false;
+    bool sparseIndex = false;
+    bool clustered = false;
+    std::vector<std::string> flags;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 4, "-io=") == 0) {
+            if (!configureIoBackends(arg.substr(4))) {
+                std::cerr << "Invalid I/O backend option: " << arg << std::endl;
+                return 1;
+            }
+        } else if (arg.compare(0, 7, "-index=") == 0) {
+            // Format of the primary key index written by the generation run
+            PrimaryIndexType indexType;
+            if (!parsePrimaryIndexType(arg.substr(7), indexType)) {
+                std::cerr << "Invalid index type option: " << arg << std::endl;
+                return 1;
+            }
+            buffer.setPrimaryIndexType(indexType);
+            sparseIndex = indexType == PrimaryIndexType::Sparse;
+        } else if (arg == "-concurrent") {
+            // Write the primary key index on its own thread while the data file is written
+            buffer.setConcurrentIndexWrite(true);
+        } else if (arg == "-cluster") {
+            // Write the data file in zip code order, as the sparse index requires
+            buffer.setClusterByZip(true);
+            clustered = true;
+        } else if (arg == "-covering") {
+            // Also write the covering index answered by -c
+            writeCoveringIndex = true;
+        } else if (arg.compare(0, 9, "-threads=") == 0) {
+            // Threads used by -reindex (0 for one per hardware thread)
+            const char* count = arg.c_str() + 9;
+            char* end = nullptr;
+            errno = 0;
+            unsigned long long threads = std::strtoull(count, &end, 10);
+            if (!std::isdigit(static_cast<unsigned char>(*count)) || *end != '\0' || errno == ERANGE) {
+                std::cerr << "Invalid thread count option: " << arg << std::endl;
+                return 1;
+            }
+            buffer.setIndexBuildThreads(threads ? static_cast<size_t>(threads) : std::thread::hardware_concurrency());
+        } else if (arg.compare(0, 7, "-cache=") == 0) {
+            // Block cache budget in MiB for point lookups (0 disables it)
+            size_t budget;
+            if (!parseCacheMegabytes(arg.substr(7), budget)) {
+                std::cerr << "Invalid cache size option: " << arg << std::endl;
+                return 1;
+            }
+            sharedBlockCache().resize(budget);
+        } else {
+            flags.push_back(arg);
+        }
+    }
+
+    // Generating a sparse index needs the data file clustered by zip code; refuse
+    // before any file is touched (-reindex checks the existing data file itself)
+    if (sparseIndex && !clustered && std::find(flags.begin(), flags.end(), "-reindex") == flags.end()) {
+        std::cerr << "-index=sparse needs a data file clustered by zip code; add -cluster." << std::endl;
+        return 1;
+    }
+
     // Display the header info first (assumes the length-indicated file has been generated already)
     std::string lengthIndicatedFile = "us_postal_codes.dat";  // The binary file with the header
     displayHeaderInfo(lengthIndicatedFile);
 
 
         // If there's a command-line argument to search for zip codes
-    if (argc > 1) {
-        std::string flag = argv[1];
-        if (flag[0] == '-' && flag[1] == 'z') {
-            std::string zipCode = flag.substr(2);  // Extract the zip code after the '-z'
-            searchZipCode(buffer, zipCode);
+    if (!flags.empty()) {
+        std::string flag = flags[0];
+        if (flag.size() > 1 && flag[0] == '-' && flag[1] == 'z') {
+            // Collect every -z flag; several zip codes are searched as one batch
+            std::vector<std::string> zipCodes;
+            for (const auto& f : flags) {
+                if (f.size() > 1 && f[0] == '-' && f[1] == 'z') {
+                    zipCodes.push_back(f.substr(2));  // Extract the zip code after the '-z'
+                }
+            }
+            bool searched = zipCodes.size() == 1 ? searchZipCode(buffer, zipCodes[0]) : searchZipCodes(buffer, zipCodes);
+            printBlockCacheStats();
+            return searched ? 0 : 1;  // Exit after performing the search
+        }
+        if (flag.size() > 2 && flag[0] == '-' && flag[1] == 'f') {
+            // Batch search for every zip code listed in a file (whitespace separated)
+            std::ifstream zipFile(flag.substr(2));
+            if (!zipFile.is_open()) {
+                std::cerr << "Unable to open zip code list: " << flag.substr(2) << std::endl;
+                return 1;
+            }
+            std::vector<std::string> zipCodes;
+            std::string zipCode;
+            while (zipFile >> zipCode) {
+                zipCodes.push_back(zipCode);
+            }
+            bool searched = searchZipCodes(buffer, zipCodes);
+            printBlockCacheStats();
+            return searched ? 0 : 1;  // Exit after performing the search
+        }
+        if (flag == "-reindex") {
+            // Rebuild the primary key index from the data file alone
+            auto start = std::chrono::steady_clock::now();
+            if (!buffer.createPrimaryKeyIndex(lengthIndicatedFile, "primary_key_index.dat")) {
+                return 1;
+            }
+            std::cout << "Index rebuilt in " << std::fixed << std::setprecision(1)
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                      << " ms" << std::endl;
+            return 0;
+        }
+        if (flag.size() > 2 && flag[0] == '-' && (flag[1] == 'r' || flag[1] == 'p')) {
+            // Zip code range (-r<low>-<high>) or prefix (-p<digits>) in zip code order
+            uint32_t low = 0;
+            uint32_t high = 0;
+            bool valid;
+            if (flag[1] == 'r') {
+                size_t dash = flag.find('-', 2);
+                valid = dash != std::string::npos && parseZipKey(flag.substr(2, dash - 2), low) &&
+                        parseZipKey(flag.substr(dash + 1), high);
+            } else {
+                valid = zipPrefixRange(flag.substr(2), low, high);
+            }
+            if (!valid) {
+                std::cerr << "Invalid zip code range: " << flag << std::endl;
+                return 1;
+            }
+            return searchZipRange(buffer, low, high) ? 0 : 1;
+        }
+        if (flag.size() > 2 && flag[0] == '-' && flag[1] == 'c') {
+            // State and coordinates of each -c zip code, from the covering index alone
+            for (const auto& f : flags) {
+                if (f.size() > 2 && f[0] == '-' && f[1] == 'c') {
+                    searchCoveredZipCode(buffer, coveringIndexFile, f.substr(2));
+                }
+            }
             return 0;  // Exit after performing the search
         }
+        if (flag == "-u") {
+            // Regenerate only if the CSV changed since the files were generated
+            if (generatedFilesAreCurrent("us_postal_codes_ROWS_RANDOMIZED.csv", lengthIndicatedFile,
+                                         "primary_key_index.dat", "sorted_state_boundaries.txt",
+                                         stateZipIndexFile, placeNameIndexFile, coveringIndexFile)) {
+                std::cout << "Generated files are up to date; nothing to do." << std::endl;
+                return 0;
+            }
+            std::cout << "Regenerating." << std::endl;
+            // Keep an existing covering index in step with the other files
+            std::ifstream existingCoveringIndex(coveringIndexFile);
+            writeCoveringIndex = writeCoveringIndex || existingCoveringIndex.is_open();
+            flags.clear();
+        }
+        if (flag.size() > 2 && flag[0] == '-' && flag[1] == 'l') {
+            // Every zip code of a state, in zip code order, from the state/zip index
+            std::string state = flag.substr(2);
+            std::transform(state.begin(), state.end(), state.begin(), ::toupper);
+            return listStateZipCodes(buffer, stateZipIndexFile, state) ? 0 : 1;
+        }
+        if (flag.size() > 2 && flag[0] == '-' && flag[1] == 'q') {
+            // Records with a numeric field in a range (-q<field>:<low>:<high>), in value order
+            size_t first = flag.find(':');
+            size_t second = first == std::string::npos ? first : flag.find(':', first + 1);
+            char* end = nullptr;
+            double low = 0;
+            double high = 0;
+            bool valid = second != std::string::npos;
+            if (valid) {
+                low = std::strtod(flag.c_str() + first + 1, &end);
+                valid = end == flag.c_str() + second;
+            }
+            if (valid) {
+                high = std::strtod(flag.c_str() + second + 1, &end);
+                valid = second + 1 < flag.size() && *end == '\0';
+            }
+            if (!valid) {
+                std::cerr << "Invalid field range: " << flag << std::endl;
+                return 1;
+            }
+            return searchFieldRange(buffer, flag.substr(2, first - 2), low, high) ? 0 : 1;
+        }
+        if (flag.size() > 2 && flag[0] == '-' && (flag[1] == 'S' || flag[1] == 'C')) {
+            // Records of a state (-S<ST>) and/or a county (-C<county>), from the inverted lists;
+            // several flags are intersected
+            std::vector<std::pair<std::string, std::string>> terms;
+            for (const auto& f : flags) {
+                if (f.size() > 2 && f[0] == '-' && (f[1] == 'S' || f[1] == 'C')) {
+                    terms.push_back(std::make_pair(std::string(f[1] == 'S' ? "state" : "county"), f.substr(2)));
+                }
+            }
+            return listInvertedRecords(buffer, terms) ? 0 : 1;
+        }
+        if (flag.size() > 2 && flag[0] == '-' && flag[1] == 'a') {
+            // Place name autocomplete (-a<prefix> or -a<prefix>:<count>, ten completions by default)
+            std::string prefix = flag.substr(2);
+            size_t limit = 10;
+            size_t colon = prefix.rfind(':');
+            if (colon != std::string::npos) {
+                const char* count = prefix.c_str() + colon + 1;
+                char* end = nullptr;
+                errno = 0;
+                unsigned long long parsed = std::strtoull(count, &end, 10);
+                if (!std::isdigit(static_cast<unsigned char>(*count)) || *end != '\0' || errno == ERANGE) {
+                    std::cerr << "Invalid completion count: " << flag << std::endl;
+                    return 1;
+                }
+                limit = static_cast<size_t>(parsed);
+                prefix.erase(colon);
+            }
+            return completePlaceName(buffer, placeNameIndexFile, prefix, limit) ? 0 : 1;
+        }
+        if (flag == "-boundaries") {
+            // State boundaries report from the state/zip index, without the CSV
+            return reportStateBoundaries(buffer, stateZipIndexFile, "sorted_state_boundaries.txt") ? 0 : 1;
+        }
+        if (flag == "-mphcheck") {
+            // Build the perfect hash index over many key set sizes and check every key
+            return runPerfectHashCheck("perfect_hash_check.dat") ? 0 : 1;
+        }
+        if (flag.compare(0, 6, "-bench") == 0) {
+            // Lookup benchmark (-bench or -bench=<synthetic key count>, 0 to skip the synthetic keys)
+            size_t syntheticKeys = 10000000;
+            if (flag.size() > 6) {
+                const char* count = flag.c_str() + 7;
+                char* end = nullptr;
+                errno = 0;
+                unsigned long long keys = std::strtoull(count, &end, 10);
+                if (flag[6] != '=' || !std::isdigit(static_cast<unsigned char>(*count)) || *end != '\0' || errno == ERANGE ||
+                    keys > std::numeric_limits<size_t>::max()) {
+                    std::cerr << "Invalid benchmark option: " << flag << std::endl;
+                    return 1;
+                }
+                syntheticKeys = static_cast<size_t>(keys);
+            }
+            return runIndexBenchmark(lengthIndicatedFile, syntheticKeys) ? 0 : 1;
+        }
     }
 
 
@@ -229,8 +890,8 @@ int main(int argc, char* argv[]) {
         }
 
         // Check if the user provided a zip code to search for in the command-line arguments
-        if (argc > 1) {
-            std::string zipCode = argv[1];
+        if (!flags.empty()) {
+            std::string zipCode = flags[0];
             searchAndDisplayZipCode(buffer, zipCode);
         }
 
@@ -240,12 +901,28 @@ int main(int argc, char* argv[]) {
         // Step 5: Write sorted state boundaries to a .txt file
         writeStateBoundariesToFile(stateRecords, "sorted_state_boundaries.txt");
 
-        // Step 6: Output by zip code from Section 5 and create index file
-        buffer.convertToLengthIndicatedFile("us_postal_codes_ROWS_RANDOMIZED.csv", "us_postal_codes.dat");
-        // Step 7: Create the primary key index for fast searching
-        buffer.createPrimaryKeyIndex(lengthIndicatedFile, "primary_key_index.dat");
+        // Step 6: Output by zip code from Section 5 and create the primary key index
+        // for fast searching, the place name index, the state/zip index for
+        // per-state listings and boundaries, the secondary indexes on every numeric
+        // field, the state and county inverted lists and, optionally, the covering
+        // index for index-only state and coordinate lookups in the same pass
+        std::vector<std::string> fields;
+        for (const auto& field : numericFields()) {
+            fields.push_back(field.name);
+        }
+        std::vector<std::string> textFieldNames;
+        for (const auto& field : textFields()) {
+            textFieldNames.push_back(field.name);
+        }
+        if (!buffer.convertToLengthIndicatedFile("us_postal_codes_ROWS_RANDOMIZED.csv", lengthIndicatedFile, "primary_key_index.dat",
+                                                 placeNameIndexFile, stateZipIndexFile,
+                                                 writeCoveringIndex ? coveringIndexFile : std::string(), fields,
+                                                 textFieldNames)) {
+            return 1;
+        }
     } else {
         std::cerr << "Failed to load CSV file." << std::endl;
+        return 1;
     }
 
 
@@ -0,0 +1,250 @@
+/**
+ * @file perfect_hash_index.cpp
+ * @brief Implementation of the PerfectHashIndex class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "perfect_hash_index.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+const char PerfectHashIndex::kFileType[] = "ZipCodePerfectHash";
+
+namespace {
+
+const size_t kKeysPerBucket = 5;       // Average bucket size (lambda)
+const uint32_t kMaxPilot = 0xFFFF;     // Pilots are stored in 16 bits
+const int kMaxSeeds = 32;              // Seeds tried before giving up
+const uint16_t kVersion = 2;           // Version 2 mixes the displaced hash before reducing it
+
+// File layout after the index header: u64 seed, u32 bucket count, u32 table
+// size, then the pilots, the remap table, the fingerprints and the offsets,
+// each section padded to 8 bytes.
+const size_t kParametersSize = sizeof(uint64_t) + 2 * sizeof(uint32_t);
+
+uint64_t padded(uint64_t size) {
+    return (size + 7) & ~static_cast<uint64_t>(7);
+}
+
+// splitmix64 finaliser
+uint64_t mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+uint64_t keyHash(uint32_t key, uint64_t seed) {
+    return mix(seed ^ key);
+}
+
+// The high half of the key hash picks the bucket...
+uint32_t bucketOf(uint64_t hash, uint32_t bucketCount) {
+    return static_cast<uint32_t>(((hash >> 32) * bucketCount) >> 32);
+}
+
+// ...the whole hash, displaced by the bucket's pilot and mixed again, picks
+// the position by multiply-shift. Mixing after the displacement makes every
+// bit of the hash reach the position, so keys of a bucket that share their
+// low bits still separate whatever factors the table size has...
+uint64_t positionOf(uint64_t hash, uint16_t pilot, uint32_t tableSize) {
+    return ((mix(hash ^ mix(pilot)) >> 32) * tableSize) >> 32;
+}
+
+// ...and bits the bucket does not use give the fingerprint
+uint16_t fingerprintOf(uint64_t hash) {
+    return static_cast<uint16_t>(hash >> 16);
+}
+
+} // namespace
+
+/**
+ * @brief Maps an existing perfect hash index file.
+ *
+ * Every section starts at an 8-byte aligned offset of the mapping, so the
+ * arrays are used in place.
+ */
+bool PerfectHashIndex::open(const std::string& filename) {
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != kVersion ||
+        file.size() < header.headerSize + kParametersSize) {
+        return false;
+    }
+    const char* parameters = file.data() + header.headerSize;
+    std::memcpy(&seed, parameters, sizeof(seed));
+    std::memcpy(&bucketCount, parameters + sizeof(seed), sizeof(bucketCount));
+    std::memcpy(&tableSize, parameters + sizeof(seed) + sizeof(bucketCount), sizeof(tableSize));
+    count = header.entryCount;
+    if (count > 0 && (bucketCount == 0 || tableSize < count)) {
+        return false;
+    }
+
+    uint64_t pilotsAt = header.headerSize + kParametersSize;
+    uint64_t remapAt = pilotsAt + padded(static_cast<uint64_t>(bucketCount) * sizeof(uint16_t));
+    uint64_t fingerprintsAt = remapAt + padded(static_cast<uint64_t>(tableSize - count) * sizeof(uint32_t));
+    uint64_t offsetsAt = fingerprintsAt + padded(static_cast<uint64_t>(count) * sizeof(uint16_t));
+    if (file.size() < offsetsAt + count * sizeof(uint64_t)) {
+        return false;
+    }
+    pilots = reinterpret_cast<const uint16_t*>(file.data() + pilotsAt);
+    remap = reinterpret_cast<const uint32_t*>(file.data() + remapAt);
+    fingerprints = reinterpret_cast<const uint16_t*>(file.data() + fingerprintsAt);
+    offsets = reinterpret_cast<const uint64_t*>(file.data() + offsetsAt);
+    return true;
+}
+
+int64_t PerfectHashIndex::find(uint32_t key) const {
+    if (count == 0) {
+        return -1;
+    }
+    uint64_t hash;
+    uint64_t slot = slotFor(key, hash);
+    if (slot >= count || fingerprints[slot] != fingerprintOf(hash)) {
+        return -1;
+    }
+    return static_cast<int64_t>(offsets[slot]);
+}
+
+/**
+ * @brief Evaluates the minimal perfect hash function for a key.
+ * @param key Numeric zip code.
+ * @param hash Receives the key hash, for the fingerprint check.
+ * @return The key's slot in [0, n).
+ */
+uint64_t PerfectHashIndex::slotFor(uint32_t key, uint64_t& hash) const {
+    hash = keyHash(key, seed);
+    uint64_t position = positionOf(hash, pilots[bucketOf(hash, bucketCount)], tableSize);
+    return position < count ? position : remap[position - count];
+}
+
+/**
+ * @brief Builds the perfect hash function over the entries and writes the index.
+ *
+ * Buckets average five keys and the table has 2% more positions than keys,
+ * so the pilot search for the last, nearly-full placements still succeeds
+ * after a few dozen tries. If some bucket finds no pilot below 65,536 the
+ * whole construction restarts with a new seed.
+ */
+bool PerfectHashIndex::write(SequentialWriter& writer, std::vector<IndexEntry>& entries) {
+    sortIndexEntries(entries);
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const IndexEntry& a, const IndexEntry& b) {
+        return a.key == b.key;
+    }), entries.end());
+
+    uint32_t n = static_cast<uint32_t>(entries.size());
+    uint32_t buckets = n == 0 ? 0 : static_cast<uint32_t>((n + kKeysPerBucket - 1) / kKeysPerBucket);
+    uint32_t size = n == 0 ? 0 : n + n / 50 + 1;
+
+    std::vector<uint64_t> hashes(n);
+    std::vector<uint32_t> bucketStart(buckets + 1);
+    std::vector<uint32_t> members(n);       // Entry indices grouped by bucket
+    std::vector<uint32_t> order(buckets);   // Buckets, largest first
+    std::vector<uint16_t> pilots(buckets);
+    std::vector<uint64_t> positions(n);
+    std::vector<char> taken(size);
+    uint64_t seed = 0;
+    bool placed = n == 0;
+
+    for (int attempt = 0; attempt < kMaxSeeds && !placed; ++attempt) {
+        seed = mix(0x5A49504B45590000ull + attempt);
+
+        // Group entries by bucket with a counting sort
+        std::fill(bucketStart.begin(), bucketStart.end(), 0);
+        for (uint32_t i = 0; i < n; ++i) {
+            hashes[i] = keyHash(entries[i].key, seed);
+            ++bucketStart[bucketOf(hashes[i], buckets) + 1];
+        }
+        for (uint32_t b = 0; b < buckets; ++b) {
+            bucketStart[b + 1] += bucketStart[b];
+        }
+        std::vector<uint32_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+        for (uint32_t i = 0; i < n; ++i) {
+            members[fill[bucketOf(hashes[i], buckets)]++] = i;
+        }
+        for (uint32_t b = 0; b < buckets; ++b) {
+            order[b] = b;
+        }
+        std::stable_sort(order.begin(), order.end(), [&bucketStart](uint32_t a, uint32_t b) {
+            return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+        });
+
+        std::fill(taken.begin(), taken.end(), 0);
+        std::fill(pilots.begin(), pilots.end(), 0);
+        placed = true;
+        for (uint32_t b : order) {
+            uint32_t first = bucketStart[b];
+            uint32_t last = bucketStart[b + 1];
+            if (first == last) {
+                break;  // Every remaining bucket is empty
+            }
+            bool fits = false;
+            for (uint32_t pilot = 0; pilot <= kMaxPilot && !fits; ++pilot) {
+                fits = true;
+                for (uint32_t k = first; k < last && fits; ++k) {
+                    uint64_t position = positionOf(hashes[members[k]], static_cast<uint16_t>(pilot), size);
+                    fits = !taken[position] &&
+                           std::find(positions.begin() + first, positions.begin() + k, position) == positions.begin() + k;
+                    positions[k] = position;
+                }
+                if (fits) {
+                    pilots[b] = static_cast<uint16_t>(pilot);
+                }
+            }
+            if (!fits) {
+                placed = false;
+                break;
+            }
+            for (uint32_t k = first; k < last; ++k) {
+                taken[positions[k]] = 1;
+            }
+        }
+    }
+    if (!placed) {
+        std::cerr << "Unable to build a perfect hash function over " << n << " keys." << std::endl;
+        return false;
+    }
+
+    // Send every occupied position >= n to a free position below n
+    std::vector<uint32_t> remap(size - n, 0);
+    uint32_t freeSlot = 0;
+    for (uint32_t position = n; position < size; ++position) {
+        if (taken[position]) {
+            while (taken[freeSlot]) {
+                ++freeSlot;
+            }
+            remap[position - n] = freeSlot++;
+        }
+    }
+
+    std::vector<uint16_t> fingerprints(n);
+    std::vector<uint64_t> offsets(n);
+    for (uint32_t k = 0; k < n; ++k) {
+        uint32_t i = members[k];
+        uint64_t position = positions[k];
+        uint32_t slot = position < n ? static_cast<uint32_t>(position) : remap[position - n];
+        fingerprints[slot] = fingerprintOf(hashes[i]);
+        offsets[slot] = entries[i].offset;
+    }
+
+    writeIndexHeader(writer, kFileType, kVersion, n);
+    writer.write(&seed, sizeof(seed));
+    writer.write(&buckets, sizeof(buckets));
+    writer.write(&size, sizeof(size));
+
+    const char padding[8] = {};
+    size_t bytes = pilots.size() * sizeof(uint16_t);
+    writer.write(pilots.data(), bytes);
+    writer.write(padding, padded(bytes) - bytes);
+    bytes = remap.size() * sizeof(uint32_t);
+    writer.write(remap.data(), bytes);
+    writer.write(padding, padded(bytes) - bytes);
+    bytes = fingerprints.size() * sizeof(uint16_t);
+    writer.write(fingerprints.data(), bytes);
+    writer.write(padding, padded(bytes) - bytes);
+    return writer.write(offsets.data(), offsets.size() * sizeof(uint64_t));
+}
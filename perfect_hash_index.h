@@ -0,0 +1,95 @@
+/**
+ * @file perfect_hash_index.h
+ * @brief Header file for the PerfectHashIndex class.
+ *
+ * The data file only changes when it is regenerated, so its set of zip
+ * codes is known in full when the index is built. The PerfectHashIndex
+ * exploits this with a minimal perfect hash function: every key present
+ * in the data file maps to its own slot in [0, n), with no collisions and
+ * no empty slots. The function is described by one small "pilot" value per
+ * bucket of about five keys, so it costs a few bits per key; the slots
+ * hold a 16-bit fingerprint of their key and the record offset.
+ *
+ * A key that is not in the data file still hashes to some slot. The
+ * fingerprint rejects all but about one in 65,536 of these; callers that
+ * must never return a wrong record compare the zip code of the record read.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef PERFECT_HASH_INDEX_H
+#define PERFECT_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+#include "primary_key_index.h"
+
+/**
+ * @class PerfectHashIndex
+ * @brief Memory-mapped minimal perfect hash index from zip codes to record offsets.
+ *
+ * The construction follows the hash-and-displace scheme of PTHash. Keys
+ * are hashed into buckets; buckets are placed largest first, each trying
+ * pilot values until every key of the bucket lands on a free position of
+ * a table slightly larger than n. Positions at or above n are then
+ * remapped to the free positions below n, which makes the function minimal.
+ *
+ * A lookup computes the key hash, the pilot hash and the position, checks
+ * the fingerprint and reads the offset: three hash evaluations and two
+ * neighbouring array reads, with no probing.
+ */
+class PerfectHashIndex : public PrimaryKeyIndex {
+public:
+    static const char kFileType[];   /**< File type stored in the index header. */
+
+    /**
+     * @brief Maps an existing perfect hash index file.
+     * @return false if the file cannot be mapped or is not a perfect hash index.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Looks up a zip code.
+     * @return The record's file offset, or -1 if the fingerprint does not match.
+     */
+    int64_t find(uint32_t key) const override;
+
+    /**
+     * @brief Returns the number of keys in the index.
+     */
+    size_t size() const override { return count; }
+
+    /**
+     * @brief Returns PrimaryIndexType::PerfectHash.
+     */
+    PrimaryIndexType type() const override { return PrimaryIndexType::PerfectHash; }
+
+    /**
+     * @brief Builds the perfect hash function over the entries and writes the index.
+     *
+     * @param writer Destination, positioned at the start of the file.
+     * @param entries The entries in any order; the first of any duplicate keys is kept.
+     * @return false if no function could be found or a write fails.
+     */
+    static bool write(SequentialWriter& writer, std::vector<IndexEntry>& entries);
+
+private:
+    uint64_t slotFor(uint32_t key, uint64_t& hash) const;
+
+    MappedFile file;
+    size_t count = 0;                     /**< n, the number of keys and slots. */
+    uint64_t seed = 0;                    /**< Seed of the key hash. */
+    uint32_t bucketCount = 0;             /**< Number of pilots. */
+    uint32_t tableSize = 0;               /**< Positions before remapping (slightly above n). */
+    const uint16_t* pilots = nullptr;     /**< One pilot per bucket. */
+    const uint32_t* remap = nullptr;      /**< Slot for each position >= n. */
+    const uint16_t* fingerprints = nullptr;
+    const uint64_t* offsets = nullptr;
+};
+
+#endif // PERFECT_HASH_INDEX_H
@@ -0,0 +1,419 @@
+/**
+ * @file place_name_index.cpp
+ * @brief Implementation of the PlaceNameIndex class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "place_name_index.h"
+#include "primary_key_index.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <tuple>
+
+const char PlaceNameIndex::kFileType[] = "ZipCodePlaceNameIndex";
+const size_t PlaceNameIndex::kNodeSize;
+const size_t PlaceNameIndex::kPlaceSize;
+const uint32_t PlaceNameIndex::kNoPlace;
+const uint32_t PlaceNameIndex::kMaxCount;
+
+namespace {
+
+const uint16_t kVersion = 2;   // Version 2 packs the nodes and names and gap-codes the zip codes
+
+// Source stamp and the node, zip code, label and name counts follow the index header
+const size_t kParametersSize = SourceStamp::kEncodedSize + 4 * sizeof(uint32_t);
+
+// Longest label a node can hold; longer shared runs are split over several nodes
+const size_t kMaxLabelLength = 255;
+
+// Node and name fields are stored little-endian in width bytes
+void putField(std::string& out, uint32_t value, size_t width) {
+    for (size_t i = 0; i < width; ++i) {
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+uint32_t getField(const char* at, size_t width) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < width; ++i) {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(at[i])) << (8 * i);
+    }
+    return value;
+}
+
+void appendVarint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// Names are stored and compared in lower case
+std::string foldName(const std::string& name) {
+    std::string folded(name);
+    std::transform(folded.begin(), folded.end(), folded.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return folded;
+}
+
+/**
+ * @struct Candidate
+ * @brief A subtree or a name waiting in the best-first search.
+ *
+ * A subtree's key is the folded prefix it stands for, which no name in it
+ * sorts before, so taking candidates by most zip codes and then smallest
+ * key yields names in exactly the ranking order.
+ */
+struct Candidate {
+    uint32_t score;    /**< Zip codes of the name, or the most of any name in the subtree. */
+    std::string key;   /**< The folded name or prefix. */
+    uint32_t id;       /**< Place index for a name, node index for a subtree. */
+    bool isPlace;
+};
+
+// Orders the priority queue so its top is the next candidate to take;
+// a name comes before the subtree it ends
+bool takenAfter(const Candidate& a, const Candidate& b) {
+    if (a.score != b.score) {
+        return a.score < b.score;
+    }
+    if (a.key != b.key) {
+        return a.key > b.key;
+    }
+    return !a.isPlace && b.isPlace;
+}
+
+} // namespace
+
+/**
+ * @brief Maps an existing place name index file.
+ *
+ * Every node's children, label and name and every name's zip codes and
+ * spelling are checked to lie inside the file, so searches need no checks.
+ */
+bool PlaceNameIndex::open(const std::string& filename) {
+    nodeCount = placeCount = 0;
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != kVersion ||
+        file.size() < header.headerSize + kParametersSize) {
+        return false;
+    }
+    const char* parameters = file.data() + header.headerSize;
+    uint32_t counts[4];   // Nodes, zip code bytes, label bytes, name bytes
+    std::memcpy(counts, parameters + SourceStamp::kEncodedSize, sizeof(counts));
+    uint64_t nodesAt = header.headerSize + kParametersSize;
+    uint64_t placesAt = nodesAt + static_cast<uint64_t>(counts[0]) * kNodeSize;
+    uint64_t zipsAt = placesAt + static_cast<uint64_t>(header.entryCount) * kPlaceSize;
+    uint64_t labelsAt = zipsAt + counts[1];
+    uint64_t namesAt = labelsAt + counts[2];
+    if (counts[0] == 0 || file.size() < namesAt + counts[3]) {
+        return false;
+    }
+    nodes = file.data() + nodesAt;
+    places = file.data() + placesAt;
+    zips = reinterpret_cast<const uint8_t*>(file.data() + zipsAt);
+    zipBytes = counts[1];
+    for (uint32_t i = 0; i < counts[0]; ++i) {
+        Node node = nodeAt(i);
+        if (static_cast<uint64_t>(node.firstChild) + node.childCount > counts[0] ||
+            static_cast<uint64_t>(node.labelAt) + node.labelLength > counts[2] ||
+            (node.place != kNoPlace && node.place >= header.entryCount)) {
+            return false;
+        }
+    }
+    std::vector<uint32_t> values;
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        Place place = placeAt(i);
+        if (static_cast<uint64_t>(place.nameAt) + place.nameLength > counts[3] || !readZips(place, values)) {
+            return false;
+        }
+    }
+    source.decode(parameters);
+    nodeCount = counts[0];
+    placeCount = header.entryCount;
+    labels = file.data() + labelsAt;
+    names = file.data() + namesAt;
+    return true;
+}
+
+PlaceNameIndex::Node PlaceNameIndex::nodeAt(uint32_t index) const {
+    const char* at = nodes + static_cast<size_t>(index) * kNodeSize;
+    Node node;
+    node.firstChild = getField(at, 3);
+    node.labelAt = getField(at + 3, 3);
+    node.place = getField(at + 6, 3);
+    node.best = getField(at + 9, 2);
+    node.childCount = getField(at + 11, 2);
+    node.labelLength = getField(at + 13, 1);
+    return node;
+}
+
+PlaceNameIndex::Place PlaceNameIndex::placeAt(uint32_t index) const {
+    const char* at = places + static_cast<size_t>(index) * kPlaceSize;
+    Place place;
+    place.nameAt = getField(at, 4);
+    place.zipAt = getField(at + 4, 4);
+    place.zipCount = getField(at + 8, 2);
+    place.nameLength = getField(at + 10, 2);
+    return place;
+}
+
+/**
+ * @brief Decodes a name's zip codes, adding each gap to the previous zip code.
+ * @return false if the list runs past the zip code pool or a zip code does not fit in 32 bits.
+ */
+bool PlaceNameIndex::readZips(const Place& place, std::vector<uint32_t>& values) const {
+    values.clear();
+    if (place.zipAt > zipBytes) {
+        return false;
+    }
+    const uint8_t* position = zips + place.zipAt;
+    const uint8_t* end = zips + zipBytes;
+    uint64_t previous = 0;
+    for (uint32_t i = 0; i < place.zipCount; ++i) {
+        uint64_t gap = 0;
+        unsigned shift = 0;
+        for (;;) {
+            if (position == end || shift > 28) {
+                return false;
+            }
+            uint8_t byte = *position++;
+            gap |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            shift += 7;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+        previous += gap;
+        if (previous > UINT32_MAX) {
+            return false;
+        }
+        values.push_back(static_cast<uint32_t>(previous));
+    }
+    return true;
+}
+
+/**
+ * @brief Finds the names that start with a prefix.
+ *
+ * The prefix is followed down the trie, possibly ending inside a label.
+ * From that node a best-first search takes subtrees and names by zip code
+ * count: a subtree's count is the best of any name in it, so once limit
+ * names have been taken nothing left in the queue can outrank them.
+ */
+void PlaceNameIndex::complete(const std::string& prefix, size_t limit, std::vector<PlaceCompletion>& completions) const {
+    completions.clear();
+    if (nodeCount == 0 || limit == 0) {
+        return;
+    }
+
+    // Follow the prefix from the root
+    std::string folded = foldName(prefix);
+    std::string path;
+    uint32_t current = 0;
+    size_t matched = 0;
+    while (matched < folded.size()) {
+        Node node = nodeAt(current);
+        uint32_t next = kNoPlace;
+        Node child;
+        for (uint32_t index = node.firstChild; index < node.firstChild + node.childCount; ++index) {
+            child = nodeAt(index);
+            if (child.labelLength > 0 && labels[child.labelAt] == folded[matched]) {
+                next = index;
+                break;
+            }
+        }
+        if (next == kNoPlace) {
+            return;
+        }
+        size_t length = std::min<size_t>(child.labelLength, folded.size() - matched);
+        if (folded.compare(matched, length, labels + child.labelAt, length) != 0) {
+            return;
+        }
+        path.append(labels + child.labelAt, child.labelLength);
+        matched += length;
+        current = next;
+    }
+
+    std::priority_queue<Candidate, std::vector<Candidate>, bool (*)(const Candidate&, const Candidate&)> queue(takenAfter);
+    queue.push(Candidate{ nodeAt(current).best, path, current, false });
+    while (!queue.empty() && completions.size() < limit) {
+        Candidate top = queue.top();
+        queue.pop();
+        if (top.isPlace) {
+            Place place = placeAt(top.id);
+            PlaceCompletion completion;
+            completion.placeName.assign(names + place.nameAt, place.nameLength);
+            readZips(place, completion.zips);
+            completions.push_back(completion);
+            continue;
+        }
+        Node node = nodeAt(top.id);
+        if (node.place != kNoPlace) {
+            queue.push(Candidate{ placeAt(node.place).zipCount, top.key, node.place, true });
+        }
+        for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; ++child) {
+            Node below = nodeAt(child);
+            queue.push(Candidate{ below.best, top.key + std::string(labels + below.labelAt, below.labelLength),
+                                  child, false });
+        }
+    }
+}
+
+/**
+ * @brief Writes a place name index.
+ *
+ * The pairs are grouped by folded name; a name is spelled as its first
+ * spelling in sort order. The trie is built depth first over the sorted
+ * folded names: a node takes the name equal to its path, if any, and gets
+ * one child per next character, labelled with the longest prefix the
+ * names under that child share. Each node's children are allocated
+ * together before any of them is expanded, so they stay consecutive.
+ * Fails if the names outgrow the packed fields: 2^24 - 1 nodes, names or
+ * label bytes, or 65535 zip codes or bytes in one name.
+ */
+bool PlaceNameIndex::write(const std::string& filename, std::vector<std::pair<std::string, uint32_t>>& entries,
+                           const SourceStamp& source) {
+    // Sort by folded name, then spelling, then zip code
+    std::vector<std::tuple<std::string, std::string, uint32_t>> folded;
+    folded.reserve(entries.size());
+    for (const auto& entry : entries) {
+        folded.push_back(std::make_tuple(foldName(entry.first), entry.first, entry.second));
+    }
+    std::sort(folded.begin(), folded.end());
+
+    std::vector<std::string> keys;
+    std::vector<Place> placeList;
+    std::vector<uint32_t> placeZips;
+    std::string zipPool;
+    std::string nameBytes;
+    bool fits = true;
+    for (size_t first = 0; first < folded.size();) {
+        const std::string& key = std::get<0>(folded[first]);
+        Place place;
+        place.nameAt = static_cast<uint32_t>(nameBytes.size());
+        place.nameLength = static_cast<uint32_t>(std::get<1>(folded[first]).size());
+        place.zipAt = static_cast<uint32_t>(zipPool.size());
+        nameBytes += std::get<1>(folded[first]);
+        size_t last = first;
+        placeZips.clear();
+        for (; last < folded.size() && std::get<0>(folded[last]) == key; ++last) {
+            placeZips.push_back(std::get<2>(folded[last]));
+        }
+        std::sort(placeZips.begin(), placeZips.end());
+        placeZips.erase(std::unique(placeZips.begin(), placeZips.end()), placeZips.end());
+        uint32_t previous = 0;
+        for (uint32_t zip : placeZips) {
+            appendVarint(zipPool, zip - previous);
+            previous = zip;
+        }
+        place.zipCount = static_cast<uint32_t>(placeZips.size());
+        fits = fits && place.zipCount <= kMaxCount && place.nameLength <= kMaxCount;
+        placeList.push_back(place);
+        keys.push_back(key);
+        first = last;
+    }
+
+    std::vector<Node> nodeList(1, Node{ 0, 0, 0, kNoPlace, 0, 0 });
+    std::string labelBytes;
+    std::function<void(uint32_t, size_t, size_t, size_t)> expand =
+        [&](uint32_t index, size_t low, size_t high, size_t depth) {
+        uint32_t best = 0;
+        if (low < high && keys[low].size() == depth) {
+            nodeList[index].place = static_cast<uint32_t>(low);
+            best = placeList[low].zipCount;
+            ++low;
+        }
+        // One child per run of names with the same next character
+        std::vector<std::pair<size_t, size_t>> runs;
+        for (size_t first = low; first < high;) {
+            size_t last = first + 1;
+            while (last < high && keys[last][depth] == keys[first][depth]) {
+                ++last;
+            }
+            runs.push_back(std::make_pair(first, last));
+            first = last;
+        }
+        uint32_t firstChild = static_cast<uint32_t>(nodeList.size());
+        nodeList[index].firstChild = firstChild;
+        nodeList[index].childCount = static_cast<uint32_t>(runs.size());
+        nodeList.resize(nodeList.size() + runs.size(), Node{ 0, 0, 0, kNoPlace, 0, 0 });
+        for (size_t i = 0; i < runs.size(); ++i) {
+            // The first and last names of a sorted run share what every name of it shares
+            const std::string& a = keys[runs[i].first];
+            const std::string& b = keys[runs[i].second - 1];
+            size_t shared = depth + 1;
+            while (shared < a.size() && shared < b.size() && a[shared] == b[shared]) {
+                ++shared;
+            }
+            size_t length = std::min(shared - depth, kMaxLabelLength);
+            Node& child = nodeList[firstChild + i];
+            child.labelAt = static_cast<uint32_t>(labelBytes.size());
+            child.labelLength = static_cast<uint32_t>(length);
+            labelBytes.append(a, depth, length);
+            expand(firstChild + static_cast<uint32_t>(i), runs[i].first, runs[i].second, depth + length);
+            best = std::max(best, nodeList[firstChild + i].best);
+        }
+        nodeList[index].best = best;
+    };
+    expand(0, 0, keys.size(), 0);
+
+    if (!fits || nodeList.size() > kNoPlace || placeList.size() >= kNoPlace || labelBytes.size() > kNoPlace ||
+        nameBytes.size() > UINT32_MAX || zipPool.size() > UINT32_MAX) {
+        std::cerr << "Too many place names for the place name index: " << filename << std::endl;
+        return false;
+    }
+    std::string nodeBytes;
+    for (const Node& node : nodeList) {
+        putField(nodeBytes, node.firstChild, 3);
+        putField(nodeBytes, node.labelAt, 3);
+        putField(nodeBytes, node.place, 3);
+        putField(nodeBytes, node.best, 2);
+        putField(nodeBytes, node.childCount, 2);
+        putField(nodeBytes, node.labelLength, 1);
+    }
+    std::string placeBytes;
+    for (const Place& place : placeList) {
+        putField(placeBytes, place.nameAt, 4);
+        putField(placeBytes, place.zipAt, 4);
+        putField(placeBytes, place.zipCount, 2);
+        putField(placeBytes, place.nameLength, 2);
+    }
+
+    TemporaryFile temporary(filename);
+    std::unique_ptr<IoBackend> out = openIoBackend(temporary.getFilename(), IoWorkload::Write);
+    if (!out) {
+        std::cerr << "Unable to write place name index: " << filename << std::endl;
+        return false;
+    }
+    SequentialWriter writer(*out);
+    writeIndexHeader(writer, kFileType, kVersion, static_cast<uint32_t>(placeList.size()));
+    char stamp[SourceStamp::kEncodedSize];
+    source.encode(stamp);
+    writer.write(stamp, sizeof(stamp));
+    uint32_t counts[4] = { static_cast<uint32_t>(nodeList.size()), static_cast<uint32_t>(zipPool.size()),
+                           static_cast<uint32_t>(labelBytes.size()), static_cast<uint32_t>(nameBytes.size()) };
+    writer.write(counts, sizeof(counts));
+    writer.write(nodeBytes.data(), nodeBytes.size());
+    writer.write(placeBytes.data(), placeBytes.size());
+    writer.write(zipPool.data(), zipPool.size());
+    writer.write(labelBytes.data(), labelBytes.size());
+    writer.write(nameBytes.data(), nameBytes.size());
+    if (!writer.finish()) {
+        std::cerr << "Error writing place name index: " << filename << std::endl;
+        return false;
+    }
+    out.reset();
+    return temporary.commit();
+}
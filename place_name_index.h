@@ -0,0 +1,145 @@
+/**
+ * @file place_name_index.h
+ * @brief Header file for the PlaceNameIndex class.
+ *
+ * Address forms complete place names as they are typed. The place name
+ * index is a radix trie over the case-folded place names, written while
+ * the data file is generated and searched in place through a memory
+ * mapping. Each name leads to the zip codes of every place with that name,
+ * and each trie node records the most zip codes any name below it has, so
+ * the best completions of a prefix are found without visiting every name
+ * that starts with it.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef PLACE_NAME_INDEX_H
+#define PLACE_NAME_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "io_backend.h"
+#include "source_stamp.h"
+
+/**
+ * @struct PlaceCompletion
+ * @brief A place name that completes a prefix and its zip codes.
+ */
+struct PlaceCompletion {
+    std::string placeName;        /**< The name as spelled in the data. */
+    std::vector<uint32_t> zips;   /**< Numeric zip codes of the places with that name, ascending. */
+};
+
+/**
+ * @class PlaceNameIndex
+ * @brief Memory-mapped radix trie from case-folded place names to zip code lists.
+ *
+ * The file holds the binary index header (whose entry count is the number
+ * of distinct names), the stamp of the CSV the index was generated from,
+ * the node count and the zip code, label and name byte counts, then the
+ * nodes (kNodeSize bytes each), one kPlaceSize-byte entry per name, the
+ * zip codes, the edge labels and the spelled names. Each name's zip codes
+ * are stored ascending as LEB128 varints of the gap from the previous one
+ * (the first from 0). Node 0 is the root; a node's children are consecutive
+ * and ordered by label. Names are folded to lower case before they are
+ * stored or compared. Completions are ranked by number of zip codes, then
+ * by name.
+ */
+class PlaceNameIndex {
+public:
+    static const char kFileType[];   /**< File type stored in the index header. */
+    static const size_t kNodeSize = 14;    /**< Bytes per stored node. */
+    static const size_t kPlaceSize = 12;   /**< Bytes per stored name entry. */
+
+    /**
+     * @brief Maps an existing place name index file.
+     * @return false if the file cannot be mapped or is not a place name index.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Finds the names that start with a prefix.
+     *
+     * @param prefix The typed prefix; case does not matter.
+     * @param limit The most completions to return.
+     * @param completions Receives up to limit completions, the names with the most zip codes first.
+     */
+    void complete(const std::string& prefix, size_t limit, std::vector<PlaceCompletion>& completions) const;
+
+    /**
+     * @brief Returns the number of distinct names.
+     */
+    size_t size() const { return placeCount; }
+
+    /**
+     * @brief Returns the stamp of the CSV the index was generated from.
+     */
+    const SourceStamp& getSourceStamp() const { return source; }
+
+    /**
+     * @brief Writes a place name index.
+     *
+     * @param filename The index file to create.
+     * @param entries (place name, numeric zip code) pairs in any order; sorted in place.
+     * @param source Stamp of the CSV the records came from.
+     * @return true if the file was written.
+     */
+    static bool write(const std::string& filename, std::vector<std::pair<std::string, uint32_t>>& entries,
+                      const SourceStamp& source);
+
+private:
+    /**
+     * @struct Node
+     * @brief A trie node: the edge label into it, its children and the best count below it.
+     *
+     * Stored in kNodeSize bytes: 3-byte firstChild, labelAt and place,
+     * 2-byte best and childCount, then the 1-byte labelLength.
+     */
+    struct Node {
+        uint32_t firstChild;    /**< Index of the first child. */
+        uint32_t labelAt;       /**< Offset of the edge label in the label pool. */
+        uint32_t best;          /**< Most zip codes of any name in the subtree. */
+        uint32_t place;         /**< Name ending at this node, or kNoPlace. */
+        uint32_t childCount;
+        uint32_t labelLength;
+    };
+
+    /**
+     * @struct Place
+     * @brief A distinct name: its spelling and its zip codes.
+     *
+     * Stored in kPlaceSize bytes: 4-byte nameAt and zipAt, then 2-byte
+     * zipCount and nameLength.
+     */
+    struct Place {
+        uint32_t nameAt;        /**< Offset of the spelled name in the name pool. */
+        uint32_t zipAt;         /**< Offset of the first zip code's varint in the zip code pool. */
+        uint32_t zipCount;
+        uint32_t nameLength;
+    };
+
+    static const uint32_t kNoPlace = 0xFFFFFF;        /**< Largest 3-byte value. */
+    static const uint32_t kMaxCount = UINT16_MAX;     /**< Largest zip count, name length or child count. */
+
+    Node nodeAt(uint32_t index) const;
+    Place placeAt(uint32_t index) const;
+    bool readZips(const Place& place, std::vector<uint32_t>& values) const;
+
+    MappedFile file;
+    const char* nodes = nullptr;       /**< kNodeSize bytes per node. */
+    const char* places = nullptr;      /**< kPlaceSize bytes per name. */
+    const uint8_t* zips = nullptr;     /**< Gap-coded zip code lists, back to back. */
+    const char* labels = nullptr;      /**< Edge labels, back to back. */
+    const char* names = nullptr;       /**< Spelled names, back to back. */
+    size_t nodeCount = 0;
+    size_t placeCount = 0;
+    size_t zipBytes = 0;
+    SourceStamp source;
+};
+
+#endif // PLACE_NAME_INDEX_H
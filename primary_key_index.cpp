@@ -0,0 +1,580 @@
+/**
+ * @file primary_key_index.cpp
+ * @brief Implementation of the text and sorted binary primary key indexes
+ *        and of the factory shared by all index formats.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "primary_key_index.h"
+#include "bplus_tree_index.h"
+#include "direct_address_index.h"
+#include "perfect_hash_index.h"
+#include "learned_index.h"
+#include "eytzinger_index.h"
+#include "compressed_index.h"
+#include "sparse_index.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const char kSortedIndexType[] = "ZipCodeSortedIndex";
+const size_t kSortedEntrySize = sizeof(uint32_t) + sizeof(uint64_t);  // Packed key and offset
+
+inline void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+inline uint32_t keyAtElement(const char* base, size_t stride, size_t position) {
+    uint32_t key;
+    std::memcpy(&key, base + position * stride, sizeof(key));
+    return key;
+}
+
+/**
+ * @class TextPrimaryKeyIndex
+ * @brief The original "zip offset" text index, scanned line by line on every lookup.
+ */
+class TextPrimaryKeyIndex : public PrimaryKeyIndex {
+public:
+    bool open(const std::string& name) {
+        filename = name;
+        backend = openIoBackend(name, IoWorkload::Scan);
+        return backend != nullptr;
+    }
+
+    int64_t find(uint32_t key) const override {
+        SequentialReader reader(*backend);
+        std::string line;
+        while (reader.readUntil('\n', line)) {
+            std::string::size_type space = line.find(' ');
+            uint32_t lineKey;
+            if (space != std::string::npos && parseZipKey(line.substr(0, space), lineKey) && lineKey == key) {
+                return parseOffset(line.c_str() + space + 1);
+            }
+        }
+        return -1;
+    }
+
+    // Counted on first use, so opening the index does not read the whole file
+    size_t size() const override {
+        std::call_once(counted, [this] {
+            SequentialReader reader(*backend);
+            std::string line;
+            while (reader.readUntil('\n', line)) {
+                ++lineCount;
+            }
+        });
+        return lineCount;
+    }
+
+    PrimaryIndexType type() const override { return PrimaryIndexType::Text; }
+
+    // Whether the start of a file is a "zip offset" line, so that an empty,
+    // truncated or foreign file is not mistaken for a text index
+    static bool startsWithEntry(const char* start, size_t length) {
+        const char* newline = static_cast<const char*>(std::memchr(start, '\n', length));
+        if (!newline && length == kProbeSize) {
+            return false;  // Longer than any entry line
+        }
+        std::string line(start, newline ? static_cast<size_t>(newline - start) : length);
+        std::string::size_type space = line.find(' ');
+        uint32_t key;
+        return space != std::string::npos && parseZipKey(line.substr(0, space), key) &&
+               parseOffset(line.c_str() + space + 1) >= 0;
+    }
+
+    static const size_t kProbeSize = 64;  /**< Bytes read to tell the formats apart. */
+
+private:
+    // A malformed offset makes the key not found rather than throwing
+    static int64_t parseOffset(const char* text) {
+        char* end = nullptr;
+        errno = 0;
+        unsigned long long offset = std::strtoull(text, &end, 10);
+        while (*end == ' ' || *end == '\r') {
+            ++end;
+        }
+        if (end == text || *end != '\0' || errno == ERANGE || *text == '-' ||
+            offset > static_cast<unsigned long long>(INT64_MAX)) {
+            return -1;
+        }
+        return static_cast<int64_t>(offset);
+    }
+
+    std::string filename;
+    std::unique_ptr<IoBackend> backend;
+    mutable std::once_flag counted;
+    mutable size_t lineCount = 0;
+};
+
+/**
+ * @class SortedRangeCursor
+ * @brief Walks packed sorted entries forward from a position until a key exceeds the range.
+ */
+class SortedRangeCursor : public IndexCursor {
+public:
+    SortedRangeCursor(const char* entries, size_t position, size_t count, uint32_t high)
+        : entries(entries), position(position), count(count), high(high) {}
+
+    bool next(IndexEntry& entry) override {
+        if (position >= count) {
+            return false;
+        }
+        const char* packed = entries + position * kSortedEntrySize;
+        std::memcpy(&entry.key, packed, sizeof(entry.key));
+        if (entry.key > high) {
+            position = count;
+            return false;
+        }
+        std::memcpy(&entry.offset, packed + sizeof(entry.key), sizeof(entry.offset));
+        ++position;
+        return true;
+    }
+
+private:
+    const char* entries;
+    size_t position;
+    size_t count;
+    uint32_t high;
+};
+
+/**
+ * @class SortedPrimaryKeyIndex
+ * @brief Memory-mapped array of (key, offset) entries sorted by key.
+ *
+ * Lookups are a binary search over the mapping; nothing is parsed or copied.
+ */
+class SortedPrimaryKeyIndex : public PrimaryKeyIndex {
+public:
+    bool open(const std::string& filename) {
+        IndexFileHeader header;
+        if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+            header.fileType != kSortedIndexType || header.version != 1 ||
+            file.size() < header.headerSize + static_cast<uint64_t>(header.entryCount) * kSortedEntrySize) {
+            return false;
+        }
+        entries = file.data() + header.headerSize;
+        count = header.entryCount;
+        return true;
+    }
+
+    int64_t find(uint32_t key) const override {
+        size_t position = lowerBound(key);
+        if (position < count && keyAt(position) == key) {
+            uint64_t offset;
+            std::memcpy(&offset, entries + position * kSortedEntrySize + sizeof(uint32_t), sizeof(offset));
+            return static_cast<int64_t>(offset);
+        }
+        return -1;
+    }
+
+    void findMany(const uint32_t* keys, size_t keyCount, int64_t* offsets) const override {
+        size_t positions[kBatchSearchWidth];
+        for (size_t start = 0; start < keyCount; start += kBatchSearchWidth) {
+            size_t width = std::min(kBatchSearchWidth, keyCount - start);
+            batchLowerBound(entries, kSortedEntrySize, count, keys + start, width, positions);
+            for (size_t i = 0; i < width; ++i) {
+                offsets[start + i] = -1;
+                if (positions[i] < count && keyAt(positions[i]) == keys[start + i]) {
+                    uint64_t offset;
+                    std::memcpy(&offset, entries + positions[i] * kSortedEntrySize + sizeof(uint32_t), sizeof(offset));
+                    offsets[start + i] = static_cast<int64_t>(offset);
+                }
+            }
+        }
+    }
+
+    size_t size() const override { return count; }
+
+    PrimaryIndexType type() const override { return PrimaryIndexType::Sorted; }
+
+    std::unique_ptr<IndexCursor> openRange(uint32_t low, uint32_t high) const override {
+        size_t position = low <= high ? lowerBound(low) : count;
+        return std::unique_ptr<IndexCursor>(new SortedRangeCursor(entries, position, count, high));
+    }
+
+private:
+    size_t lowerBound(uint32_t key) const {
+        size_t low = 0;
+        size_t high = count;
+        while (low < high) {
+            size_t middle = low + (high - low) / 2;
+            if (keyAt(middle) < key) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    uint32_t keyAt(size_t index) const {
+        uint32_t key;
+        std::memcpy(&key, entries + index * kSortedEntrySize, sizeof(key));
+        return key;
+    }
+
+    MappedFile file;
+    const char* entries = nullptr;
+    size_t count = 0;
+};
+
+bool writeTextIndex(SequentialWriter& writer, const std::vector<IndexEntry>& entries) {
+    std::string line;
+    for (const auto& entry : entries) {
+        line = std::to_string(entry.key);
+        line += ' ';
+        line += std::to_string(entry.offset);
+        line += '\n';
+        if (!writer.write(line.data(), line.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool writeSortedIndex(SequentialWriter& writer, std::vector<IndexEntry>& entries) {
+    sortIndexEntries(entries);
+    writeIndexHeader(writer, kSortedIndexType, 1, static_cast<uint32_t>(entries.size()));
+    for (const auto& entry : entries) {
+        writer.write(&entry.key, sizeof(entry.key));
+        writer.write(&entry.offset, sizeof(entry.offset));
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseZipKey(const std::string& zipCode, uint32_t& key) {
+    return parseRecordZipKey(zipCode.data(), zipCode.size(), key) && zipCode.find(',') == std::string::npos;
+}
+
+bool zipPrefixRange(const std::string& prefix, uint32_t& low, uint32_t& high) {
+    const size_t kZipDigits = 5;
+    uint32_t key;
+    if (!parseZipKey(prefix, key)) {
+        return false;
+    }
+    uint32_t scale = 1;
+    for (size_t digits = prefix.size(); digits < kZipDigits; ++digits) {
+        scale *= 10;
+    }
+    low = key * scale;
+    high = low + (scale - 1);
+    return true;
+}
+
+/**
+ * @brief Converts the zip code field at the start of a record to its numeric key.
+ *
+ * The field ends at the first comma or at the end of the data.
+ */
+bool parseRecordZipKey(const char* data, size_t length, uint32_t& key) {
+    uint32_t value = 0;
+    size_t digits = 0;
+    while (digits < length && data[digits] != ',') {
+        char c = data[digits];
+        if (c < '0' || c > '9' || digits == 9) {
+            return false;
+        }
+        value = value * 10 + static_cast<uint32_t>(c - '0');
+        ++digits;
+    }
+    if (digits == 0) {
+        return false;
+    }
+    key = value;
+    return true;
+}
+
+const char* primaryIndexTypeName(PrimaryIndexType type) {
+    switch (type) {
+        case PrimaryIndexType::Text:   return "text";
+        case PrimaryIndexType::Sorted: return "sorted";
+        case PrimaryIndexType::BPlusTree: return "bptree";
+        case PrimaryIndexType::Direct: return "direct";
+        case PrimaryIndexType::PerfectHash: return "mph";
+        case PrimaryIndexType::Learned: return "learned";
+        case PrimaryIndexType::Eytzinger: return "eytzinger";
+        case PrimaryIndexType::Compressed: return "compressed";
+        case PrimaryIndexType::Sparse: return "sparse";
+    }
+    return "unknown";
+}
+
+bool parsePrimaryIndexType(const std::string& name, PrimaryIndexType& type) {
+    if (name == "text") {
+        type = PrimaryIndexType::Text;
+    } else if (name == "sorted") {
+        type = PrimaryIndexType::Sorted;
+    } else if (name == "bptree") {
+        type = PrimaryIndexType::BPlusTree;
+    } else if (name == "direct") {
+        type = PrimaryIndexType::Direct;
+    } else if (name == "mph") {
+        type = PrimaryIndexType::PerfectHash;
+    } else if (name == "learned") {
+        type = PrimaryIndexType::Learned;
+    } else if (name == "eytzinger") {
+        type = PrimaryIndexType::Eytzinger;
+    } else if (name == "compressed") {
+        type = PrimaryIndexType::Compressed;
+    } else if (name == "sparse") {
+        type = PrimaryIndexType::Sparse;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<PrimaryKeyIndex> openPrimaryKeyIndex(const std::string& filename, const std::string& dataFilename) {
+    // Peek at the start of the file to tell the formats apart
+    std::unique_ptr<IoBackend> probe = openIoBackend(filename, IoMode::Read, IoBackendType::Pread);
+    if (!probe) {
+        std::cerr << "Unable to open index file: " << filename << std::endl;
+        return nullptr;
+    }
+    char start[TextPrimaryKeyIndex::kProbeSize] = {};
+    long long n = probe->readAt(start, sizeof(start), 0);
+    IndexFileHeader header;
+    bool binary = n > 0 && readIndexHeader(start, static_cast<uint64_t>(n), header);
+    probe.reset();
+
+    if (!binary) {
+        // Only a file that starts with a text entry is a text index; anything
+        // else, including an empty file left by an interrupted write, is corrupt
+        if (n <= 0 || !TextPrimaryKeyIndex::startsWithEntry(start, static_cast<size_t>(n))) {
+            std::cerr << "Corrupt index file: " << filename << std::endl;
+            return nullptr;
+        }
+        std::unique_ptr<TextPrimaryKeyIndex> index(new TextPrimaryKeyIndex());
+        if (index->open(filename)) {
+            return std::unique_ptr<PrimaryKeyIndex>(std::move(index));
+        }
+    } else if (header.fileType == kSortedIndexType) {
+        std::unique_ptr<SortedPrimaryKeyIndex> index(new SortedPrimaryKeyIndex());
+        if (index->open(filename)) {
+            return std::unique_ptr<PrimaryKeyIndex>(std::move(index));
+        }
+    } else if (header.fileType == BPlusTreeIndex::kFileType) {
+        std::unique_ptr<BPlusTreeIndex> index(new BPlusTreeIndex());
+        if (index->open(filename)) {
+            return std::unique_ptr<PrimaryKeyIndex>(std::move(index));
+        }
+    } else if (header.fileType == DirectAddressIndex::kFileType) {
+        std::unique_ptr<DirectAddressIndex> index(new DirectAddressIndex());
+        if (index->open(filename)) {
+            return std::unique_ptr<PrimaryKeyIndex>(std::move(index));
+        }
+    } else if (header.fileType == PerfectHashIndex::kFileType) {
+        std::unique_ptr<PerfectHashIndex> index(new PerfectHashIndex());
+        if (index->open(filename)) {
+            return std::unique_ptr<PrimaryKeyIndex>(std::move(index));
+        }
+    } else if (header.fileType == LearnedIndex::kFileType) {
+        std::unique_ptr<LearnedIndex> index(new LearnedIndex());
+        if (index->open(filename)) {
+            return std::unique_ptr<PrimaryKeyIndex>(std::move(index));
+        }
+    } else if (header.fileType == EytzingerIndex::kFileType) {
+        std::unique_ptr<EytzingerIndex> index(new EytzingerIndex());
+        if (index->open(filename)) {
+            return std::unique_ptr<PrimaryKeyIndex>(std::move(index));
+        }
+    } else if (header.fileType == CompressedIndex::kFileType) {
+        std::unique_ptr<CompressedIndex> index(new CompressedIndex());
+        if (index->open(filename)) {
+            return std::unique_ptr<PrimaryKeyIndex>(std::move(index));
+        }
+    } else if (header.fileType == SparseIndex::kFileType) {
+        std::unique_ptr<SparseIndex> index(new SparseIndex());
+        if (index->open(filename, dataFilename)) {
+            return std::unique_ptr<PrimaryKeyIndex>(std::move(index));
+        }
+    }
+
+    std::cerr << "Invalid index file: " << filename << std::endl;
+    return nullptr;
+}
+
+bool writePrimaryKeyIndex(const std::string& filename, std::vector<IndexEntry>& entries, PrimaryIndexType type,
+                          const std::string& dataFilename) {
+    TemporaryFile temporary(filename);
+    std::unique_ptr<IoBackend> indexFile = openIoBackend(temporary.getFilename(), IoWorkload::Write);
+    if (!indexFile) {
+        std::cerr << "Unable to open index file: " << filename << std::endl;
+        return false;
+    }
+    SequentialWriter writer(*indexFile);
+
+    bool written = false;
+    switch (type) {
+        case PrimaryIndexType::Text:   written = writeTextIndex(writer, entries); break;
+        case PrimaryIndexType::Sorted: written = writeSortedIndex(writer, entries); break;
+        case PrimaryIndexType::BPlusTree: written = BPlusTreeIndex::write(writer, entries); break;
+        case PrimaryIndexType::Direct: written = DirectAddressIndex::write(writer, entries); break;
+        case PrimaryIndexType::PerfectHash: written = PerfectHashIndex::write(writer, entries); break;
+        case PrimaryIndexType::Learned: written = LearnedIndex::write(writer, entries); break;
+        case PrimaryIndexType::Eytzinger: written = EytzingerIndex::write(writer, entries); break;
+        case PrimaryIndexType::Compressed: written = CompressedIndex::write(writer, entries); break;
+        case PrimaryIndexType::Sparse: written = SparseIndex::write(writer, entries, dataFilename); break;
+    }
+
+    if (!written || !writer.finish()) {
+        std::cerr << "Error writing index file: " << filename << std::endl;
+        return false;
+    }
+    indexFile.reset();
+    return temporary.commit();
+}
+
+/**
+ * @brief Binary searches an array for many keys at once.
+ *
+ * Every search of a group has the same length sequence (count, then
+ * count - count / 2, ...), so the group advances one level at a time: each
+ * search compares its probe, moves its base without a branch and
+ * prefetches its next probe, then the next search of the group does the
+ * same. A single search would wait for every probe in turn; here up to
+ * kBatchSearchWidth misses are outstanding together.
+ */
+void batchLowerBound(const char* base, size_t stride, size_t count,
+                     const uint32_t* queries, size_t queryCount, size_t* positions) {
+    size_t first[kBatchSearchWidth];
+    for (size_t start = 0; start < queryCount; start += kBatchSearchWidth) {
+        size_t width = std::min(kBatchSearchWidth, queryCount - start);
+        const uint32_t* group = queries + start;
+        if (count == 0) {
+            std::fill(positions + start, positions + start + width, 0);
+            continue;
+        }
+        std::fill(first, first + width, 0);
+        for (size_t length = count; length > 1;) {
+            size_t half = length / 2;
+            size_t nextHalf = (length - half) / 2;
+            for (size_t i = 0; i < width; ++i) {
+                first[i] += keyAtElement(base, stride, first[i] + half) < group[i] ? half : 0;
+                prefetch(base + (first[i] + nextHalf) * stride);
+            }
+            length -= half;
+        }
+        for (size_t i = 0; i < width; ++i) {
+            positions[start + i] = first[i] + (keyAtElement(base, stride, first[i]) < group[i]);
+        }
+    }
+}
+
+void sortIndexEntries(std::vector<IndexEntry>& entries) {
+    auto byKey = [](const IndexEntry& a, const IndexEntry& b) {
+        return a.key < b.key;
+    };
+    if (!std::is_sorted(entries.begin(), entries.end(), byKey)) {
+        std::stable_sort(entries.begin(), entries.end(), byKey);
+    }
+}
+
+/**
+ * @brief Sorts index entries gathered in several parts, one thread per part.
+ *
+ * Each merge round halves the number of runs; a run without a partner
+ * is carried over to the next round unchanged.
+ */
+void sortIndexEntryParts(std::vector<std::vector<IndexEntry>>& parts, std::vector<IndexEntry>& sorted) {
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < parts.size(); ++i) {
+        workers.push_back(std::thread(sortIndexEntries, std::ref(parts[i])));
+    }
+    if (!parts.empty()) {
+        sortIndexEntries(parts[0]);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    while (parts.size() > 1) {
+        std::vector<std::vector<IndexEntry>> merged((parts.size() + 1) / 2);
+        workers.clear();
+        for (size_t i = 0; i + 1 < parts.size(); i += 2) {
+            workers.push_back(std::thread([&parts, &merged, i]() {
+                std::vector<IndexEntry>& out = merged[i / 2];
+                out.resize(parts[i].size() + parts[i + 1].size());
+                std::merge(parts[i].begin(), parts[i].end(), parts[i + 1].begin(), parts[i + 1].end(), out.begin(),
+                           [](const IndexEntry& a, const IndexEntry& b) { return a.key < b.key; });
+                std::vector<IndexEntry>().swap(parts[i]);
+                std::vector<IndexEntry>().swap(parts[i + 1]);
+            }));
+        }
+        if (parts.size() % 2) {
+            merged.back().swap(parts.back());
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        parts.swap(merged);
+    }
+
+    sorted.clear();
+    if (!parts.empty()) {
+        sorted.swap(parts[0]);
+        parts.clear();
+    }
+}
+
+std::string encodeIndexHeader(const std::string& fileType, uint16_t version, uint32_t entryCount) {
+    uint32_t unpadded = static_cast<uint32_t>(fileType.size() + 1 + sizeof(version) + sizeof(uint32_t) + sizeof(entryCount));
+    uint32_t headerSize = (unpadded + 7) & ~7u;
+
+    std::string header(fileType.c_str(), fileType.size() + 1);  // Include null-terminator
+    header.append(reinterpret_cast<const char*>(&version), sizeof(version));
+    header.append(reinterpret_cast<const char*>(&headerSize), sizeof(headerSize));
+    header.append(reinterpret_cast<const char*>(&entryCount), sizeof(entryCount));
+    header.resize(headerSize, '\0');
+    return header;
+}
+
+uint32_t writeIndexHeader(SequentialWriter& writer, const std::string& fileType, uint16_t version, uint32_t entryCount) {
+    std::string header = encodeIndexHeader(fileType, version, entryCount);
+    writer.write(header.data(), header.size());
+    return static_cast<uint32_t>(header.size());
+}
+
+/**
+ * @brief Parses a binary index header from the start of a file.
+ *
+ * A binary header starts with a printable "ZipCode..." type name followed
+ * by a null byte; text indexes start with digits and never match.
+ */
+bool readIndexHeader(const char* data, uint64_t size, IndexFileHeader& header) {
+    const char prefix[] = "ZipCode";
+    if (size < sizeof(prefix) || std::memcmp(data, prefix, sizeof(prefix) - 1) != 0) {
+        return false;
+    }
+    const char* terminator = static_cast<const char*>(std::memchr(data, '\0', static_cast<size_t>(std::min<uint64_t>(size, 48))));
+    if (!terminator) {
+        return false;
+    }
+    size_t fieldsAt = terminator - data + 1;
+    if (size < fieldsAt + sizeof(uint16_t) + 2 * sizeof(uint32_t)) {
+        return false;
+    }
+
+    header.fileType.assign(data, terminator - data);
+    std::memcpy(&header.version, data + fieldsAt, sizeof(header.version));
+    std::memcpy(&header.headerSize, data + fieldsAt + sizeof(uint16_t), sizeof(header.headerSize));
+    std::memcpy(&header.entryCount, data + fieldsAt + sizeof(uint16_t) + sizeof(uint32_t), sizeof(header.entryCount));
+    return header.headerSize >= fieldsAt + sizeof(uint16_t) + 2 * sizeof(uint32_t) && header.headerSize <= size;
+}
@@ -0,0 +1,302 @@
+/**
+ * @file primary_key_index.h
+ * @brief Primary key index formats for the length-indicated data file.
+ *
+ * This file declares the PrimaryKeyIndex interface used by
+ * Buffer::searchPrimaryKey, the factory that opens an index file of any
+ * supported format, and the writer used by Buffer::createPrimaryKeyIndex.
+ * Two formats are provided here: the original text index ("zip offset"
+ * lines, scanned linearly) and a binary index of fixed-width entries
+ * sorted by numeric zip code, memory-mapped and binary searched. The
+ * other formats (B+ tree, direct-address, perfect hash, learned,
+ * Eytzinger, compressed) live in their own files and are opened through
+ * the same factory.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef PRIMARY_KEY_INDEX_H
+#define PRIMARY_KEY_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+
+/**
+ * @enum PrimaryIndexType
+ * @brief The on-disk formats createPrimaryKeyIndex can produce.
+ */
+enum class PrimaryIndexType {
+    Text,        /**< "zip offset" lines in data file order (the original format). */
+    Sorted,      /**< Fixed-width binary entries sorted by zip code. */
+    BPlusTree,   /**< Page-based B+ tree (see BPlusTreeIndex). */
+    Direct,      /**< Table of 100,000 offsets indexed by zip code (see DirectAddressIndex). */
+    PerfectHash, /**< Minimal perfect hash over the keys present (see PerfectHashIndex). */
+    Learned,     /**< Sorted keys searched with a piecewise linear model (see LearnedIndex). */
+    Eytzinger,   /**< Keys in breadth-first search tree order (see EytzingerIndex). */
+    Compressed,  /**< Elias-Fano keys and bit-packed offsets (see CompressedIndex). */
+    Sparse       /**< First key of each data block, for clustered data files (see SparseIndex). */
+};
+
+/**
+ * @struct IndexEntry
+ * @brief A zip code key and the file offset of its record.
+ */
+struct IndexEntry {
+    uint32_t key;      /**< Numeric zip code. */
+    uint64_t offset;   /**< Offset of the record's length prefix in the data file. */
+};
+
+/**
+ * @class IndexCursor
+ * @brief Forward iterator over index entries in key order.
+ *
+ * A cursor reads the index it was opened from, which must stay open while
+ * the cursor is in use.
+ */
+class IndexCursor {
+public:
+    typedef IndexEntry Entry;   /**< Type returned by next(). */
+
+    virtual ~IndexCursor() {}
+
+    /**
+     * @brief Moves to the next entry of the range.
+     * @param entry Receives the zip code and the record offset.
+     * @return false once the range is exhausted.
+     */
+    virtual bool next(IndexEntry& entry) = 0;
+};
+
+/**
+ * @struct IndexFileHeader
+ * @brief Header shared by the binary index formats.
+ *
+ * On disk the header is laid out like the data file header: the
+ * null-terminated file type, a 16-bit version, the 32-bit header size and
+ * a 32-bit entry count, padded with zeros to headerSize bytes.
+ */
+struct IndexFileHeader {
+    std::string fileType;  /**< Identifies the index format. */
+    uint16_t version;      /**< Format version. */
+    uint32_t headerSize;   /**< Offset of the index body. */
+    uint32_t entryCount;   /**< Number of keys in the index. */
+};
+
+/**
+ * @class PrimaryKeyIndex
+ * @brief An open primary key index that maps zip codes to record offsets.
+ */
+class PrimaryKeyIndex {
+public:
+    virtual ~PrimaryKeyIndex() {}
+
+    /**
+     * @brief Looks up a zip code.
+     *
+     * Hashed formats that keep only a fingerprint of each key can, rarely,
+     * return an offset for a zip code they do not contain; callers check
+     * the zip code of the record they read.
+     *
+     * @param key Numeric zip code.
+     * @return The record's file offset, or -1 if the zip code is not in the index.
+     */
+    virtual int64_t find(uint32_t key) const = 0;
+
+    /**
+     * @brief Looks up a batch of zip codes.
+     *
+     * The default calls find() once per key. The sorted and Eytzinger
+     * formats override it to advance the searches in lockstep, so the cache
+     * misses of different keys overlap instead of queueing one behind the
+     * other.
+     *
+     * @param keys Numeric zip codes.
+     * @param count Number of keys.
+     * @param offsets Receives, for each key, what find() would return.
+     */
+    virtual void findMany(const uint32_t* keys, size_t count, int64_t* offsets) const {
+        for (size_t i = 0; i < count; ++i) {
+            offsets[i] = find(keys[i]);
+        }
+    }
+
+    /**
+     * @brief Returns the number of keys in the index.
+     */
+    virtual size_t size() const = 0;
+
+    /**
+     * @brief Returns the format of the index.
+     */
+    virtual PrimaryIndexType type() const = 0;
+
+    /**
+     * @brief Opens a cursor over the zip codes in [low, high], in key order.
+     *
+     * Formats that keep their keys in order (sorted, B+ tree, direct,
+     * learned, Eytzinger, compressed, sparse) seek to low and walk forward; the
+     * text and perfect hash formats have no key order and return nullptr.
+     *
+     * @param low Smallest zip code of the range.
+     * @param high Largest zip code of the range.
+     * @return The cursor, or nullptr if the format cannot answer range queries.
+     */
+    virtual std::unique_ptr<IndexCursor> openRange(uint32_t low, uint32_t high) const {
+        (void)low; (void)high;
+        return nullptr;
+    }
+};
+
+/**
+ * @brief Converts a zip code string to its numeric key.
+ *
+ * Leading zeros are not significant, so "00501" and "501" give the same key.
+ *
+ * @param zipCode The zip code (1 to 9 decimal digits).
+ * @param key Receives the numeric key.
+ * @return false if the string is empty, too long or not all digits.
+ */
+bool parseZipKey(const std::string& zipCode, uint32_t& key);
+
+/**
+ * @brief Converts a zip code prefix to the range of keys it covers.
+ *
+ * A prefix of d digits stands for every five-digit zip code starting with
+ * it, so "563" covers 56300 to 56399 and "005" covers 500 to 599. A prefix
+ * of five or more digits is a single zip code.
+ *
+ * @param prefix The leading digits.
+ * @param low Receives the smallest key of the range.
+ * @param high Receives the largest key of the range.
+ * @return false if the prefix is empty, too long or not all digits.
+ */
+bool zipPrefixRange(const std::string& prefix, uint32_t& low, uint32_t& high);
+
+/**
+ * @brief Converts the zip code field at the start of a record to its numeric key.
+ *
+ * @param data The record bytes (without the length prefix).
+ * @param length Number of bytes in the record.
+ * @param key Receives the numeric key.
+ * @return false if the first field is not a valid zip code.
+ */
+bool parseRecordZipKey(const char* data, size_t length, uint32_t& key);
+
+/**
+ * @brief Binary searches an array for many keys at once.
+ *
+ * Each search is a branchless lower bound. Groups of kBatchSearchWidth
+ * searches take their steps in turn, and each step prefetches the element
+ * its search probes next, so by the time a search comes round again its
+ * cache line is usually loaded.
+ *
+ * @param base The first element; each element starts with its 32-bit key.
+ * @param stride Bytes from one element to the next.
+ * @param count Number of elements, sorted by key.
+ * @param queries Keys to search for.
+ * @param queryCount Number of queries.
+ * @param positions Receives, for each query, the position of the first key not less than it (count if none).
+ */
+void batchLowerBound(const char* base, size_t stride, size_t count,
+                     const uint32_t* queries, size_t queryCount, size_t* positions);
+
+/** Number of searches batchLowerBound and EytzingerLayout::lowerBoundMany keep in flight. */
+const size_t kBatchSearchWidth = 16;
+
+/**
+ * @brief Returns the name of an index type as accepted on the command line.
+ */
+const char* primaryIndexTypeName(PrimaryIndexType type);
+
+/**
+ * @brief Parses an index type name ("text", "sorted", ...).
+ * @return false if the name is not known.
+ */
+bool parsePrimaryIndexType(const std::string& name, PrimaryIndexType& type);
+
+/**
+ * @brief Opens a primary key index file of any supported format.
+ *
+ * The format is detected from the file's header; files without a binary
+ * header are treated as text indexes.
+ *
+ * @param filename The index file.
+ * @param dataFilename The data file the index describes; the sparse format reads it when searching.
+ * @return The open index, or nullptr if the file cannot be opened or is corrupt.
+ */
+std::unique_ptr<PrimaryKeyIndex> openPrimaryKeyIndex(const std::string& filename,
+                                                     const std::string& dataFilename = std::string());
+
+/**
+ * @brief Writes a primary key index file.
+ *
+ * @param filename The index file to create.
+ * @param entries The entries in data file order. Binary formats sort them by key.
+ * @param type The format to write.
+ * @param dataFilename The data file the entries describe; the sparse format names it if it is not clustered.
+ * @return true if the file was written.
+ */
+bool writePrimaryKeyIndex(const std::string& filename, std::vector<IndexEntry>& entries, PrimaryIndexType type,
+                          const std::string& dataFilename = std::string());
+
+/**
+ * @brief Stable-sorts index entries by key.
+ *
+ * Entries that are already in key order are left as they are after a
+ * single check, so writers can sort unconditionally.
+ *
+ * @param entries The entries; among equal keys the original order is kept.
+ */
+void sortIndexEntries(std::vector<IndexEntry>& entries);
+
+/**
+ * @brief Sorts index entries gathered in several parts, one thread per part.
+ *
+ * Each part is sorted on its own thread, then neighbouring parts are merged
+ * pairwise, also in parallel, until one sorted run remains. Ties are taken
+ * from the earlier part first, so the result is the same as stable-sorting
+ * the parts concatenated in order.
+ *
+ * @param parts The entries, in parts; emptied.
+ * @param sorted Receives every entry in key order.
+ */
+void sortIndexEntryParts(std::vector<std::vector<IndexEntry>>& parts, std::vector<IndexEntry>& sorted);
+
+/**
+ * @brief Builds a binary index header, padded to an 8-byte boundary.
+ *
+ * @param fileType The format name stored in the header.
+ * @param version The format version.
+ * @param entryCount Number of keys in the index.
+ * @return The header bytes; their length is the header size.
+ */
+std::string encodeIndexHeader(const std::string& fileType, uint16_t version, uint32_t entryCount);
+
+/**
+ * @brief Writes a binary index header, padded to an 8-byte boundary.
+ *
+ * @param writer Destination, positioned at the start of the file.
+ * @param fileType The format name stored in the header.
+ * @param version The format version.
+ * @param entryCount Number of keys in the index.
+ * @return The header size (the offset at which the body starts).
+ */
+uint32_t writeIndexHeader(SequentialWriter& writer, const std::string& fileType, uint16_t version, uint32_t entryCount);
+
+/**
+ * @brief Parses a binary index header from the start of a file.
+ *
+ * @param data The file contents.
+ * @param size Size of the file.
+ * @param header Receives the header fields.
+ * @return false if the file does not start with a binary index header.
+ */
+bool readIndexHeader(const char* data, uint64_t size, IndexFileHeader& header);
+
+#endif // PRIMARY_KEY_INDEX_H
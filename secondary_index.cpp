@@ -0,0 +1,119 @@
+/**
+ * @file secondary_index.cpp
+ * @brief Implementation of the numeric field registry and the SecondaryIndex class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "secondary_index.h"
+#include "buffer.h"
+#include "primary_key_index.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+const char SecondaryIndex::kFileType[] = "ZipCodeSecondaryIndex";
+const size_t SecondaryIndex::kFieldNameSize;
+
+namespace {
+
+// Field name and source stamp follow the index header
+const size_t kParametersSize = SecondaryIndex::kFieldNameSize + SourceStamp::kEncodedSize;
+
+double latitudeOf(const ZipCodeRecord& record) {
+    return record.latitude;
+}
+
+double longitudeOf(const ZipCodeRecord& record) {
+    return record.longitude;
+}
+
+bool byValue(const SecondaryEntry& a, const SecondaryEntry& b) {
+    return a.value < b.value;
+}
+
+} // namespace
+
+const std::vector<NumericField>& numericFields() {
+    static const std::vector<NumericField> fields = {
+        { "latitude", latitudeOf },
+        { "longitude", longitudeOf }
+    };
+    return fields;
+}
+
+const NumericField* findNumericField(const std::string& name) {
+    for (const auto& field : numericFields()) {
+        if (name == field.name) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+std::string secondaryIndexFilename(const std::string& field) {
+    return field + "_index.dat";
+}
+
+/**
+ * @brief Maps an existing secondary index file.
+ */
+bool SecondaryIndex::open(const std::string& filename) {
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != 1 ||
+        file.size() < header.headerSize + kParametersSize +
+                      static_cast<uint64_t>(header.entryCount) * sizeof(SecondaryEntry)) {
+        return false;
+    }
+    const char* name = file.data() + header.headerSize;
+    field.assign(name, strnlen(name, kFieldNameSize));
+    source.decode(name + kFieldNameSize);
+    count = header.entryCount;
+    entries = reinterpret_cast<const SecondaryEntry*>(name + kParametersSize);
+    return true;
+}
+
+SecondaryCursor SecondaryIndex::openRange(double low, double high) const {
+    const SecondaryEntry* end = entries + count;
+    SecondaryEntry bound;
+    bound.offset = 0;
+    bound.value = low;
+    const SecondaryEntry* first = std::lower_bound(entries, end, bound, byValue);
+    bound.value = high;
+    const SecondaryEntry* last = std::upper_bound(first, end, bound, byValue);
+    return SecondaryCursor(first, low <= high ? last : first);
+}
+
+bool SecondaryIndex::write(const std::string& filename, const std::string& field,
+                           std::vector<SecondaryEntry>& entries, const SourceStamp& source) {
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const SecondaryEntry& entry) {
+        return std::isnan(entry.value);
+    }), entries.end());
+    std::stable_sort(entries.begin(), entries.end(), byValue);
+
+    TemporaryFile temporary(filename);
+    std::unique_ptr<IoBackend> out = openIoBackend(temporary.getFilename(), IoWorkload::Write);
+    if (!out || field.size() >= kFieldNameSize) {
+        std::cerr << "Unable to write secondary index: " << filename << std::endl;
+        return false;
+    }
+    SequentialWriter writer(*out);
+    writeIndexHeader(writer, kFileType, 1, static_cast<uint32_t>(entries.size()));
+    char name[kFieldNameSize] = {};
+    std::memcpy(name, field.data(), field.size());
+    writer.write(name, sizeof(name));
+    char stamp[SourceStamp::kEncodedSize];
+    source.encode(stamp);
+    writer.write(stamp, sizeof(stamp));
+    writer.write(entries.data(), entries.size() * sizeof(SecondaryEntry));
+    if (!writer.finish()) {
+        std::cerr << "Error writing secondary index: " << filename << std::endl;
+        return false;
+    }
+    out.reset();
+    return temporary.commit();
+}
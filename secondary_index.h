@@ -0,0 +1,154 @@
+/**
+ * @file secondary_index.h
+ * @brief Header file for the numeric field registry and the SecondaryIndex class.
+ *
+ * Latitude- and longitude-ordered access used to mean sorting the records
+ * in memory again. A secondary index persists a numeric field's values
+ * sorted together with each record's offset in the data file, so a range
+ * such as "latitude between 44.0 and 45.0" is a contiguous run of entries.
+ * The fields that can be indexed are listed in a registry; adding a field
+ * there is enough to index it.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef SECONDARY_INDEX_H
+#define SECONDARY_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+#include "source_stamp.h"
+
+struct ZipCodeRecord;
+
+/**
+ * @struct NumericField
+ * @brief A numeric record field that secondary indexes can be built on.
+ */
+struct NumericField {
+    const char* name;                            /**< Name used on the command line and in file names. */
+    double (*value)(const ZipCodeRecord& record); /**< Reads the field from a record. */
+};
+
+/**
+ * @brief Returns every field secondary indexes can be built on.
+ */
+const std::vector<NumericField>& numericFields();
+
+/**
+ * @brief Finds a field by name.
+ * @return The field, or nullptr if no field has that name.
+ */
+const NumericField* findNumericField(const std::string& name);
+
+/**
+ * @brief Returns the file a field's secondary index is kept in ("<field>_index.dat").
+ */
+std::string secondaryIndexFilename(const std::string& field);
+
+/**
+ * @struct SecondaryEntry
+ * @brief A field value and the file offset of the record it came from.
+ */
+struct SecondaryEntry {
+    double value;      /**< The field's value. */
+    uint64_t offset;   /**< Offset of the record's length prefix in the data file. */
+};
+
+/**
+ * @class SecondaryCursor
+ * @brief Forward iterator over secondary index entries in value order.
+ *
+ * The cursor reads the index it was opened from, which must stay open
+ * while the cursor is in use.
+ */
+class SecondaryCursor {
+public:
+    typedef SecondaryEntry Entry;   /**< Type returned by next(). */
+
+    SecondaryCursor(const SecondaryEntry* first, const SecondaryEntry* last) : position(first), end(last) {}
+
+    /**
+     * @brief Moves to the next entry of the range.
+     * @param entry Receives the value and the record offset.
+     * @return false once the range is exhausted.
+     */
+    bool next(SecondaryEntry& entry) {
+        if (position == end) {
+            return false;
+        }
+        entry = *position++;
+        return true;
+    }
+
+private:
+    const SecondaryEntry* position;
+    const SecondaryEntry* end;
+};
+
+/**
+ * @class SecondaryIndex
+ * @brief Memory-mapped (value, record offset) entries of one numeric field, sorted by value.
+ *
+ * The file holds the binary index header, the field name (null padded to
+ * 16 bytes), the stamp of the CSV the index was generated from, and one
+ * 16-byte SecondaryEntry per record sorted by value, ties in data file
+ * order. A range query is two binary searches.
+ */
+class SecondaryIndex {
+public:
+    static const char kFileType[];            /**< File type stored in the index header. */
+    static const size_t kFieldNameSize = 16;  /**< Bytes for the field name, null padded. */
+
+    /**
+     * @brief Maps an existing secondary index file.
+     * @return false if the file cannot be mapped or is not a secondary index.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Opens a cursor over the entries with values in [low, high], in value order.
+     */
+    SecondaryCursor openRange(double low, double high) const;
+
+    /**
+     * @brief Returns the name of the indexed field.
+     */
+    const std::string& getField() const { return field; }
+
+    /**
+     * @brief Returns the number of entries in the index.
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief Returns the stamp of the CSV the index was generated from.
+     */
+    const SourceStamp& getSourceStamp() const { return source; }
+
+    /**
+     * @brief Writes a secondary index.
+     *
+     * @param filename The index file to create.
+     * @param field The name of the indexed field.
+     * @param entries The entries in data file order; sorted in place by value.
+     * @param source Stamp of the CSV the records came from.
+     * @return true if the file was written.
+     */
+    static bool write(const std::string& filename, const std::string& field,
+                      std::vector<SecondaryEntry>& entries, const SourceStamp& source);
+
+private:
+    MappedFile file;
+    const SecondaryEntry* entries = nullptr;
+    size_t count = 0;
+    std::string field;
+    SourceStamp source;
+};
+
+#endif // SECONDARY_INDEX_H
@@ -11,7 +11,7 @@ Get-Content ./main.cpp | Out-File -FilePath $outputFile -Append
 Add-Content $outputFile "`n--- Program Output ---`n"
 
 # Compile the C++ code
-g++ -std=c++11 -lstdc++ -o buffer_test main.cpp buffer.cpp
+g++ -std=c++11 -pthread -lstdc++ -o buffer_test main.cpp buffer.cpp data_file_reader.cpp io_backend.cpp async_record_fetcher.cpp block_cache.cpp batch_read_planner.cpp primary_key_index.cpp bplus_tree_index.cpp zip_hash_index.cpp direct_address_index.cpp perfect_hash_index.cpp learned_index.cpp eytzinger_index.cpp compressed_index.cpp bloom_filter.cpp source_stamp.cpp sparse_index.cpp covering_index.cpp state_zip_index.cpp secondary_index.cpp inverted_index.cpp place_name_index.cpp benchmark.cpp
 
 # Run the program and append the output to the same file
 ./buffer_test.exe | Out-File -FilePath $outputFile -Append
@@ -0,0 +1,99 @@
+/**
+ * @file source_stamp.cpp
+ * @brief Implementation of the SourceStamp helpers.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "source_stamp.h"
+#include "io_backend.h"
+#include <cstring>
+#include <sys/stat.h>
+
+const size_t SourceStamp::kEncodedSize;
+
+namespace {
+
+#ifdef _WIN32
+const bool kSubsecondTimes = false;
+#else
+const bool kSubsecondTimes = true;
+#endif
+
+// Modification time in nanoseconds, as precise as the platform reports it
+int64_t modifiedNanoseconds(const struct stat& info) {
+#if defined(_WIN32)
+    return static_cast<int64_t>(info.st_mtime) * 1000000000LL;
+#elif defined(__APPLE__)
+    return static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000LL + info.st_mtimespec.tv_nsec;
+#else
+    return static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+}
+
+} // namespace
+
+void SourceStamp::encode(char* out) const {
+    std::memcpy(out, &size, sizeof(size));
+    std::memcpy(out + sizeof(size), &modified, sizeof(modified));
+    std::memcpy(out + sizeof(size) + sizeof(modified), &hash, sizeof(hash));
+}
+
+void SourceStamp::decode(const char* in) {
+    std::memcpy(&size, in, sizeof(size));
+    std::memcpy(&modified, in + sizeof(size), sizeof(modified));
+    std::memcpy(&hash, in + sizeof(size) + sizeof(modified), sizeof(hash));
+}
+
+uint64_t fnv1a64(const char* data, size_t length) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Stamps a file as it is on disk.
+ *
+ * The file is mapped and hashed in one sequential pass.
+ */
+bool stampSourceFile(const std::string& filename, SourceStamp& stamp) {
+    int64_t modified;
+    if (!fileModifiedTime(filename, modified)) {
+        return false;
+    }
+    MappedFile file;
+    if (!file.open(filename, AccessPattern::Sequential)) {
+        return false;
+    }
+    stamp.size = file.size();
+    stamp.modified = modified;
+    stamp.hash = fnv1a64(file.data(), static_cast<size_t>(file.size()));
+    return true;
+}
+
+bool sourceMatchesStamp(const std::string& filename, const SourceStamp& recorded) {
+    struct stat info;
+    if (!recorded.isKnown() || ::stat(filename.c_str(), &info) != 0 ||
+        static_cast<uint64_t>(info.st_size) != recorded.size) {
+        return false;
+    }
+    if (kSubsecondTimes && modifiedNanoseconds(info) == recorded.modified) {
+        return true;
+    }
+    SourceStamp current;
+    return stampSourceFile(filename, current) && current.hash == recorded.hash;
+}
+
+bool fileModifiedTime(const std::string& filename, int64_t& modified) {
+    struct stat info;
+    if (::stat(filename.c_str(), &info) != 0) {
+        return false;
+    }
+    modified = modifiedNanoseconds(info);
+    return true;
+}
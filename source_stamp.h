@@ -0,0 +1,97 @@
+/**
+ * @file source_stamp.h
+ * @brief Identification of the source file that generated files were built from.
+ *
+ * The data file and the Bloom filter that accompanies the primary key
+ * index record the size, modification time and content hash of the CSV
+ * they were generated from. Comparing that stamp with the CSV on disk
+ * tells whether the generated files are current without rebuilding them.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef SOURCE_STAMP_H
+#define SOURCE_STAMP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @struct SourceStamp
+ * @brief Size, modification time and content hash of a source file.
+ *
+ * Stored in file headers as three 64-bit fields in this order. An all-zero
+ * stamp means "unknown" (files written before stamps existed) and never
+ * matches a real file.
+ */
+struct SourceStamp {
+    uint64_t size = 0;       /**< File size in bytes. */
+    int64_t modified = 0;    /**< Modification time in nanoseconds since the epoch. */
+    uint64_t hash = 0;       /**< 64-bit FNV-1a hash of the contents. */
+
+    static const size_t kEncodedSize = 3 * sizeof(uint64_t);   /**< Bytes used in a header. */
+
+    /**
+     * @brief Returns true if the stamp identifies a file.
+     */
+    bool isKnown() const { return hash != 0 || size != 0; }
+
+    bool operator==(const SourceStamp& other) const {
+        return size == other.size && modified == other.modified && hash == other.hash;
+    }
+    bool operator!=(const SourceStamp& other) const { return !(*this == other); }
+
+    /**
+     * @brief Writes the stamp's header fields to a buffer of kEncodedSize bytes.
+     */
+    void encode(char* out) const;
+
+    /**
+     * @brief Reads the stamp's header fields from a buffer of kEncodedSize bytes.
+     */
+    void decode(const char* in);
+};
+
+/**
+ * @brief Stamps a file as it is on disk.
+ *
+ * The size and modification time come from the file system; the hash is
+ * computed over the whole file.
+ *
+ * @param filename The source file.
+ * @param stamp Receives the stamp.
+ * @return false if the file cannot be read.
+ */
+bool stampSourceFile(const std::string& filename, SourceStamp& stamp);
+
+/**
+ * @brief Checks whether a file is still the one a stamp was taken from.
+ *
+ * A different size means the file changed. With the same size and the
+ * same modification time, to the nanosecond, the file is taken as
+ * unchanged without reading it; otherwise (for example after a copy that
+ * reset the time) the contents are hashed and compared. Where the file
+ * system reports only whole seconds, which would miss a rewrite within
+ * the same second, the contents are always hashed.
+ *
+ * @param filename The source file.
+ * @param recorded The stamp stored when the generated files were written.
+ * @return true if the file matches the stamp.
+ */
+bool sourceMatchesStamp(const std::string& filename, const SourceStamp& recorded);
+
+/**
+ * @brief Returns a file's modification time in nanoseconds since the epoch.
+ * @return false if the file does not exist.
+ */
+bool fileModifiedTime(const std::string& filename, int64_t& modified);
+
+/**
+ * @brief Hashes a block of memory with 64-bit FNV-1a.
+ */
+uint64_t fnv1a64(const char* data, size_t length);
+
+#endif // SOURCE_STAMP_H
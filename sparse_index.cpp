@@ -0,0 +1,188 @@
+/**
+ * @file sparse_index.cpp
+ * @brief Implementation of the SparseIndex class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "sparse_index.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+const char SparseIndex::kFileType[] = "ZipCodeSparseIndex";
+const uint32_t SparseIndex::kBlockSize;
+
+namespace {
+
+// Block size and padding follow the index header
+const size_t kParametersSize = 2 * sizeof(uint32_t);
+const uint16_t kVersion = 2;   // Version 2 no longer stores the data file name
+
+} // namespace
+
+/**
+ * @class SparseIndex::RangeCursor
+ * @brief Walks the records of consecutive blocks until a zip code exceeds the range.
+ */
+class SparseIndex::RangeCursor : public IndexCursor {
+public:
+    RangeCursor(const SparseIndex& owner, size_t block, uint32_t low, uint32_t high)
+        : index(owner), block(block), low(low), high(high), position(0), done(low > high || owner.count == 0) {}
+
+    bool next(IndexEntry& entry) override {
+        while (!done) {
+            if (position + sizeof(uint32_t) > bytes.size()) {
+                // Move on to the next block (the first call loads the starting one)
+                if (started && ++block >= index.count) {
+                    done = true;
+                    break;
+                }
+                started = true;
+                position = 0;
+                if (!index.readBlock(block, bytes)) {
+                    done = true;
+                    break;
+                }
+                continue;
+            }
+            uint32_t recordLength;
+            std::memcpy(&recordLength, bytes.data() + position, sizeof(recordLength));
+            size_t recordAt = position;
+            position += sizeof(uint32_t) + recordLength;
+            if (position > bytes.size() ||
+                !parseRecordZipKey(bytes.data() + recordAt + sizeof(uint32_t), recordLength, entry.key)) {
+                continue;
+            }
+            if (entry.key > high) {
+                done = true;
+                break;
+            }
+            if (entry.key >= low) {
+                entry.offset = index.offsets[block] + recordAt;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    const SparseIndex& index;
+    size_t block;
+    uint32_t low;
+    uint32_t high;
+    std::vector<char> bytes;   /**< The current block. */
+    size_t position;           /**< Next record in bytes. */
+    bool started = false;      /**< The starting block has been read. */
+    bool done;
+};
+
+/**
+ * @brief Maps an existing sparse index file and opens the data file it describes.
+ */
+bool SparseIndex::open(const std::string& filename, const std::string& dataFilename) {
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != kVersion ||
+        file.size() < header.headerSize + kParametersSize +
+                      static_cast<uint64_t>(header.entryCount) * (sizeof(uint64_t) + sizeof(uint32_t))) {
+        return false;
+    }
+    data = openIoBackend(dataFilename, IoWorkload::Lookup);
+    if (!data) {
+        std::cerr << "Unable to open data file of sparse index: " << dataFilename << std::endl;
+        return false;
+    }
+    count = header.entryCount;
+    offsets = reinterpret_cast<const uint64_t*>(file.data() + header.headerSize + kParametersSize);
+    keys = reinterpret_cast<const uint32_t*>(offsets + count);
+    dataSize = data->size();
+    return count == 0 || offsets[count - 1] < dataSize;
+}
+
+bool SparseIndex::readBlock(size_t block, std::vector<char>& bytes) const {
+    uint64_t end = block + 1 < count ? offsets[block + 1] : dataSize;
+    bytes.resize(static_cast<size_t>(end - offsets[block]));
+    long long got = data->readAt(bytes.data(), bytes.size(), offsets[block]);
+    return got == static_cast<long long>(bytes.size());
+}
+
+/**
+ * @brief Looks up a zip code by scanning the one block that can hold it.
+ *
+ * Records are in key order, so the scan stops at the first larger key.
+ */
+int64_t SparseIndex::find(uint32_t key) const {
+    const uint32_t* after = std::upper_bound(keys, keys + count, key);
+    if (after == keys) {
+        return -1;
+    }
+    size_t block = static_cast<size_t>(after - keys) - 1;
+
+    thread_local std::vector<char> bytes;
+    if (!readBlock(block, bytes)) {
+        return -1;
+    }
+    size_t position = 0;
+    while (position + sizeof(uint32_t) <= bytes.size()) {
+        uint32_t recordLength;
+        std::memcpy(&recordLength, bytes.data() + position, sizeof(recordLength));
+        const char* body = bytes.data() + position + sizeof(uint32_t);
+        if (position + sizeof(uint32_t) + recordLength > bytes.size()) {
+            break;
+        }
+        uint32_t recordKey;
+        if (parseRecordZipKey(body, recordLength, recordKey)) {
+            if (recordKey == key) {
+                return static_cast<int64_t>(offsets[block] + position);
+            }
+            if (recordKey > key) {
+                break;
+            }
+        }
+        position += sizeof(uint32_t) + recordLength;
+    }
+    return -1;
+}
+
+std::unique_ptr<IndexCursor> SparseIndex::openRange(uint32_t low, uint32_t high) const {
+    const uint32_t* after = std::upper_bound(keys, keys + count, low);
+    size_t block = after == keys ? 0 : static_cast<size_t>(after - keys) - 1;
+    return std::unique_ptr<IndexCursor>(new RangeCursor(*this, block, low, high));
+}
+
+/**
+ * @brief Writes a sparse index.
+ *
+ * Sorting by key keeps equal keys in data file order, so the data file is
+ * clustered exactly when the offsets then increase throughout. A new block
+ * starts at the first record at least kBlockSize bytes past the start of
+ * the current one whose key differs from the record before it.
+ */
+bool SparseIndex::write(SequentialWriter& writer, std::vector<IndexEntry>& entries, const std::string& dataFilename) {
+    sortIndexEntries(entries);
+    for (size_t i = 1; i < entries.size(); ++i) {
+        if (entries[i].offset <= entries[i - 1].offset) {
+            std::cerr << "The sparse index needs a data file clustered by zip code; "
+                      << "generate " << dataFilename << " with -cluster." << std::endl;
+            return false;
+        }
+    }
+    std::vector<uint64_t> blockOffsets;
+    std::vector<uint32_t> blockKeys;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (blockOffsets.empty() ||
+            (entries[i].offset >= blockOffsets.back() + kBlockSize && entries[i].key != entries[i - 1].key)) {
+            blockOffsets.push_back(entries[i].offset);
+            blockKeys.push_back(entries[i].key);
+        }
+    }
+
+    writeIndexHeader(writer, kFileType, kVersion, static_cast<uint32_t>(blockOffsets.size()));
+    uint32_t parameters[2] = { kBlockSize, 0 };
+    writer.write(parameters, sizeof(parameters));
+    writer.write(blockOffsets.data(), blockOffsets.size() * sizeof(uint64_t));
+    return writer.write(blockKeys.data(), blockKeys.size() * sizeof(uint32_t));
+}
@@ -0,0 +1,102 @@
+/**
+ * @file sparse_index.h
+ * @brief Header file for the SparseIndex class.
+ *
+ * A dense index stores one entry per record. When the data file is
+ * clustered by zip code (generated with -cluster) the records are already
+ * in key order, so it is enough to know the first zip code of each block
+ * of the data file: a lookup finds the block that can hold the key and
+ * scans that block alone, read with a single I/O.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef SPARSE_INDEX_H
+#define SPARSE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+#include "primary_key_index.h"
+
+/**
+ * @class SparseIndex
+ * @brief Memory-mapped block-level primary key index over a data file clustered by zip code.
+ *
+ * The data file is cut into blocks of about kBlockSize bytes at record
+ * boundaries, never between two records with the same zip code. The index
+ * file holds the binary index header and the block size, then the offset
+ * of each block's first record and, after them, that record's zip code.
+ * The data file is not named in the index; whoever opens the index passes
+ * it in, as for every other format.
+ * A lookup binary searches the zip codes for the last block starting at or
+ * before the key, reads the block from the data file with one positional
+ * read and walks its length prefixes.
+ */
+class SparseIndex : public PrimaryKeyIndex {
+public:
+    static const char kFileType[];                   /**< File type stored in the index header. */
+    static const uint32_t kBlockSize = 4096;         /**< Target data bytes per block. */
+
+    /**
+     * @brief Maps an existing sparse index file and opens the data file it describes.
+     * @param filename The index file.
+     * @param dataFilename The data file the index was built over.
+     * @return false if either file cannot be opened or the index is not a sparse index.
+     */
+    bool open(const std::string& filename, const std::string& dataFilename);
+
+    /**
+     * @brief Looks up a zip code by scanning the one block that can hold it.
+     * @return The record's file offset, or -1 if the zip code is not in the data file.
+     */
+    int64_t find(uint32_t key) const override;
+
+    /**
+     * @brief Returns the number of blocks (entries) in the index.
+     */
+    size_t size() const override { return count; }
+
+    /**
+     * @brief Returns PrimaryIndexType::Sparse.
+     */
+    PrimaryIndexType type() const override { return PrimaryIndexType::Sparse; }
+
+    /**
+     * @brief Opens a cursor that reads blocks in order from the one holding low.
+     */
+    std::unique_ptr<IndexCursor> openRange(uint32_t low, uint32_t high) const override;
+
+    /**
+     * @brief Writes a sparse index.
+     *
+     * @param writer Destination, positioned at the start of the file.
+     * @param entries One entry per record; sorted in place by key.
+     * @param dataFilename The data file the entries describe, named in the error if it is not clustered.
+     * @return false if the data file is not clustered by zip code, or a write fails.
+     */
+    static bool write(SequentialWriter& writer, std::vector<IndexEntry>& entries, const std::string& dataFilename);
+
+private:
+    class RangeCursor;
+
+    /**
+     * @brief Reads block i of the data file.
+     * @return false if the read failed.
+     */
+    bool readBlock(size_t block, std::vector<char>& bytes) const;
+
+    MappedFile file;
+    std::unique_ptr<IoBackend> data;   /**< The data file the blocks are read from. */
+    uint64_t dataSize = 0;             /**< End of the last block. */
+    const uint64_t* offsets = nullptr; /**< Offset of each block's first record. */
+    const uint32_t* keys = nullptr;    /**< Zip code of each block's first record. */
+    size_t count = 0;
+};
+
+#endif // SPARSE_INDEX_H
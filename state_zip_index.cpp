@@ -0,0 +1,202 @@
+/**
+ * @file state_zip_index.cpp
+ * @brief Implementation of the StateZipIndex class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "state_zip_index.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+const char StateZipIndex::kFileType[] = "ZipCodeStateZipIndex";
+const size_t StateZipIndex::kStateNameSize;
+const size_t StateZipIndex::kDirectorySlotSize;
+const size_t StateZipIndex::kEntrySize;
+
+namespace {
+
+// State count, padding and source stamp follow the index header
+const size_t kParametersSize = 2 * sizeof(uint32_t) + SourceStamp::kEncodedSize;
+
+} // namespace
+
+/**
+ * @class StateZipIndex::RangeCursor
+ * @brief Walks one state's packed entries forward until a zip code exceeds the range.
+ */
+class StateZipIndex::RangeCursor : public IndexCursor {
+public:
+    RangeCursor(const char* entries, size_t position, size_t end, uint32_t high)
+        : entries(entries), position(position), end(end), high(high) {}
+
+    bool next(IndexEntry& entry) override {
+        if (position >= end) {
+            return false;
+        }
+        const char* packed = entries + position * kEntrySize;
+        std::memcpy(&entry.key, packed, sizeof(entry.key));
+        if (entry.key > high) {
+            position = end;
+            return false;
+        }
+        std::memcpy(&entry.offset, packed + sizeof(entry.key), sizeof(entry.offset));
+        ++position;
+        return true;
+    }
+
+private:
+    const char* entries;
+    size_t position;
+    size_t end;       /**< One past the state's last entry. */
+    uint32_t high;
+};
+
+/**
+ * @brief Maps an existing state/zip index file.
+ */
+bool StateZipIndex::open(const std::string& filename) {
+    IndexFileHeader header;
+    if (!file.open(filename) || !readIndexHeader(file.data(), file.size(), header) ||
+        header.fileType != kFileType || header.version != 1 ||
+        file.size() < header.headerSize + kParametersSize) {
+        return false;
+    }
+    uint32_t states;
+    std::memcpy(&states, file.data() + header.headerSize, sizeof(states));
+    uint64_t directoryAt = header.headerSize + kParametersSize;
+    uint64_t entriesAt = directoryAt + static_cast<uint64_t>(states) * kDirectorySlotSize;
+    if (file.size() < entriesAt + static_cast<uint64_t>(header.entryCount) * kEntrySize) {
+        return false;
+    }
+    source.decode(file.data() + header.headerSize + 2 * sizeof(uint32_t));
+    stateCount = states;
+    count = header.entryCount;
+    directory = file.data() + directoryAt;
+    entries = file.data() + entriesAt;
+    return true;
+}
+
+const char* StateZipIndex::findState(const std::string& state) const {
+    if (state.empty() || state.size() >= kStateNameSize) {
+        return nullptr;
+    }
+    char name[kStateNameSize] = {};
+    std::memcpy(name, state.data(), state.size());
+    size_t low = 0;
+    size_t high = stateCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        int order = std::memcmp(directory + middle * kDirectorySlotSize, name, kStateNameSize);
+        if (order == 0) {
+            return directory + middle * kDirectorySlotSize;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<IndexCursor> StateZipIndex::openRange(const std::string& state, uint32_t low, uint32_t high) const {
+    const char* slot = findState(state);
+    uint32_t first = 0;
+    uint32_t stateEntries = 0;
+    if (slot && low <= high) {
+        std::memcpy(&first, slot + kStateNameSize, sizeof(first));
+        std::memcpy(&stateEntries, slot + kStateNameSize + sizeof(first), sizeof(stateEntries));
+        if (static_cast<uint64_t>(first) + stateEntries > count) {
+            stateEntries = 0;
+        }
+    }
+
+    // Binary search the state's entries for the first zip code not less than low
+    size_t begin = first;
+    size_t end = static_cast<size_t>(first) + stateEntries;
+    size_t searchEnd = end;
+    while (begin < searchEnd) {
+        size_t middle = begin + (searchEnd - begin) / 2;
+        uint32_t key;
+        std::memcpy(&key, entries + middle * kEntrySize, sizeof(key));
+        if (key < low) {
+            begin = middle + 1;
+        } else {
+            searchEnd = middle;
+        }
+    }
+    return std::unique_ptr<IndexCursor>(new RangeCursor(entries, begin, end, high));
+}
+
+std::vector<std::string> StateZipIndex::states() const {
+    std::vector<std::string> names;
+    names.reserve(stateCount);
+    for (size_t i = 0; i < stateCount; ++i) {
+        const char* name = directory + i * kDirectorySlotSize;
+        names.push_back(std::string(name, strnlen(name, kStateNameSize)));
+    }
+    return names;
+}
+
+bool StateZipIndex::write(const std::string& filename, std::vector<StateZipEntry>& entries, const SourceStamp& source) {
+    for (auto& entry : entries) {
+        if (entry.state.size() >= kStateNameSize) {
+            entry.state.resize(kStateNameSize - 1);
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const StateZipEntry& a, const StateZipEntry& b) {
+        return a.state != b.state ? a.state < b.state : a.key < b.key;
+    });
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const StateZipEntry& a, const StateZipEntry& b) {
+        return a.state == b.state && a.key == b.key;
+    }), entries.end());
+
+    TemporaryFile temporary(filename);
+    std::unique_ptr<IoBackend> out = openIoBackend(temporary.getFilename(), IoWorkload::Write);
+    if (!out) {
+        std::cerr << "Unable to write state/zip index: " << filename << std::endl;
+        return false;
+    }
+
+    // One directory slot per run of entries with the same state
+    std::string directory;
+    uint32_t states = 0;
+    for (size_t first = 0; first < entries.size();) {
+        size_t last = first;
+        while (last < entries.size() && entries[last].state == entries[first].state) {
+            ++last;
+        }
+        char slot[kDirectorySlotSize] = {};
+        std::memcpy(slot, entries[first].state.data(), entries[first].state.size());
+        uint32_t position = static_cast<uint32_t>(first);
+        uint32_t stateEntries = static_cast<uint32_t>(last - first);
+        std::memcpy(slot + kStateNameSize, &position, sizeof(position));
+        std::memcpy(slot + kStateNameSize + sizeof(position), &stateEntries, sizeof(stateEntries));
+        directory.append(slot, sizeof(slot));
+        ++states;
+        first = last;
+    }
+
+    SequentialWriter writer(*out);
+    writeIndexHeader(writer, kFileType, 1, static_cast<uint32_t>(entries.size()));
+    uint32_t parameters[2] = { states, 0 };
+    writer.write(parameters, sizeof(parameters));
+    char stamp[SourceStamp::kEncodedSize];
+    source.encode(stamp);
+    writer.write(stamp, sizeof(stamp));
+    writer.write(directory.data(), directory.size());
+    for (const auto& entry : entries) {
+        writer.write(&entry.key, sizeof(entry.key));
+        writer.write(&entry.offset, sizeof(entry.offset));
+    }
+    if (!writer.finish()) {
+        std::cerr << "Error writing state/zip index: " << filename << std::endl;
+        return false;
+    }
+    out.reset();
+    return temporary.commit();
+}
@@ -0,0 +1,114 @@
+/**
+ * @file state_zip_index.h
+ * @brief Header file for the StateZipIndex class.
+ *
+ * Listing a state's zip codes used to mean loading the whole CSV, grouping
+ * the records by state and sorting each group. The state/zip index keeps
+ * the record offsets sorted by (state, zip code) on disk, so all zip codes
+ * of a state, in zip code order, are one contiguous range of entries.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef STATE_ZIP_INDEX_H
+#define STATE_ZIP_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "io_backend.h"
+#include "primary_key_index.h"
+#include "source_stamp.h"
+
+/**
+ * @struct StateZipEntry
+ * @brief A record's state, zip code and file offset, as collected for StateZipIndex::write.
+ */
+struct StateZipEntry {
+    std::string state;   /**< State abbreviation. */
+    uint32_t key;        /**< Numeric zip code. */
+    uint64_t offset;     /**< Offset of the record's length prefix in the data file. */
+};
+
+/**
+ * @class StateZipIndex
+ * @brief Memory-mapped composite index on (state, zip code).
+ *
+ * The file holds the binary index header, the state count, the stamp of
+ * the CSV the index was generated from, a directory with one 16-byte slot
+ * per state (the name, null padded to 8 bytes, then the position and
+ * number of its entries) sorted by name, and the entries: the zip code and
+ * record offset packed in 12 bytes, grouped by state and sorted by zip
+ * code within each state. A state is found by binary search over the
+ * directory and its zip codes in a range by binary search within its group.
+ */
+class StateZipIndex {
+public:
+    static const char kFileType[];   /**< File type stored in the index header. */
+
+    /**
+     * @brief Maps an existing state/zip index file.
+     * @return false if the file cannot be mapped or is not a state/zip index.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Opens a cursor over a state's zip codes in [low, high], in zip code order.
+     *
+     * @param state State abbreviation; an unknown state gives an empty cursor.
+     * @param low Smallest zip code of the range.
+     * @param high Largest zip code of the range.
+     */
+    std::unique_ptr<IndexCursor> openRange(const std::string& state, uint32_t low, uint32_t high) const;
+
+    /**
+     * @brief Returns the states in the index, in name order.
+     */
+    std::vector<std::string> states() const;
+
+    /**
+     * @brief Returns the number of entries in the index.
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief Returns the stamp of the CSV the index was generated from.
+     */
+    const SourceStamp& getSourceStamp() const { return source; }
+
+    /**
+     * @brief Writes a state/zip index.
+     *
+     * @param filename The index file to create.
+     * @param entries The entries in data file order; sorted in place by (state, zip code),
+     *                keeping the first of any duplicate pairs.
+     * @param source Stamp of the CSV the records came from.
+     * @return true if the file was written.
+     */
+    static bool write(const std::string& filename, std::vector<StateZipEntry>& entries, const SourceStamp& source);
+
+private:
+    class RangeCursor;
+
+    /**
+     * @brief Returns the directory slot of a state, or nullptr if it is not in the index.
+     */
+    const char* findState(const std::string& state) const;
+
+    static const size_t kStateNameSize = 8;    /**< Bytes per state name, null padded. */
+    static const size_t kDirectorySlotSize = kStateNameSize + 2 * sizeof(uint32_t);
+    static const size_t kEntrySize = sizeof(uint32_t) + sizeof(uint64_t);
+
+    MappedFile file;
+    const char* directory = nullptr;
+    const char* entries = nullptr;
+    size_t stateCount = 0;
+    size_t count = 0;
+    SourceStamp source;
+};
+
+#endif // STATE_ZIP_INDEX_H
@@ -0,0 +1,135 @@
+/**
+ * @file zip_hash_index.cpp
+ * @brief Implementation of the ZipHashIndex class.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#include "zip_hash_index.h"
+#include <algorithm>
+
+const size_t ZipHashIndex::kBucketEntries;
+const uint32_t ZipHashIndex::kEmptyKey;
+
+namespace {
+
+const size_t kCacheLine = 64;
+
+} // namespace
+
+ZipHashIndex::ZipHashIndex() : buckets(nullptr), bucketCount(0), shift(32), count(0) {}
+
+void ZipHashIndex::clear() {
+    std::vector<char>().swap(memory);
+    buckets = nullptr;
+    bucketCount = 0;
+    shift = 32;
+    count = 0;
+}
+
+/**
+ * @brief Grows the table so that count keys fit without rehashing.
+ *
+ * The table is sized for a load of at most three quarters, rounded up to a
+ * power of two buckets.
+ */
+void ZipHashIndex::reserve(size_t keys) {
+    size_t needed = (keys * 4 / 3 + kBucketEntries - 1) / kBucketEntries;
+    size_t buckets = 1;
+    while (buckets < needed) {
+        buckets <<= 1;
+    }
+    if (buckets > bucketCount) {
+        rehash(buckets);
+    }
+}
+
+/**
+ * @brief Adds a key, probing from its home bucket to the first free entry.
+ */
+bool ZipHashIndex::insert(uint32_t key, uint32_t slot) {
+    if (key == kEmptyKey) {
+        return false;
+    }
+    if ((count + 1) * 4 > bucketCount * kBucketEntries * 3) {
+        rehash(bucketCount ? bucketCount * 2 : 1);
+    }
+
+    for (size_t b = bucketFor(key);; b = (b + 1) & (bucketCount - 1)) {
+        Bucket& bucket = buckets[b];
+        for (size_t i = 0; i < kBucketEntries; ++i) {
+            if (bucket.keys[i] == key) {
+                return false;
+            }
+            if (bucket.keys[i] == kEmptyKey) {
+                bucket.keys[i] = key;
+                bucket.slots[i] = slot;
+                ++count;
+                return true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Looks up a key.
+ *
+ * Entries fill a bucket from the front and nothing is ever removed, so the
+ * first empty key ends the probe sequence.
+ */
+bool ZipHashIndex::find(uint32_t key, uint32_t& slot) const {
+    if (count == 0 || key == kEmptyKey) {
+        return false;
+    }
+    for (size_t b = bucketFor(key);; b = (b + 1) & (bucketCount - 1)) {
+        const Bucket& bucket = buckets[b];
+        for (size_t i = 0; i < kBucketEntries; ++i) {
+            if (bucket.keys[i] == key) {
+                slot = bucket.slots[i];
+                return true;
+            }
+            if (bucket.keys[i] == kEmptyKey) {
+                return false;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Fibonacci hashing: the top bits of key * 2^32/phi pick the bucket.
+ *
+ * Zip codes are dense runs of small integers; the multiplication spreads
+ * neighbouring keys across the table instead of packing them into the same
+ * few buckets.
+ */
+size_t ZipHashIndex::bucketFor(uint32_t key) const {
+    return shift >= 32 ? 0 : static_cast<size_t>((key * 2654435769u) >> shift);
+}
+
+void ZipHashIndex::rehash(size_t newBucketCount) {
+    std::vector<char> oldMemory;
+    oldMemory.swap(memory);
+    Bucket* oldBuckets = buckets;
+    size_t oldBucketCount = bucketCount;
+
+    memory.resize(newBucketCount * sizeof(Bucket) + kCacheLine);
+    uintptr_t address = reinterpret_cast<uintptr_t>(memory.data());
+    buckets = reinterpret_cast<Bucket*>((address + kCacheLine - 1) & ~static_cast<uintptr_t>(kCacheLine - 1));
+    bucketCount = newBucketCount;
+    shift = 32;
+    for (size_t n = newBucketCount; n > 1; n >>= 1) {
+        --shift;
+    }
+    for (size_t b = 0; b < bucketCount; ++b) {
+        std::fill(buckets[b].keys, buckets[b].keys + kBucketEntries, kEmptyKey);
+    }
+
+    count = 0;
+    for (size_t b = 0; b < oldBucketCount; ++b) {
+        for (size_t i = 0; i < kBucketEntries && oldBuckets[b].keys[i] != kEmptyKey; ++i) {
+            insert(oldBuckets[b].keys[i], oldBuckets[b].slots[i]);
+        }
+    }
+}
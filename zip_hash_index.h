@@ -0,0 +1,98 @@
+/**
+ * @file zip_hash_index.h
+ * @brief Header file for the ZipHashIndex class.
+ *
+ * The ZipHashIndex maps numeric zip codes to the position of their record
+ * in the Buffer's in-memory record list. It is an open-addressing hash
+ * table whose buckets are exactly one 64-byte cache line: eight keys
+ * followed by their eight record slots. A lookup hashes the key to a
+ * bucket and compares the keys stored there, so a hit or a miss usually
+ * touches a single cache line, plus one more when a full bucket spills
+ * into the next.
+ *
+ * @version 1.0
+ * @date 2026-10-16
+ * @author Samuel Cloutier
+ */
+
+#ifndef ZIP_HASH_INDEX_H
+#define ZIP_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class ZipHashIndex
+ * @brief Open-addressing hash table from zip code keys to record slots.
+ *
+ * Full buckets overflow into the following bucket (linear probing over
+ * buckets). The table doubles once it is three quarters full, so probe
+ * sequences stay short. Keys are never removed individually; clear() drops
+ * them all.
+ */
+class ZipHashIndex {
+public:
+    static const size_t kBucketEntries = 8;   /**< Keys per 64-byte bucket. */
+
+    ZipHashIndex();
+
+    /**
+     * @brief Removes every key and releases the table.
+     */
+    void clear();
+
+    /**
+     * @brief Grows the table so that count keys fit without rehashing.
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Adds a key.
+     * @param key Numeric zip code.
+     * @param slot Position of the record in the record list.
+     * @return false if the key is already present (its slot is kept).
+     */
+    bool insert(uint32_t key, uint32_t slot);
+
+    /**
+     * @brief Looks up a key.
+     * @param key Numeric zip code.
+     * @param slot Receives the record position if the key is present.
+     * @return true if the key is present.
+     */
+    bool find(uint32_t key, uint32_t& slot) const;
+
+    /**
+     * @brief Returns the number of keys in the table.
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief Returns the bytes used by the buckets.
+     */
+    size_t memoryUsage() const { return bucketCount * sizeof(Bucket); }
+
+private:
+    /**
+     * @struct Bucket
+     * @brief One cache line of keys and slots. Unused keys hold kEmptyKey.
+     */
+    struct Bucket {
+        uint32_t keys[kBucketEntries];
+        uint32_t slots[kBucketEntries];
+    };
+
+    static const uint32_t kEmptyKey = 0xFFFFFFFFu;  /**< Larger than any 9-digit zip code. */
+
+    size_t bucketFor(uint32_t key) const;
+    void rehash(size_t buckets);
+
+    std::vector<char> memory;   /**< Backing store, over-allocated so buckets can start on a cache line. */
+    Bucket* buckets;            /**< Cache-line-aligned view of memory. */
+    size_t bucketCount;         /**< Always a power of two (or zero). */
+    unsigned shift;             /**< 32 - log2(bucketCount), for the multiplicative hash. */
+    size_t count;               /**< Keys in the table. */
+};
+
+#endif // ZIP_HASH_INDEX_H